@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "SessionState.h"
+#include "SessionActions.h"
+#include "Varint.h"
+
+/**
+ * Compact log of the semantic actions taken in a session
+ * Every entry is a single varint (argument << 2 | opcode): opcode 0 moves
+ * through door `argument` of the current room and opcodes 1-3 apply
+ * ActionType(opcode) to entity `argument` of the current room, so any index
+ * below 32 takes one byte. Replaying applies the entries straight to a
+ * SessionState without menus, parsing or output, and gives the same result
+ * as the session that was recorded when started from the same dungeon and
+ * player.
+ *
+ * Journal files are the magic "DJNL", then varints for the version, the
+ * entry count and the entries. Loading validates every entry against the
+ * dungeon and player the journal is for, by replaying it into a scratch
+ * session: each move must take an existing, unlocked door and each action
+ * must name an entity of the current room, and no entry may follow the
+ * player's death. Malformed input throws std::runtime_error.
+ */
+class ActionJournal {
+public:
+    static constexpr char kMagic[4] = {'D', 'J', 'N', 'L'};
+    static constexpr uint64_t kVersion = 1;
+
+private:
+    static constexpr uint64_t kMove = 0;
+    static constexpr unsigned kOpcodeBits = 2;
+
+    std::vector<uint8_t> fEntries;
+    size_t fEntryCount = 0;
+
+    void append(uint64_t aArgument, uint64_t aOpcode) {
+        Varint::append(fEntries, aArgument << kOpcodeBits | aOpcode);
+        ++fEntryCount;
+    }
+
+    // Apply one entry; false if it names no door that can be taken or no
+    // entity of the current room
+    static bool apply(SessionState& aState, uint64_t aEntry) {
+        uint64_t opcode = aEntry & ((1u << kOpcodeBits) - 1);
+        size_t argument = static_cast<size_t>(aEntry >> kOpcodeBits);
+        if (opcode == kMove) {
+            return aState.move(argument);
+        }
+        return performAction(aState, argument, static_cast<ActionType>(opcode));
+    }
+
+    void validate(const Dungeon& aDungeon, const Player& aPlayer, const std::string& aPath) const {
+        SessionState state(aDungeon, aPlayer);
+        Varint::Reader reader(fEntries.data(), fEntries.size());
+        for (size_t i = 0; i < fEntryCount; ++i) {
+            if (!state.getPlayer().isAlive()) {
+                throw std::runtime_error("ActionJournal: entries after the player died in " + aPath);
+            }
+            if (!apply(state, reader.read())) {
+                throw std::runtime_error("ActionJournal: invalid entry " + std::to_string(i) + " in " + aPath);
+            }
+        }
+    }
+
+public:
+    void recordMove(size_t aDoorIndex) { append(aDoorIndex, kMove); }
+
+    void recordAction(size_t aEntityIndex, ActionType aAction) {
+        append(aEntityIndex, static_cast<uint64_t>(aAction));
+    }
+
+    void clear() {
+        fEntries.clear();
+        fEntryCount = 0;
+    }
+
+    size_t getEntryCount() const { return fEntryCount; }
+    const std::vector<uint8_t>& getEntries() const { return fEntries; }
+
+    // Apply the entries in order, stopping early if the player dies
+    // Returns the number of entries applied
+    size_t replay(SessionState& aState) const {
+        Varint::Reader reader(fEntries.data(), fEntries.size());
+        size_t applied = 0;
+        while (applied < fEntryCount && aState.getPlayer().isAlive()) {
+            apply(aState, reader.read());
+            ++applied;
+        }
+        return applied;
+    }
+
+    void save(const std::string& aPath) const {
+        std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+        Varint::append(header, kVersion);
+        Varint::append(header, fEntryCount);
+
+        std::ofstream file(aPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("ActionJournal: cannot create " + aPath);
+        }
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        file.write(reinterpret_cast<const char*>(fEntries.data()), static_cast<std::streamsize>(fEntries.size()));
+        if (!file) {
+            throw std::runtime_error("ActionJournal: error writing " + aPath);
+        }
+    }
+
+    // Load a journal recorded from aDungeon's entrance with aPlayer
+    static ActionJournal load(const std::string& aPath, const Dungeon& aDungeon, const Player& aPlayer) {
+        std::ifstream file(aPath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("ActionJournal: cannot open " + aPath);
+        }
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.size() < sizeof(kMagic) || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("ActionJournal: not a journal file: " + aPath);
+        }
+
+        Varint::Reader reader(bytes.data() + sizeof(kMagic), bytes.size() - sizeof(kMagic));
+        if (reader.read() != kVersion) {
+            throw std::runtime_error("ActionJournal: unsupported version in " + aPath);
+        }
+        uint64_t entryCount = reader.read();
+        ActionJournal journal;
+        for (uint64_t i = 0; i < entryCount; ++i) {
+            uint64_t entry = reader.read();
+            journal.append(entry >> kOpcodeBits, entry & ((1u << kOpcodeBits) - 1));
+        }
+        if (!reader.atEnd()) {
+            throw std::runtime_error("ActionJournal: trailing data in " + aPath);
+        }
+        journal.validate(aDungeon, aPlayer, aPath);
+        return journal;
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// Forward declarations
+class Entity;
+class Monster;
+class Item;
+class Clue;
+class Room;
+
+/**
+ * Observer for state changes caused by player actions
+ * Actions notify a listener when a monster is defeated, an item is collected
+ * or a clue is examined for the first time; every method defaults to no-op.
+ * Sessions (SessionState) also report monsters that survive an attack and
+ * every room the player enters. A living world (WorldScheduler) reports
+ * what it undoes: a defeated monster that respawns and an examined clue
+ * that is forgotten, so listeners keeping totals can count them again,
+ * and an entity it moves to another room (see SessionState::moveEntity).
+ */
+class ActionListener {
+public:
+    virtual ~ActionListener() = default;
+
+    virtual void onMonsterDefeated(const Monster&) {}
+    virtual void onItemCollected(const Item&) {}
+    virtual void onClueExamined(const Clue&) {}
+    virtual void onMonsterWounded(const Monster&) {}
+    virtual void onRoomEntered(const Room&) {}
+    virtual void onMonsterRespawned(const Monster&) {}
+    virtual void onClueForgotten(const Clue&) {}
+    virtual void onEntityMoved(const Entity&, const Room&, const Room&) {}  // Entity, from, to
+};
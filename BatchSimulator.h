@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <mutex>
+#include "Dungeon.h"
+#include "Player.h"
+#include "SessionState.h"
+#include "WorkStealingPool.h"
+
+/**
+ * Summary of a batch of simulated sessions
+ */
+struct BatchResult {
+    size_t fSessions = 0;
+    size_t fSurvivors = 0;
+    long long fTotalScore = 0;
+    int fMinScore = INT_MAX;
+    int fMaxScore = INT_MIN;
+
+    void add(const SessionState& aState) {
+        int score = aState.getPlayer().getScore();
+        ++fSessions;
+        if (aState.getPlayer().isAlive()) ++fSurvivors;
+        fTotalScore += score;
+        fMinScore = std::min(fMinScore, score);
+        fMaxScore = std::max(fMaxScore, score);
+    }
+
+    void merge(const BatchResult& aOther) {
+        fSessions += aOther.fSessions;
+        fSurvivors += aOther.fSurvivors;
+        fTotalScore += aOther.fTotalScore;
+        fMinScore = std::min(fMinScore, aOther.fMinScore);
+        fMaxScore = std::max(fMaxScore, aOther.fMaxScore);
+    }
+
+    // Score statistics are 0 for an empty batch
+    double getAverageScore() const {
+        return fSessions ? static_cast<double>(fTotalScore) / fSessions : 0.0;
+    }
+
+    int getMinScore() const { return fSessions ? fMinScore : 0; }
+    int getMaxScore() const { return fSessions ? fMaxScore : 0; }
+};
+
+/**
+ * Headless batch engine running many sessions over one shared Dungeon
+ * The Dungeon is only read; every session gets its own SessionState overlay.
+ * Sessions are grouped into tasks and scheduled on a work-stealing pool.
+ */
+class BatchSimulator {
+public:
+    // Drives one session; the index lets bots vary their behaviour per session
+    using SessionBot = std::function<void(SessionState& aState, size_t aSessionIndex)>;
+
+private:
+    const Dungeon& fDungeon;
+    WorkStealingPool fPool;
+
+public:
+    BatchSimulator(const Dungeon& aDungeon, size_t aThreadCount)
+        : fDungeon(aDungeon), fPool(aThreadCount) {}
+
+    size_t getThreadCount() const {
+        return fPool.getThreadCount();
+    }
+
+    // Run aSessionCount sessions, each starting from a copy of aPlayer
+    BatchResult run(size_t aSessionCount, const Player& aPlayer, const SessionBot& aBot,
+                    size_t aSessionsPerTask = 64) {
+        BatchResult total;
+        std::mutex totalMutex;
+        if (aSessionsPerTask == 0) aSessionsPerTask = 1;
+
+        for (size_t first = 0; first < aSessionCount; first += aSessionsPerTask) {
+            size_t last = std::min(aSessionCount, first + aSessionsPerTask);
+            fPool.submit([this, first, last, &aPlayer, &aBot, &total, &totalMutex] {
+                BatchResult partial;
+                for (size_t i = first; i < last; ++i) {
+                    SessionState state(fDungeon, aPlayer);
+                    aBot(state, i);
+                    partial.add(state);
+                }
+                std::lock_guard<std::mutex> lock(totalMutex);
+                total.merge(partial);
+            });
+        }
+
+        fPool.wait();
+        return total;
+    }
+};
@@ -7,17 +7,19 @@
  */
 class Clue : public Entity {
 private:
-    std::string fHiddenInfo;
+    StoredText fHiddenInfo;
     bool fIsExamined;
 
 public:
-    Clue(const std::string& aName, const std::string& aDescription, const std::string& aHiddenInfo)
+    Clue(std::string_view aName, StoredText aDescription, StoredText aHiddenInfo)
         : Entity(aName, aDescription), fHiddenInfo(aHiddenInfo), fIsExamined(false) {}
 
     // Getter and setter methods
-    const std::string& getHiddenInfo() const { return fHiddenInfo; }
+    std::string_view getHiddenInfo() const { return fHiddenInfo.view(); }
+    const StoredText& getHiddenInfoText() const { return fHiddenInfo; }
     bool isExamined() const { return fIsExamined; }
     void examine() { fIsExamined = true; }
+    void setExamined(bool aIsExamined) { fIsExamined = aIsExamined; }
 
     // Accept method for Visitor pattern
     void accept(EntityVisitor& aVisitor) override {
@@ -0,0 +1,330 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Word dictionary for compressing descriptive text
+ *
+ * Text is cut into words, each with the space after it. train() picks the
+ * words that save the most bytes over a set of texts; encode() replaces
+ * every dictionary word by its code and keeps the other bytes:
+ *   0x00, 0x02-0x7F   the byte itself
+ *   0x01 b            byte b (for 0x01 and bytes from 0x80 up, such as UTF-8)
+ *   0x80-0xBF         one of the 64 best words
+ *   0xC0-0xFE b       one of the next 16128 words
+ * Codes carry no state from one text to the next, so every text decodes on
+ * its own, which suits many short texts.
+ */
+class TextDictionary {
+public:
+    static constexpr size_t kShortCodes = 64;
+    static constexpr size_t kMaxWords = kShortCodes + 63 * 256;
+    static constexpr size_t kMaxWordSize = 255;  // Word sizes are stored in a byte
+
+private:
+    static constexpr uint8_t kEscape = 0x01;
+    static constexpr uint8_t kShortCode = 0x80;
+    static constexpr uint8_t kLongCode = 0xC0;
+
+    std::vector<std::string> fWords;  // By code
+    std::unordered_map<std::string_view, uint32_t> fCodes;  // Keys point into fWords
+
+    // The word starting at aPosition, with its trailing space
+    static std::string_view wordAt(std::string_view aText, size_t aPosition) {
+        size_t space = aText.find(' ', aPosition);
+        size_t end = space == std::string_view::npos ? aText.size() : space + 1;
+        return aText.substr(aPosition, end - aPosition);
+    }
+
+    void addWord(std::string_view aWord) {
+        fWords.emplace_back(aWord);
+    }
+
+    void buildCodes() {
+        fCodes.clear();
+        fCodes.reserve(fWords.size());
+        for (size_t code = 0; code < fWords.size(); ++code) {
+            fCodes.emplace(fWords[code], static_cast<uint32_t>(code));
+        }
+    }
+
+public:
+    TextDictionary() = default;
+    TextDictionary(TextDictionary&&) = default;
+    TextDictionary& operator=(TextDictionary&&) = default;
+    TextDictionary(const TextDictionary&) = delete;
+    TextDictionary& operator=(const TextDictionary&) = delete;
+
+    // Words of at least three bytes that occur more than once, best savings
+    // (occurrences times bytes saved) first
+    static TextDictionary train(const std::vector<std::string_view>& aTexts, size_t aMaxWords = kMaxWords) {
+        std::unordered_map<std::string_view, size_t> counts;
+        for (std::string_view text : aTexts) {
+            for (size_t position = 0; position < text.size();) {
+                std::string_view word = wordAt(text, position);
+                if (word.size() >= 3 && word.size() <= kMaxWordSize) {
+                    ++counts[word];
+                }
+                position += word.size();
+            }
+        }
+
+        std::vector<std::pair<size_t, std::string_view>> candidates;
+        for (const auto& [word, count] : counts) {
+            if (count > 1) {
+                candidates.emplace_back(count * (word.size() - 2), word);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& aLeft, const auto& aRight) {
+            return aLeft.first != aRight.first ? aLeft.first > aRight.first : aLeft.second < aRight.second;
+        });
+
+        TextDictionary dictionary;
+        size_t wordCount = std::min({candidates.size(), aMaxWords, kMaxWords});
+        dictionary.fWords.reserve(wordCount);
+        for (size_t i = 0; i < wordCount; ++i) {
+            dictionary.addWord(candidates[i].second);
+        }
+        dictionary.buildCodes();
+        return dictionary;
+    }
+
+    // Stored form: each word as its size byte and its bytes, in code order
+    std::string serialize() const {
+        std::string out;
+        for (const std::string& word : fWords) {
+            out.push_back(static_cast<char>(word.size()));
+            out.append(word);
+        }
+        return out;
+    }
+
+    static TextDictionary deserialize(std::string_view aData) {
+        TextDictionary dictionary;
+        for (size_t position = 0; position < aData.size();) {
+            size_t size = static_cast<uint8_t>(aData[position++]);
+            if (size > aData.size() - position || dictionary.fWords.size() == kMaxWords) {
+                throw std::runtime_error("TextDictionary: malformed dictionary");
+            }
+            dictionary.addWord(aData.substr(position, size));
+            position += size;
+        }
+        dictionary.buildCodes();
+        return dictionary;
+    }
+
+    size_t getWordCount() const { return fWords.size(); }
+
+    // Append the encoded form of aText to aOut
+    void encode(std::string_view aText, std::string& aOut) const {
+        for (size_t position = 0; position < aText.size();) {
+            std::string_view word = wordAt(aText, position);
+            position += word.size();
+            auto found = fCodes.find(word);
+            if (found != fCodes.end()) {
+                uint32_t code = found->second;
+                if (code < kShortCodes) {
+                    aOut.push_back(static_cast<char>(kShortCode + code));
+                } else {
+                    code -= kShortCodes;
+                    aOut.push_back(static_cast<char>(kLongCode + code / 256));
+                    aOut.push_back(static_cast<char>(code % 256));
+                }
+                continue;
+            }
+            for (char c : word) {
+                uint8_t byte = static_cast<uint8_t>(c);
+                if (byte == kEscape || byte >= kShortCode) {
+                    aOut.push_back(static_cast<char>(kEscape));
+                }
+                aOut.push_back(c);
+            }
+        }
+    }
+
+    // Whether aEncoded decodes: no escape or long code is cut off and every
+    // code is in the dictionary
+    bool isValid(std::string_view aEncoded) const {
+        for (size_t position = 0; position < aEncoded.size();) {
+            uint8_t byte = static_cast<uint8_t>(aEncoded[position++]);
+            if (byte != kEscape && byte < kShortCode) {
+                continue;
+            }
+            if (byte >= kShortCode && byte < kLongCode) {
+                if (size_t(byte - kShortCode) >= fWords.size()) return false;
+                continue;
+            }
+            if (position == aEncoded.size()) {
+                return false;
+            }
+            uint8_t next = static_cast<uint8_t>(aEncoded[position++]);
+            if (byte != kEscape && kShortCodes + (byte - kLongCode) * size_t(256) + next >= fWords.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Append the text aEncoded stands for to aOut
+    void decode(std::string_view aEncoded, std::string& aOut) const {
+        for (size_t position = 0; position < aEncoded.size();) {
+            uint8_t byte = static_cast<uint8_t>(aEncoded[position++]);
+            size_t code;
+            if (byte >= kShortCode && byte < kLongCode) {
+                code = byte - kShortCode;
+            } else if (byte != kEscape && byte < kShortCode) {
+                aOut.push_back(static_cast<char>(byte));
+                continue;
+            } else {
+                if (position == aEncoded.size()) {
+                    throw std::runtime_error("TextDictionary: truncated text");
+                }
+                uint8_t next = static_cast<uint8_t>(aEncoded[position++]);
+                if (byte == kEscape) {
+                    aOut.push_back(static_cast<char>(next));
+                    continue;
+                }
+                code = kShortCodes + (byte - kLongCode) * size_t(256) + next;
+            }
+            if (code >= fWords.size()) {
+                throw std::runtime_error("TextDictionary: unknown word");
+            }
+            aOut.append(fWords[code]);
+        }
+    }
+};
+
+class ColdTextStore;
+
+/**
+ * Text held by a room or entity: either a plain view (static tables, arena,
+ * mapped file) or a reference to compressed text in a ColdTextStore
+ *
+ * Both forms take the space of a string_view; cold text keeps only its
+ * offset and size in the store's blob. view() returns plain text as is and
+ * decodes cold text into a small per-thread buffer, which stays valid until
+ * that thread has decoded ColdTextStore::kDecodeBuffers more texts; callers
+ * use the view at once (for example write it to a sink) and do not keep it.
+ */
+class StoredText {
+private:
+    union {
+        const char* fData;  // Plain text
+        uint64_t fOffset;   // Cold text: offset into the store's blob
+    };
+    uint32_t fSize;   // Plain: text size; cold: encoded size
+    uint32_t fStore;  // Cold: registry slot of the store plus one; 0 for plain text
+
+    friend class ColdTextStore;
+
+    StoredText(uint64_t aOffset, uint32_t aSize, uint32_t aStore) : fOffset(aOffset), fSize(aSize), fStore(aStore) {}
+
+public:
+    StoredText() : fData(nullptr), fSize(0), fStore(0) {}
+    StoredText(std::string_view aText) : fData(aText.data()), fSize(static_cast<uint32_t>(aText.size())), fStore(0) {}
+    StoredText(const char* aText) : StoredText(std::string_view(aText)) {}
+
+    bool isCold() const { return fStore != 0; }
+    bool empty() const { return fSize == 0; }
+
+    inline std::string_view view() const;
+};
+
+/**
+ * Read-only compressed text shared by many rooms and entities: a blob of
+ * texts encoded with one TextDictionary, usually a section of a mapped
+ * dungeon file. Stores register in a fixed table so a StoredText needs only
+ * a small slot number to find its store; the store must outlive its texts.
+ * Decoding is safe from several threads at once.
+ */
+class ColdTextStore {
+public:
+    static constexpr size_t kDecodeBuffers = 8;  // Decoded views live this many decodes per thread
+    static constexpr uint32_t kMaxStores = 4096;
+
+private:
+    TextDictionary fDictionary;
+    std::string_view fBlob;
+    std::shared_ptr<const void> fStorage;  // Keeps fBlob alive
+    uint32_t fSlot;
+
+    static std::atomic<const ColdTextStore*>& slot(uint32_t aSlot) {
+        static std::atomic<const ColdTextStore*> slots[kMaxStores];
+        return slots[aSlot];
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+public:
+    ColdTextStore(TextDictionary aDictionary, std::string_view aBlob, std::shared_ptr<const void> aStorage)
+        : fDictionary(std::move(aDictionary)), fBlob(aBlob), fStorage(std::move(aStorage)), fSlot(kMaxStores) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (uint32_t i = 0; i < kMaxStores; ++i) {
+            if (!slot(i).load(std::memory_order_relaxed)) {
+                fSlot = i;
+                slot(i).store(this, std::memory_order_release);
+                return;
+            }
+        }
+        throw std::runtime_error("ColdTextStore: too many stores");
+    }
+
+    ColdTextStore(const ColdTextStore&) = delete;
+    ColdTextStore& operator=(const ColdTextStore&) = delete;
+
+    ~ColdTextStore() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        slot(fSlot).store(nullptr, std::memory_order_release);
+    }
+
+    static const ColdTextStore& find(uint32_t aSlot) {
+        return *slot(aSlot).load(std::memory_order_acquire);
+    }
+
+    const TextDictionary& getDictionary() const { return fDictionary; }
+    size_t getBlobSize() const { return fBlob.size(); }
+
+    // Whether the text at aOffset is in the blob and decodes
+    bool isValid(uint64_t aOffset, uint32_t aSize) const {
+        return aOffset <= fBlob.size() && aSize <= fBlob.size() - aOffset &&
+               fDictionary.isValid(fBlob.substr(aOffset, aSize));
+    }
+
+    // Handle for the encoded text at aOffset in the blob
+    StoredText get(uint64_t aOffset, uint32_t aSize) const {
+        if (aOffset > fBlob.size() || aSize > fBlob.size() - aOffset) {
+            throw std::runtime_error("ColdTextStore: text out of bounds");
+        }
+        return StoredText(aOffset, aSize, fSlot + 1);
+    }
+
+    // Decode into the calling thread's next buffer
+    std::string_view decode(uint64_t aOffset, uint32_t aSize) const {
+        static thread_local std::string buffers[kDecodeBuffers];
+        static thread_local size_t next = 0;
+        std::string& buffer = buffers[next++ % kDecodeBuffers];
+        buffer.clear();
+        fDictionary.decode(fBlob.substr(aOffset, aSize), buffer);
+        return buffer;
+    }
+};
+
+inline std::string_view StoredText::view() const {
+    if (fStore == 0) {
+        return std::string_view(fData, fSize);
+    }
+    return ColdTextStore::find(fStore - 1).decode(fOffset, fSize);
+}
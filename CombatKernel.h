@@ -0,0 +1,204 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Monster.h"
+#include "Player.h"
+
+/**
+ * Closed-form resolution of whole fights, for balance sweeps
+ *
+ * A fight is the player attacking one monster again and again with the
+ * AttackAction rules until the monster or the player is dead:
+ * - each attack deals the player's attack power
+ * - a monster that survives the attack strikes back for its damage
+ * - the player dies when their health reaches 0
+ * With turns = ceil(monsterHealth / attack) and deathHit = ceil(playerHealth
+ * / damage), the player wins iff turns - 1 < deathHit. A winner made `turns`
+ * attacks and took (turns - 1) * damage. A loser made deathHit attacks and
+ * lost all their health.
+ *
+ * resolveFights() works on struct-of-arrays batches kLanes fights at a time
+ * using GCC/Clang vector extensions. Every step is a lane-wise int32 vector
+ * operation and choices are made with masks, so there are no branches per
+ * fight. Only the two divisions go through double precision lanes, which
+ * gives exact ceilings for any int operands.
+ * Expected inputs are the game's: player health and attack power > 0 and
+ * damage >= 0. A monster with no health left is already dead and is not
+ * attacked, as in AttackAction. An attack power of 0 never kills, so the
+ * player only fights until they die (no attacks at all if the damage is 0 too).
+ */
+namespace CombatKernel {
+
+constexpr size_t kLanes = 4;
+
+// Parameters of a batch of fights, one entry per fight
+struct FightInputs {
+    const int* fPlayerHealth;
+    const int* fPlayerAttack;
+    const int* fMonsterHealth;
+    const int* fMonsterDamage;
+};
+
+// Outcomes of a batch of fights
+struct FightOutputs {
+    int* fAttacks;        // Attacks the player made
+    int* fDamageTaken;    // Health the player lost
+    int* fPlayerHealth;   // Player health afterwards
+    int* fMonsterHealth;  // Monster health afterwards
+    uint8_t* fPlayerWon;  // 1 if the monster is dead and the player alive afterwards
+};
+
+struct FightOutcome {
+    int fAttacks;
+    int fDamageTaken;
+    int fPlayerHealth;
+    int fMonsterHealth;
+    bool fPlayerWon;
+};
+
+namespace detail {
+
+typedef int IntLanes __attribute__((vector_size(kLanes * sizeof(int))));
+typedef unsigned UnsignedLanes __attribute__((vector_size(kLanes * sizeof(unsigned))));
+typedef double RealLanes __attribute__((vector_size(kLanes * sizeof(double))));
+
+// ceil(aNumerator / aDenominator) for aNumerator >= 0 and aDenominator >= 1, as
+// floor((n + d - 1) / d); the sum is formed in double so it cannot overflow and
+// the rounded quotient of such integers never reaches the next integer
+inline IntLanes ceilQuotient(const IntLanes& aNumerator, const IntLanes& aDenominator) {
+    RealLanes numerator = __builtin_convertvector(aNumerator, RealLanes);
+    RealLanes denominator = __builtin_convertvector(aDenominator, RealLanes);
+    return __builtin_convertvector((numerator + denominator - 1.0) / denominator, IntLanes);
+}
+
+// Lanes of one block of fights
+struct Block {
+    IntLanes fPlayerHealth;
+    IntLanes fAttack;
+    IntLanes fMonsterHealth;
+    IntLanes fDamage;
+    IntLanes fAttacks;
+    IntLanes fDamageTaken;
+    IntLanes fPlayerAfter;
+    IntLanes fMonsterAfter;
+    IntLanes fWon;
+};
+
+inline void resolveBlock(Block& aBlock) {
+    const IntLanes zero = {};
+    const IntLanes one = zero + 1;
+    IntLanes health = aBlock.fPlayerHealth > zero ? aBlock.fPlayerHealth : zero;
+    IntLanes monster = aBlock.fMonsterHealth > zero ? aBlock.fMonsterHealth : zero;
+
+    // Attacks to kill the monster and hits that kill the player
+    IntLanes turns = ceilQuotient(monster, aBlock.fAttack > one ? aBlock.fAttack : one);
+    IntLanes deathHit = ceilQuotient(health, aBlock.fDamage > one ? aBlock.fDamage : one);
+
+    IntLanes canKill = aBlock.fAttack > zero;
+    IntLanes canHurt = aBlock.fDamage > zero;
+    IntLanes fights = (monster > zero) & (health > zero);
+    IntLanes wins = fights & canKill & (~canHurt | (turns - one < deathHit));
+    IntLanes dies = fights & ~wins & canHurt;
+    IntLanes made = wins ? turns : (dies ? deathHit : zero);
+
+    // Products are formed unsigned: lanes that are not selected may wrap
+    UnsignedLanes winLoss = (UnsignedLanes)(turns - one) * (UnsignedLanes)aBlock.fDamage;
+    UnsignedLanes dealt = (UnsignedLanes)made * (UnsignedLanes)aBlock.fAttack;
+    IntLanes lost = wins ? (IntLanes)winLoss : (dies ? health : zero);
+
+    aBlock.fAttacks = made;
+    aBlock.fDamageTaken = lost;
+    aBlock.fPlayerAfter = aBlock.fPlayerHealth - lost;
+    aBlock.fMonsterAfter = wins ? zero : monster - (IntLanes)dealt;
+    aBlock.fWon = (wins | ((monster == zero) & (health > zero))) & one;
+}
+
+// Copy Count fights starting at aFirst into or out of a block; the count is a
+// template argument so full blocks compile to plain vector loads and stores
+template <size_t Count>
+inline void loadBlock(Block& aBlock, const FightInputs& aIn, size_t aFirst) {
+    std::memcpy(&aBlock.fPlayerHealth, aIn.fPlayerHealth + aFirst, Count * sizeof(int));
+    std::memcpy(&aBlock.fAttack, aIn.fPlayerAttack + aFirst, Count * sizeof(int));
+    std::memcpy(&aBlock.fMonsterHealth, aIn.fMonsterHealth + aFirst, Count * sizeof(int));
+    std::memcpy(&aBlock.fDamage, aIn.fMonsterDamage + aFirst, Count * sizeof(int));
+}
+
+template <size_t Count>
+inline void storeBlock(const Block& aBlock, const FightOutputs& aOut, size_t aFirst) {
+    std::memcpy(aOut.fAttacks + aFirst, &aBlock.fAttacks, Count * sizeof(int));
+    std::memcpy(aOut.fDamageTaken + aFirst, &aBlock.fDamageTaken, Count * sizeof(int));
+    std::memcpy(aOut.fPlayerHealth + aFirst, &aBlock.fPlayerAfter, Count * sizeof(int));
+    std::memcpy(aOut.fMonsterHealth + aFirst, &aBlock.fMonsterAfter, Count * sizeof(int));
+    for (size_t i = 0; i < Count; ++i) {
+        aOut.fPlayerWon[aFirst + i] = static_cast<uint8_t>(aBlock.fWon[i]);
+    }
+}
+
+// The last, partial block: unused lanes hold dead players, which do not fight
+inline void resolveTail(size_t aCount, const FightInputs& aIn, const FightOutputs& aOut, size_t aFirst) {
+    Block block = {};
+    for (size_t i = 0; i < aCount; ++i) {
+        block.fPlayerHealth[i] = aIn.fPlayerHealth[aFirst + i];
+        block.fAttack[i] = aIn.fPlayerAttack[aFirst + i];
+        block.fMonsterHealth[i] = aIn.fMonsterHealth[aFirst + i];
+        block.fDamage[i] = aIn.fMonsterDamage[aFirst + i];
+    }
+    resolveBlock(block);
+    for (size_t i = 0; i < aCount; ++i) {
+        aOut.fAttacks[aFirst + i] = block.fAttacks[i];
+        aOut.fDamageTaken[aFirst + i] = block.fDamageTaken[i];
+        aOut.fPlayerHealth[aFirst + i] = block.fPlayerAfter[i];
+        aOut.fMonsterHealth[aFirst + i] = block.fMonsterAfter[i];
+        aOut.fPlayerWon[aFirst + i] = static_cast<uint8_t>(block.fWon[i]);
+    }
+}
+
+} // namespace detail
+
+// Resolve aCount fights; input and output arrays must each hold aCount entries
+inline void resolveFights(size_t aCount, const FightInputs& aIn, const FightOutputs& aOut) {
+    size_t first = 0;
+    for (; first + kLanes <= aCount; first += kLanes) {
+        detail::Block block;
+        detail::loadBlock<kLanes>(block, aIn, first);
+        detail::resolveBlock(block);
+        detail::storeBlock<kLanes>(block, aOut, first);
+    }
+    if (first < aCount) {
+        detail::resolveTail(aCount - first, aIn, aOut, first);
+    }
+}
+
+// Closed-form outcome of a single fight
+inline FightOutcome resolveFight(int aPlayerHealth, int aPlayerAttack, int aMonsterHealth, int aMonsterDamage) {
+    detail::Block block = {};
+    block.fPlayerHealth[0] = aPlayerHealth;
+    block.fAttack[0] = aPlayerAttack;
+    block.fMonsterHealth[0] = aMonsterHealth;
+    block.fDamage[0] = aMonsterDamage;
+    detail::resolveBlock(block);
+    return FightOutcome{block.fAttacks[0], block.fDamageTaken[0], block.fPlayerAfter[0],
+                        block.fMonsterAfter[0], block.fWon[0] != 0};
+}
+
+// Fight it out one exchange at a time with the Player and Monster rules used by
+// AttackAction, as a reference for the closed form
+inline FightOutcome simulateFight(Player& aPlayer, Monster& aMonster) {
+    FightOutcome outcome{0, 0, aPlayer.getHealth(), aMonster.getHealth(), false};
+    int startHealth = aPlayer.getHealth();
+    while (aMonster.isAlive() && aPlayer.isAlive() && (aPlayer.getAttackPower() > 0 || aMonster.getDamage() > 0)) {
+        ++outcome.fAttacks;
+        aMonster.takeDamage(aPlayer.getAttackPower());
+        if (aMonster.isAlive()) {
+            aPlayer.takeDamage(aMonster.getDamage());
+        }
+    }
+    outcome.fDamageTaken = startHealth - aPlayer.getHealth();
+    outcome.fPlayerHealth = aPlayer.getHealth();
+    outcome.fMonsterHealth = aMonster.getHealth();
+    outcome.fPlayerWon = !aMonster.isAlive() && aPlayer.isAlive();
+    return outcome;
+}
+
+} // namespace CombatKernel
@@ -1,26 +1,193 @@
 #pragma once
 #include "Room.h"
+#include "RoomIndex.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "OutputSink.h"
+#include <cstring>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 /**
- * Dungeon class - manages the tree structure of rooms
- * The root room is the entrance to the dungeon
+ * Dungeon class - manages the rooms and the doors between them
+ * The root room is the entrance to the dungeon. Doors form a general directed
+ * graph (see RoomGraph): rooms may be reached through several doors, doors
+ * may lead back, and a door may be locked behind a key item.
+ * Rooms, entities, their entity lists and all text live in one arena owned
+ * by the dungeon and are released together when it is destroyed.
+ * A paged dungeon (see RoomPager) keeps only the rooms and doors in memory and
+ * has its RoomLoader supply room content and entities on demand; it must
+ * not be shared between threads, as even reading it may page rooms in.
  */
 class Dungeon {
 private:
     Room* fRoot;  // Root node of the tree (entrance)
-    std::vector<std::unique_ptr<Room>> fRooms;  // All rooms in the dungeon
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> fArena;  // Backing store for everything below
+    std::unique_ptr<RoomGraph> fGraph;  // All rooms and doors; rooms point at it, so it never moves
+    std::vector<Entity*> fOwnedEntities;  // All entities, in creation order
+    std::vector<Entity*> fEntities;  // All entities, indexed by Entity::getId()
+    std::vector<std::shared_ptr<const void>> fExternalText;  // Keeps referenced text alive (e.g. a mapped file)
+    RoomIndex fIndex;  // Built by buildIndex()
+    std::unique_ptr<RoomLoader> fLoader;  // Paged dungeons only
+
+    static constexpr size_t kInitialArenaSize = 64 * 1024;
+
+    // Run destructors; the arena itself frees all memory at once
+    void destroyContents() {
+        fLoader.reset();  // Drops paged content while the rooms still exist
+        for (Entity* entity : fOwnedEntities) {
+            entity->~Entity();
+        }
+        if (fGraph) {
+            for (Room* room : fGraph->getRooms()) {
+                room->~Room();
+            }
+            fGraph.reset();
+        }
+        fOwnedEntities.clear();
+        fEntities.clear();
+        fRoot = nullptr;
+    }
 
 public:
-    Dungeon() : fRoot(nullptr) {}
+    Dungeon()
+        : fRoot(nullptr),
+          fArena(std::make_unique<std::pmr::monotonic_buffer_resource>(kInitialArenaSize)),
+          fGraph(std::make_unique<RoomGraph>()) {}
+
+    Dungeon(Dungeon&& aOther) noexcept
+        : fRoot(std::exchange(aOther.fRoot, nullptr)), fArena(std::move(aOther.fArena)),
+          fGraph(std::move(aOther.fGraph)), fOwnedEntities(std::move(aOther.fOwnedEntities)),
+          fEntities(std::move(aOther.fEntities)), fExternalText(std::move(aOther.fExternalText)),
+          fIndex(std::move(aOther.fIndex)), fLoader(std::move(aOther.fLoader)) {
+        aOther.fOwnedEntities.clear();
+        aOther.fEntities.clear();
+    }
+
+    Dungeon& operator=(Dungeon&& aOther) noexcept {
+        if (this != &aOther) {
+            destroyContents();
+            fRoot = std::exchange(aOther.fRoot, nullptr);
+            fArena = std::move(aOther.fArena);
+            fGraph = std::move(aOther.fGraph);
+            fOwnedEntities = std::move(aOther.fOwnedEntities);
+            fEntities = std::move(aOther.fEntities);
+            fExternalText = std::move(aOther.fExternalText);
+            fIndex = std::move(aOther.fIndex);
+            fLoader = std::move(aOther.fLoader);
+            aOther.fOwnedEntities.clear();
+            aOther.fEntities.clear();
+        }
+        return *this;
+    }
+
+    Dungeon(const Dungeon&) = delete;
+    Dungeon& operator=(const Dungeon&) = delete;
+
+    ~Dungeon() {
+        destroyContents();
+    }
+
+    // Memory resource used for all dungeon storage
+    std::pmr::memory_resource* getArena() const {
+        return fArena.get();
+    }
+
+    // Keep external storage (such as a memory-mapped file) alive for as long
+    // as the dungeon, so rooms and entities can reference text inside it
+    void adoptExternalText(std::shared_ptr<const void> aStorage) {
+        fExternalText.push_back(std::move(aStorage));
+    }
+
+    // Copy text into the arena; the view stays valid for the dungeon's lifetime
+    std::string_view storeText(std::string_view aText) {
+        if (aText.empty()) {
+            return std::string_view();
+        }
+        char* copy = static_cast<char*>(fArena->allocate(aText.size(), 1));
+        std::memcpy(copy, aText.data(), aText.size());
+        return std::string_view(copy, aText.size());
+    }
 
     // Create and add a room to the dungeon
-    Room* createRoom(const std::string& aName, const std::string& aDescription) {
-        auto room = std::make_unique<Room>(aName, aDescription);
-        Room* roomPtr = room.get();
-        fRooms.push_back(std::move(room));
-        return roomPtr;
+    Room* createRoom(std::string_view aName, std::string_view aDescription) {
+        return createRoomView(storeText(aName), storeText(aDescription));
+    }
+
+    // Create a room that references its text instead of copying it; the text
+    // must outlive the dungeon (static tables, text already in the arena, ...).
+    // The room's lists use the arena unless given another resource.
+    Room* createRoomView(std::string_view aName, StoredText aDescription,
+                         std::pmr::memory_resource* aLists = nullptr) {
+        void* memory = fArena->allocate(sizeof(Room), alignof(Room));
+        Room* room = new (memory) Room(aName, aDescription, aLists ? aLists : fArena.get());
+        room->setId(fGraph->getRoomCount());
+        room->setGraph(fGraph.get());
+        fGraph->addRoom(room);
+        return room;
+    }
+
+    // Reserve space for the room, entity and door tables of a large dungeon
+    void reserve(size_t aRooms, size_t aEntities, size_t aDoors = 0) {
+        fGraph->reserve(aRooms, aDoors);
+        fOwnedEntities.reserve(aEntities);
+    }
+
+    // Construct an entity in the arena; text arguments are used as given and
+    // must outlive the dungeon (see the createMonster/Item/Clue helpers)
+    template <typename T, typename... Args>
+    T* createEntity(Args&&... aArgs) {
+        void* memory = fArena->allocate(sizeof(T), alignof(T));
+        T* entity = new (memory) T(std::forward<Args>(aArgs)...);
+        fOwnedEntities.push_back(entity);
+        return entity;
+    }
+
+    Monster* createMonster(std::string_view aName, std::string_view aDescription, int aHealth, int aDamage) {
+        return createEntity<Monster>(storeText(aName), storeText(aDescription), aHealth, aDamage);
+    }
+
+    Item* createItem(std::string_view aName, std::string_view aDescription, int aValue) {
+        return createEntity<Item>(storeText(aName), storeText(aDescription), aValue);
+    }
+
+    Clue* createClue(std::string_view aName, std::string_view aDescription, std::string_view aHiddenInfo) {
+        return createEntity<Clue>(storeText(aName), storeText(aDescription), storeText(aHiddenInfo));
+    }
+
+    // Add a door from one room to another; with aKeyItem the door is locked
+    // and only a player holding an item of that name can go through (names
+    // are interned, so need not outlive the call)
+    void connectRooms(Room* aFrom, Room* aTo, std::string_view aDoorName, std::string_view aKeyItem = {}) {
+        SymbolTable& symbols = SymbolTable::global();
+        fGraph->addDoor(static_cast<uint32_t>(aFrom->getId()), static_cast<uint32_t>(aTo->getId()),
+                        symbols.intern(aDoorName), symbols.intern(aKeyItem));
+        aFrom->invalidateText();
+    }
+
+    // A door each way between two rooms
+    void connectBothWays(Room* aRoom, Room* aOther, std::string_view aDoorName, std::string_view aBackDoorName,
+                         std::string_view aKeyItem = {}) {
+        connectRooms(aRoom, aOther, aDoorName, aKeyItem);
+        connectRooms(aOther, aRoom, aBackDoorName, aKeyItem);
+    }
+
+    // Rooms and doors, for traversals and path queries
+    const RoomGraph& getGraph() const {
+        return *fGraph;
+    }
+
+    // Make this a paged dungeon; the loader is owned by the dungeon
+    void setLoader(std::unique_ptr<RoomLoader> aLoader) {
+        fLoader = std::move(aLoader);
+    }
+
+    RoomLoader* getLoader() const {
+        return fLoader.get();
     }
 
     // Set the entrance (root) of the dungeon
@@ -35,14 +202,69 @@ public:
 
     // Get total number of rooms
     size_t getRoomCount() const {
-        return fRooms.size();
+        return fGraph->getRoomCount();
+    }
+
+    // All rooms, in creation order
+    const std::vector<Room*>& getRooms() const {
+        return fGraph->getRooms();
+    }
+
+    // Assign every entity a dense id (in room creation order) so that
+    // per-session state can be kept outside the shared entity objects
+    void indexEntities() {
+        fEntities.clear();
+        fEntities.reserve(fOwnedEntities.size());
+        for (Room* room : fGraph->getRooms()) {
+            for (Entity* entity : room->getEntities()) {
+                entity->setId(fEntities.size());
+                fEntities.push_back(entity);
+            }
+        }
+    }
+
+    // Index entities and rooms once the dungeon is complete: door arrays,
+    // entity ids, room name lookup, parent links, depths and ancestor/path
+    // queries
+    void buildIndex() {
+        fGraph->compact();
+        if (!fLoader) {
+            indexEntities();  // Paged entities get their ids when loaded
+        }
+        fIndex.build(fGraph->getRooms(), fRoot);
+    }
+
+    // Room lookup and path queries (valid after buildIndex())
+    const RoomIndex& getIndex() const {
+        return fIndex;
+    }
+
+    Room* findRoom(std::string_view aName) const {
+        return fIndex.findRoom(aName);
+    }
+
+    // Get total number of indexed entities
+    size_t getEntityCount() const {
+        return fLoader ? fLoader->getEntityCount() : fEntities.size();
+    }
+
+    // Get entity by id (valid after indexEntities()); in a paged dungeon the
+    // pointer is only valid until another room is paged in
+    Entity* getEntity(size_t aId) const {
+        if (fLoader) {
+            return aId < fLoader->getEntityCount() ? fLoader->getEntity(aId) : nullptr;
+        }
+        if (aId < fEntities.size()) {
+            return fEntities[aId];
+        }
+        return nullptr;
     }
 
     // Display dungeon statistics
-    void displayInfo() const {
-        std::cout << "\n=== Dungeon Information ===" << std::endl;
-        std::cout << "Total Rooms: " << fRooms.size() << std::endl;
-        std::cout << "Entrance: " << (fRoot ? fRoot->getName() : "Not set") << std::endl;
-        std::cout << "==========================" << std::endl;
+    void displayInfo(OutputSink& aOut) const {
+        aOut << "\n=== Dungeon Information ===\n";
+        aOut << "Total Rooms: " << getRoomCount() << "\n";
+        aOut << "Entrance: " << (fRoot ? fRoot->getName() : "Not set") << "\n";
+        aOut << "==========================\n";
     }
 };
@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Dungeon.h"
+#include "DungeonTraversal.h"
+#include "OutputSink.h"
+
+/**
+ * Content checks over a whole dungeon: monster difficulty by depth and the
+ * entities no player can get to, as the rooms holding them cannot be
+ * reached from the entrance (door locks are not taken into account).
+ * One audit visits part of the dungeon; audits of disjoint parts are
+ * combined with merge(), so it works as a per-thread visitor of a
+ * DungeonTraversal. The dungeon must have been indexed.
+ */
+class DungeonAudit : public DungeonVisitor {
+public:
+    struct Level {
+        size_t fMonsters = 0;
+        int64_t fHealth = 0;
+        int64_t fDamage = 0;
+        int fStrongest = 0;  // Highest monster health
+    };
+
+private:
+    const RoomIndex& fIndex;
+    uint32_t fDepth;  // Depth of the room being visited (RoomIndex::kNone if unreachable)
+    std::vector<Level> fLevels;  // By depth
+    size_t fEntities;
+    size_t fUnreachableMonsters;
+    size_t fUnreachableItems;
+    size_t fUnreachableClues;
+
+public:
+    explicit DungeonAudit(const Dungeon& aDungeon)
+        : fIndex(aDungeon.getIndex()), fDepth(0), fEntities(0),
+          fUnreachableMonsters(0), fUnreachableItems(0), fUnreachableClues(0) {}
+
+    void enterRoom(const Room& aRoom) override {
+        fDepth = fIndex.getDepth(&aRoom);
+    }
+
+    void visitMonster(Monster& aMonster) override {
+        ++fEntities;
+        if (fDepth == RoomIndex::kNone) {
+            ++fUnreachableMonsters;
+            return;
+        }
+        if (fDepth >= fLevels.size()) {
+            fLevels.resize(fDepth + 1);
+        }
+        Level& level = fLevels[fDepth];
+        ++level.fMonsters;
+        level.fHealth += aMonster.getHealth();
+        level.fDamage += aMonster.getDamage();
+        level.fStrongest = std::max(level.fStrongest, aMonster.getHealth());
+    }
+
+    void visitItem(Item&) override {
+        ++fEntities;
+        if (fDepth == RoomIndex::kNone) ++fUnreachableItems;
+    }
+
+    void visitClue(Clue&) override {
+        ++fEntities;
+        if (fDepth == RoomIndex::kNone) ++fUnreachableClues;
+    }
+
+    // Add the findings of an audit of another part of the dungeon
+    void merge(const DungeonAudit& aOther) {
+        if (aOther.fLevels.size() > fLevels.size()) {
+            fLevels.resize(aOther.fLevels.size());
+        }
+        for (size_t depth = 0; depth < aOther.fLevels.size(); ++depth) {
+            const Level& other = aOther.fLevels[depth];
+            Level& level = fLevels[depth];
+            level.fMonsters += other.fMonsters;
+            level.fHealth += other.fHealth;
+            level.fDamage += other.fDamage;
+            level.fStrongest = std::max(level.fStrongest, other.fStrongest);
+        }
+        fEntities += aOther.fEntities;
+        fUnreachableMonsters += aOther.fUnreachableMonsters;
+        fUnreachableItems += aOther.fUnreachableItems;
+        fUnreachableClues += aOther.fUnreachableClues;
+    }
+
+    const std::vector<Level>& getLevels() const { return fLevels; }
+    size_t getEntityCount() const { return fEntities; }
+    size_t getUnreachableMonsters() const { return fUnreachableMonsters; }
+    size_t getUnreachableItems() const { return fUnreachableItems; }
+    size_t getUnreachableClues() const { return fUnreachableClues; }
+
+    // Print monster difficulty per depth and the unreachable entities
+    void display(OutputSink& aOut) const {
+        aOut << "\n=== Dungeon Audit ===\n";
+        aOut << "Entities: " << fEntities << "\n";
+        for (size_t depth = 0; depth < fLevels.size(); ++depth) {
+            const Level& level = fLevels[depth];
+            if (level.fMonsters == 0) continue;
+            int64_t count = static_cast<int64_t>(level.fMonsters);
+            aOut << "Depth " << depth << ": " << level.fMonsters << " monsters, average health "
+                 << level.fHealth / count << ", average damage " << level.fDamage / count << ", strongest "
+                 << level.fStrongest << "\n";
+        }
+        aOut << "Unreachable: " << fUnreachableMonsters << " monsters, " << fUnreachableItems << " items, "
+             << fUnreachableClues << " clues\n";
+        aOut << "=====================\n";
+    }
+};
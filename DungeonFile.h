@@ -0,0 +1,521 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ColdText.h"
+#include "Dungeon.h"
+
+/**
+ * Compact binary dungeon format
+ *
+ *   Header
+ *   RoomRecord[roomCount]      rooms in Dungeon::getRooms() order
+ *   EntityRecord[entityCount]  entities in id order; each room's are contiguous
+ *   EdgeRecord[edgeCount]      doors in door order; each room's are contiguous
+ *   text                       all strings, deduplicated, not terminated
+ *   cold text                  optional: compressed descriptions and hidden info
+ *   dictionary                 TextDictionary of the cold text
+ *
+ * Integers are stored in native (little-endian) byte order and every table
+ * starts on an 8-byte boundary, so a mapped file can be read in place.
+ * Files saved with compressed text keep room and entity descriptions and
+ * clue hidden info, which are long and rarely read, dictionary-compressed
+ * in the cold text section (TextRef::fEncoding says which section a string
+ * is in); names and door labels stay plain, as they are looked up often.
+ * If compressing that text would not save more than the dictionary takes,
+ * the file is saved plain instead, without cold text or dictionary.
+ */
+namespace DungeonFile {
+
+constexpr char kMagic[8] = {'D', 'N', 'G', 'N', 'B', 'I', 'N', '\0'};
+constexpr uint32_t kVersion = 3;  // 2: doors may be locked (EdgeRecord::fKey); 3: cold text
+
+enum TextEncoding : uint32_t {
+    kPlain = 0,       // In the text section
+    kCompressed = 1   // In the cold text section
+};
+
+struct TextRef {
+    uint64_t fOffset;  // Relative to the start of its section
+    uint32_t fLength;  // In its section (encoded size for compressed text)
+    uint32_t fEncoding;
+};
+
+struct Header {
+    char fMagic[8];
+    uint32_t fVersion;
+    uint32_t fEntrance;  // Room index of the entrance
+    uint64_t fRoomCount;
+    uint64_t fEntityCount;
+    uint64_t fEdgeCount;
+    uint64_t fRoomOffset;
+    uint64_t fEntityOffset;
+    uint64_t fEdgeOffset;
+    uint64_t fTextOffset;
+    uint64_t fTextSize;
+    uint64_t fColdOffset;
+    uint64_t fColdSize;
+    uint64_t fDictionaryOffset;
+    uint64_t fDictionarySize;  // 0 if the file has no compressed text
+};
+
+struct RoomRecord {
+    TextRef fName;
+    TextRef fDescription;
+    uint64_t fFirstEntity;
+    uint64_t fFirstEdge;
+    uint32_t fEntityCount;
+    uint32_t fEdgeCount;
+};
+
+enum EntityKind : uint32_t {
+    kMonster = 0,
+    kItem = 1,
+    kClue = 2
+};
+
+struct EntityRecord {
+    uint32_t fKind;
+    int32_t fStatA;  // Monster health / item value
+    int32_t fStatB;  // Monster damage
+    uint32_t fReserved;
+    TextRef fName;
+    TextRef fDescription;
+    TextRef fHiddenInfo;  // Clues only
+};
+
+struct EdgeRecord {
+    uint64_t fTarget;  // Room index
+    TextRef fDoorName;
+    TextRef fKey;  // Item that unlocks the door; empty if it is not locked
+};
+
+/**
+ * Writes a Dungeon in the binary format; the dungeon must be indexed
+ * With compressed text, the cold strings are collected first and the
+ * dictionary is trained on all of them before any is encoded.
+ */
+class Writer {
+private:
+    bool fCompressText;
+    std::string fText;
+    std::unordered_map<std::string_view, TextRef> fTextIndex;  // Keys point into the dungeon or fCopies
+    std::deque<std::string> fCopies;  // Decoded compressed text of the dungeon being saved
+    std::unordered_map<std::string, uint32_t> fColdIndex;  // Distinct cold strings, numbered
+    std::vector<const std::string*> fColdTexts;  // Keys of fColdIndex by number
+    std::string fColdText;
+    std::string fDictionary;
+    std::vector<EntityRecord> fEntities;
+
+    TextRef addText(std::string_view aText) {
+        auto found = fTextIndex.find(aText);
+        if (found != fTextIndex.end()) {
+            return found->second;
+        }
+        TextRef ref{fText.size(), static_cast<uint32_t>(aText.size()), 0};
+        fText.append(aText);
+        fTextIndex.emplace(aText, ref);
+        return ref;
+    }
+
+    // A description or hidden info. Compressed, it gets its number among the
+    // cold strings for now; encodeColdText() replaces that by its location.
+    TextRef addColdText(const StoredText& aText) {
+        std::string_view text = aText.view();
+        if (!fCompressText || text.empty()) {
+            if (!aText.isCold()) {
+                return addText(text);
+            }
+            auto found = fTextIndex.find(text);
+            return found != fTextIndex.end() ? found->second : addText(fCopies.emplace_back(text));
+        }
+        auto [entry, isNew] = fColdIndex.try_emplace(std::string(text), static_cast<uint32_t>(fColdTexts.size()));
+        if (isNew) {
+            fColdTexts.push_back(&entry->first);
+        }
+        return TextRef{entry->second, 0, kCompressed};
+    }
+
+    void encodeColdText(std::vector<RoomRecord>& aRooms) {
+        std::vector<std::string_view> texts;
+        texts.reserve(fColdTexts.size());
+        for (const std::string* text : fColdTexts) {
+            texts.push_back(*text);
+        }
+        TextDictionary dictionary = TextDictionary::train(texts);
+        std::vector<TextRef> encoded;
+        encoded.reserve(texts.size());
+        size_t plainSize = 0;
+        for (std::string_view text : texts) {
+            size_t start = fColdText.size();
+            dictionary.encode(text, fColdText);
+            encoded.push_back(TextRef{start, static_cast<uint32_t>(fColdText.size() - start), kCompressed});
+            plainSize += text.size();
+        }
+        fDictionary = dictionary.serialize();
+
+        // Text that does not shrink by more than the dictionary costs is saved plain
+        if (fColdText.size() + fDictionary.size() >= plainSize) {
+            fColdText.clear();
+            fDictionary.clear();
+            for (size_t i = 0; i < texts.size(); ++i) {
+                encoded[i] = addText(texts[i]);
+            }
+        }
+
+        auto locate = [&encoded](TextRef& aRef) {
+            if (aRef.fEncoding == kCompressed) aRef = encoded[aRef.fOffset];
+        };
+        for (RoomRecord& room : aRooms) {
+            locate(room.fDescription);
+        }
+        for (EntityRecord& entity : fEntities) {
+            locate(entity.fDescription);
+            locate(entity.fHiddenInfo);
+        }
+    }
+
+    class EntityWriter : public EntityVisitor {
+    private:
+        Writer& fWriter;
+
+    public:
+        EntityWriter(Writer& aWriter) : fWriter(aWriter) {}
+
+        void visitMonster(Monster& aMonster) override {
+            EntityRecord record = fWriter.makeRecord(kMonster, aMonster);
+            record.fStatA = aMonster.getHealth();
+            record.fStatB = aMonster.getDamage();
+            fWriter.fEntities.push_back(record);
+        }
+
+        void visitItem(Item& aItem) override {
+            EntityRecord record = fWriter.makeRecord(kItem, aItem);
+            record.fStatA = aItem.getValue();
+            fWriter.fEntities.push_back(record);
+        }
+
+        void visitClue(Clue& aClue) override {
+            EntityRecord record = fWriter.makeRecord(kClue, aClue);
+            record.fHiddenInfo = fWriter.addColdText(aClue.getHiddenInfoText());
+            fWriter.fEntities.push_back(record);
+        }
+    };
+
+    EntityRecord makeRecord(EntityKind aKind, const Entity& aEntity) {
+        EntityRecord record{};
+        record.fKind = aKind;
+        record.fName = addText(aEntity.getName());
+        record.fDescription = addColdText(aEntity.getDescriptionText());
+        return record;
+    }
+
+    static uint64_t align8(uint64_t aOffset) {
+        return (aOffset + 7) & ~uint64_t(7);
+    }
+
+    template <typename T>
+    static void writeTable(std::ofstream& aFile, const std::vector<T>& aTable, uint64_t aOffset) {
+        aFile.seekp(static_cast<std::streamoff>(aOffset));
+        aFile.write(reinterpret_cast<const char*>(aTable.data()),
+                    static_cast<std::streamsize>(aTable.size() * sizeof(T)));
+    }
+
+public:
+    // aCompressText: keep descriptions and hidden info in the cold text section
+    explicit Writer(bool aCompressText = false) : fCompressText(aCompressText) {}
+
+    void write(const Dungeon& aDungeon, const std::string& aPath) {
+        std::vector<RoomRecord> rooms;
+        std::vector<EdgeRecord> edges;
+        rooms.reserve(aDungeon.getRoomCount());
+
+        EntityWriter entityWriter(*this);
+        for (const Room* room : aDungeon.getRooms()) {
+            RoomRecord record{};
+            record.fName = addText(room->getName());
+            record.fDescription = addColdText(room->getDescriptionText());
+            record.fFirstEntity = fEntities.size();
+            record.fEntityCount = static_cast<uint32_t>(room->getEntities().size());
+            for (Entity* entity : room->getEntities()) {
+                if (entity->getId() != fEntities.size()) {
+                    throw std::runtime_error("DungeonFile: dungeon must be indexed before saving");
+                }
+                entity->accept(entityWriter);
+            }
+            record.fFirstEdge = edges.size();
+            RoomView doors = room->getConnectedRooms();
+            record.fEdgeCount = static_cast<uint32_t>(doors.size());
+            for (size_t i = 0; i < doors.size(); ++i) {
+                std::string_view key = SymbolTable::global().resolve(doors.getKey(i));
+                edges.push_back(EdgeRecord{doors.getRoomId(i), addText(room->getDoorName(i)), addText(key)});
+            }
+            rooms.push_back(record);
+        }
+        if (fCompressText) {
+            encodeColdText(rooms);
+        }
+
+        Header header{};
+        std::memcpy(header.fMagic, kMagic, sizeof(kMagic));
+        header.fVersion = kVersion;
+        header.fEntrance = aDungeon.getEntrance() ? static_cast<uint32_t>(aDungeon.getEntrance()->getId()) : 0;
+        header.fRoomCount = rooms.size();
+        header.fEntityCount = fEntities.size();
+        header.fEdgeCount = edges.size();
+        header.fRoomOffset = align8(sizeof(Header));
+        header.fEntityOffset = align8(header.fRoomOffset + rooms.size() * sizeof(RoomRecord));
+        header.fEdgeOffset = align8(header.fEntityOffset + fEntities.size() * sizeof(EntityRecord));
+        header.fTextOffset = align8(header.fEdgeOffset + edges.size() * sizeof(EdgeRecord));
+        header.fTextSize = fText.size();
+        header.fColdOffset = header.fTextOffset + fText.size();
+        header.fColdSize = fColdText.size();
+        header.fDictionaryOffset = header.fColdOffset + fColdText.size();
+        header.fDictionarySize = fDictionary.size();
+
+        std::ofstream file(aPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("DungeonFile: cannot create " + aPath);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeTable(file, rooms, header.fRoomOffset);
+        writeTable(file, fEntities, header.fEntityOffset);
+        writeTable(file, edges, header.fEdgeOffset);
+        file.seekp(static_cast<std::streamoff>(header.fTextOffset));
+        file.write(fText.data(), static_cast<std::streamsize>(fText.size()));
+        file.write(fColdText.data(), static_cast<std::streamsize>(fColdText.size()));
+        file.write(fDictionary.data(), static_cast<std::streamsize>(fDictionary.size()));
+        if (!file) {
+            throw std::runtime_error("DungeonFile: error writing " + aPath);
+        }
+    }
+};
+
+/**
+ * Read-only memory mapping of a whole file
+ */
+class MappedFile {
+private:
+    const char* fData;
+    size_t fSize;
+
+public:
+    explicit MappedFile(const std::string& aPath) : fData(nullptr), fSize(0) {
+        int fd = ::open(aPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("DungeonFile: cannot open " + aPath);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error("DungeonFile: cannot read " + aPath);
+        }
+        fSize = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("DungeonFile: cannot map " + aPath);
+        }
+        fData = static_cast<const char*>(data);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        ::munmap(const_cast<char*>(fData), fSize);
+    }
+
+    const char* getData() const { return fData; }
+    size_t getSize() const { return fSize; }
+};
+
+/**
+ * Builds a Dungeon over a mapped file without copying any text: names,
+ * descriptions and door labels are string_views into the mapping, which the
+ * Dungeon keeps alive. Pages are only read when their text is first used.
+ * Compressed text stays compressed in the mapping and is decoded whenever it
+ * is read (see StoredText). The cold section is checked to decode when the
+ * file is opened, and each compressed text when it is referenced, so a
+ * corrupt file throws here instead of when its text is shown.
+ * load() builds every room and entity up front. Entity names and door
+ * labels are interned in the process-wide SymbolTable as they are built,
+ * and interned text is never freed: each file loaded grows the table by
+ * the names it does not share with earlier ones, for the rest of the
+ * process. Large files that are only partly played are better opened with
+ * loadPagedDungeon() (RoomPager.h), which interns the names of a room's
+ * entities only when the room is first paged in.
+ */
+class Loader {
+private:
+    std::shared_ptr<MappedFile> fFile;
+    const Header* fHeader;
+    std::string_view fText;
+    std::shared_ptr<ColdTextStore> fColdText;  // Files with compressed text only
+
+    template <typename T>
+    const T* table(uint64_t aOffset, uint64_t aCount) const {
+        if (aOffset % alignof(T) != 0 || aOffset > fFile->getSize() ||
+            aCount > (fFile->getSize() - aOffset) / sizeof(T)) {
+            throw std::runtime_error("DungeonFile: table out of bounds");
+        }
+        return reinterpret_cast<const T*>(fFile->getData() + aOffset);
+    }
+
+public:
+    explicit Loader(const std::string& aPath)
+        : fFile(std::make_shared<MappedFile>(aPath)), fHeader(nullptr) {
+        if (fFile->getSize() < sizeof(Header)) {
+            throw std::runtime_error("DungeonFile: file too small");
+        }
+        fHeader = reinterpret_cast<const Header*>(fFile->getData());
+        if (std::memcmp(fHeader->fMagic, kMagic, sizeof(kMagic)) != 0 || fHeader->fVersion != kVersion) {
+            throw std::runtime_error("DungeonFile: not a dungeon file or unsupported version");
+        }
+        const char* textStart = table<char>(fHeader->fTextOffset, fHeader->fTextSize);
+        fText = std::string_view(textStart, fHeader->fTextSize);
+        if (fHeader->fDictionarySize > 0) {
+            std::string_view dictionary(table<char>(fHeader->fDictionaryOffset, fHeader->fDictionarySize),
+                                        fHeader->fDictionarySize);
+            std::string_view coldText(table<char>(fHeader->fColdOffset, fHeader->fColdSize), fHeader->fColdSize);
+            TextDictionary words = TextDictionary::deserialize(dictionary);
+            if (!words.isValid(coldText)) {
+                throw std::runtime_error("DungeonFile: malformed compressed text");
+            }
+            fColdText = std::make_shared<ColdTextStore>(std::move(words), coldText, fFile);
+        }
+    }
+
+    // The file's tables and text, read in place (for loaders of their own,
+    // such as RoomPager)
+    const Header& getHeader() const { return *fHeader; }
+    const std::shared_ptr<MappedFile>& getFile() const { return fFile; }
+    const std::shared_ptr<ColdTextStore>& getColdText() const { return fColdText; }
+
+    const RoomRecord* getRoomRecords() const {
+        return table<RoomRecord>(fHeader->fRoomOffset, fHeader->fRoomCount);
+    }
+
+    const EntityRecord* getEntityRecords() const {
+        return table<EntityRecord>(fHeader->fEntityOffset, fHeader->fEntityCount);
+    }
+
+    const EdgeRecord* getEdgeRecords() const {
+        return table<EdgeRecord>(fHeader->fEdgeOffset, fHeader->fEdgeCount);
+    }
+
+    std::string_view text(const TextRef& aRef) const {
+        if (aRef.fEncoding != kPlain) {
+            throw std::runtime_error("DungeonFile: unexpected compressed text");
+        }
+        if (aRef.fOffset > fText.size() || aRef.fLength > fText.size() - aRef.fOffset) {
+            throw std::runtime_error("DungeonFile: text out of bounds");
+        }
+        return fText.substr(aRef.fOffset, aRef.fLength);
+    }
+
+    // Text that may be compressed (descriptions and hidden info); compressed
+    // text is checked to decode, so reading it later cannot fail
+    StoredText storedText(const TextRef& aRef) const {
+        if (aRef.fEncoding != kCompressed) {
+            return text(aRef);
+        }
+        if (!fColdText) {
+            throw std::runtime_error("DungeonFile: compressed text without a dictionary");
+        }
+        if (!fColdText->isValid(aRef.fOffset, aRef.fLength)) {
+            throw std::runtime_error("DungeonFile: malformed compressed text");
+        }
+        return fColdText->get(aRef.fOffset, aRef.fLength);
+    }
+
+    Dungeon load() const {
+        const RoomRecord* rooms = getRoomRecords();
+        const EntityRecord* entities = getEntityRecords();
+        const EdgeRecord* edges = getEdgeRecords();
+
+        Dungeon dungeon;
+        dungeon.adoptExternalText(fFile);
+        if (fColdText) {
+            dungeon.adoptExternalText(fColdText);
+        }
+        dungeon.reserve(fHeader->fRoomCount, fHeader->fEntityCount);
+
+        for (uint64_t i = 0; i < fHeader->fRoomCount; ++i) {
+            const RoomRecord& record = rooms[i];
+            Room* room = dungeon.createRoomView(text(record.fName), storedText(record.fDescription));
+            if (record.fFirstEntity > fHeader->fEntityCount ||
+                record.fEntityCount > fHeader->fEntityCount - record.fFirstEntity) {
+                throw std::runtime_error("DungeonFile: entity range out of bounds");
+            }
+            for (uint32_t e = 0; e < record.fEntityCount; ++e) {
+                const EntityRecord& entity = entities[record.fFirstEntity + e];
+                std::string_view name = text(entity.fName);
+                StoredText description = storedText(entity.fDescription);
+                switch (entity.fKind) {
+                    case kMonster:
+                        room->addEntity(dungeon.createEntity<Monster>(name, description, entity.fStatA, entity.fStatB));
+                        break;
+                    case kItem:
+                        room->addEntity(dungeon.createEntity<Item>(name, description, entity.fStatA));
+                        break;
+                    case kClue:
+                        room->addEntity(dungeon.createEntity<Clue>(name, description, storedText(entity.fHiddenInfo)));
+                        break;
+                    default:
+                        throw std::runtime_error("DungeonFile: unknown entity kind");
+                }
+            }
+        }
+
+        // Doors need every room to exist first
+        const std::vector<Room*>& created = dungeon.getRooms();
+        for (uint64_t i = 0; i < fHeader->fRoomCount; ++i) {
+            const RoomRecord& record = rooms[i];
+            if (record.fFirstEdge > fHeader->fEdgeCount ||
+                record.fEdgeCount > fHeader->fEdgeCount - record.fFirstEdge) {
+                throw std::runtime_error("DungeonFile: door range out of bounds");
+            }
+            for (uint32_t e = 0; e < record.fEdgeCount; ++e) {
+                const EdgeRecord& edge = edges[record.fFirstEdge + e];
+                if (edge.fTarget >= created.size()) {
+                    throw std::runtime_error("DungeonFile: door leads to unknown room");
+                }
+                dungeon.connectRooms(created[i], created[edge.fTarget], text(edge.fDoorName), text(edge.fKey));
+            }
+        }
+
+        if (fHeader->fRoomCount > 0) {
+            if (fHeader->fEntrance >= created.size()) {
+                throw std::runtime_error("DungeonFile: unknown entrance room");
+            }
+            dungeon.setEntrance(created[fHeader->fEntrance]);
+        }
+        dungeon.buildIndex();
+        return dungeon;
+    }
+};
+
+}  // namespace DungeonFile
+
+// Save a dungeon to a binary file
+inline void saveDungeon(const Dungeon& aDungeon, const std::string& aPath, bool aCompressText = false) {
+    DungeonFile::Writer(aCompressText).write(aDungeon, aPath);
+}
+
+// Map a binary dungeon file and build a Dungeon that references its text in place
+inline Dungeon loadDungeon(const std::string& aPath) {
+    return DungeonFile::Loader(aPath).load();
+}
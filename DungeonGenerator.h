@@ -0,0 +1,369 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include "Dungeon.h"
+#include "WorkStealingPool.h"
+
+/**
+ * Settings for a generated dungeon
+ * Every room below the maximum depth gets between fMinBranching and
+ * fMaxBranching children, so a full tree has about
+ * (b^(depth+1) - 1) / (b - 1) rooms for branching factor b.
+ */
+struct GeneratorConfig {
+    uint64_t fSeed = 1;
+    unsigned fMinBranching = 1;
+    unsigned fMaxBranching = 3;
+    unsigned fDepth = 6;             // Depth of the deepest rooms (the entrance is depth 0)
+    unsigned fMaxEntitiesPerRoom = 3;  // Each room gets 0..max entities
+    unsigned fMonsterPercent = 40;   // Entity mix; the rest after items are clues
+    unsigned fItemPercent = 35;
+    size_t fThreads = 1;             // Worker threads; does not affect the result
+};
+
+/**
+ * Seeded, deterministic procedural dungeon generator
+ * Each room draws its layout from its own random stream, seeded from its
+ * parent's seed and its position among the siblings, so the result depends
+ * only on the configuration. The tree is cut at the first depth with enough
+ * rooms to keep all threads busy; the subtrees below that depth are generated
+ * in parallel as compact specs and then built into the Dungeon in pre-order,
+ * giving the same rooms, entities and entity ids on any thread count.
+ * Room text comes from static tables and is referenced, not copied; only room
+ * names are formatted into the dungeon's arena.
+ */
+class DungeonGenerator {
+private:
+    // Compact description of one entity
+    struct EntitySpec {
+        uint8_t fKind;      // 0 = monster, 1 = item, 2 = clue
+        uint8_t fTemplate;  // Index into the kind's text table
+        int fStatA;         // Monster health / item value
+        int fStatB;         // Monster damage
+    };
+
+    // Compact description of one room; children follow it in pre-order
+    struct RoomSpec {
+        uint64_t fSeed;
+        uint32_t fFirstEntity;
+        uint16_t fEntityCount;
+        uint16_t fChildCount;
+        uint8_t fAdjective;
+        uint8_t fNoun;
+        uint8_t fDescription;
+        int32_t fSubtree;  // Index of the parallel job holding this room and its subtree, or -1
+    };
+
+    struct SubtreeSpec {
+        std::vector<RoomSpec> fRooms;
+        std::vector<EntitySpec> fEntities;
+    };
+
+    struct SubtreeJob {
+        uint64_t fSeed;
+        unsigned fDepth;
+    };
+
+    struct TextTemplate {
+        std::string_view fName;
+        std::string_view fDescription;
+    };
+
+    static constexpr std::string_view kAdjectives[] = {
+        "Flooded", "Forgotten", "Crumbling", "Silent", "Burning", "Frozen", "Gilded", "Hollow",
+        "Sunken", "Echoing", "Overgrown", "Shadowed"};
+    static constexpr std::string_view kNouns[] = {
+        "Crypt", "Gallery", "Shrine", "Cistern", "Armory", "Library", "Chapel", "Ossuary",
+        "Workshop", "Catacomb", "Observatory", "Barracks"};
+    static constexpr std::string_view kRoomDescriptions[] = {
+        "Water drips from cracked stone into shallow pools on the floor.",
+        "Dust lies thick over everything; nobody has been here in centuries.",
+        "Faded murals cover the walls, telling of a war long forgotten.",
+        "Roots have forced their way through the ceiling and split the flagstones.",
+        "A cold draft whistles through the room from somewhere unseen.",
+        "Rows of empty niches line the walls, their contents long looted."};
+    static constexpr std::string_view kDoorNames[] = {
+        "North Door", "East Door", "South Door", "West Door", "Stairway Down", "Narrow Tunnel",
+        "Iron Gate", "Collapsed Arch"};
+    static constexpr TextTemplate kMonsters[] = {
+        {"Cave Rat", "A rat the size of a dog."},
+        {"Giant Spider", "A massive spider with gleaming red eyes."},
+        {"Skeleton Warrior", "An undead warrior wielding a rusty sword."},
+        {"Shadow Beast", "A creature made of living darkness."}};
+    static constexpr TextTemplate kItems[] = {
+        {"Silver Coins", "A pouch of ancient silver coins."},
+        {"Golden Amulet", "A beautiful amulet encrusted with gems."},
+        {"Health Potion", "A shimmering red potion that restores vitality."},
+        {"Jeweled Dagger", "A ceremonial dagger with a ruby in its hilt."}};
+    struct ClueTemplate {
+        std::string_view fName;
+        std::string_view fDescription;
+        std::string_view fHiddenInfo;
+    };
+    static constexpr ClueTemplate kClues[] = {
+        {"Stone Tablet", "An ancient stone tablet with carved inscriptions.",
+         "The inscription warns of guardians in the deeper halls."},
+        {"Dusty Journal", "A journal left by a previous adventurer.",
+         "The last pages describe a hidden way further down."},
+        {"Faded Map", "A brittle map drawn on leather.",
+         "The map marks a treasure room two doors below."}};
+
+    template <typename T, size_t N>
+    static constexpr size_t countOf(const T (&)[N]) { return N; }
+
+    const GeneratorConfig fConfig;
+
+    // SplitMix64: small, fast and good enough to derive independent streams
+    static uint64_t mix(uint64_t aValue) {
+        aValue += 0x9E3779B97F4A7C15ull;
+        aValue = (aValue ^ (aValue >> 30)) * 0xBF58476D1CE4E5B9ull;
+        aValue = (aValue ^ (aValue >> 27)) * 0x94D049BB133111EBull;
+        return aValue ^ (aValue >> 31);
+    }
+
+    class Random {
+    private:
+        uint64_t fState;
+
+    public:
+        explicit Random(uint64_t aSeed) : fState(aSeed) {}
+
+        uint64_t next() {
+            fState += 0x9E3779B97F4A7C15ull;
+            return mix(fState);
+        }
+
+        // Uniform in [aLow, aHigh]
+        unsigned range(unsigned aLow, unsigned aHigh) {
+            return aHigh <= aLow ? aLow : aLow + static_cast<unsigned>(next() % (aHigh - aLow + 1));
+        }
+    };
+
+    static uint64_t childSeed(uint64_t aParentSeed, unsigned aChildIndex) {
+        return mix(aParentSeed ^ mix(aChildIndex + 1));
+    }
+
+    // Draw one room's own layout (not its children's)
+    RoomSpec makeRoom(uint64_t aSeed, unsigned aDepth, std::vector<EntitySpec>& aEntities) const {
+        Random random(aSeed);
+        RoomSpec room{};
+        room.fSeed = aSeed;
+        room.fSubtree = -1;
+        room.fAdjective = static_cast<uint8_t>(random.range(0, countOf(kAdjectives) - 1));
+        room.fNoun = static_cast<uint8_t>(random.range(0, countOf(kNouns) - 1));
+        room.fDescription = static_cast<uint8_t>(random.range(0, countOf(kRoomDescriptions) - 1));
+        room.fChildCount = aDepth < fConfig.fDepth
+            ? static_cast<uint16_t>(random.range(fConfig.fMinBranching, fConfig.fMaxBranching))
+            : 0;
+
+        room.fFirstEntity = static_cast<uint32_t>(aEntities.size());
+        room.fEntityCount = static_cast<uint16_t>(random.range(0, fConfig.fMaxEntitiesPerRoom));
+        for (unsigned i = 0; i < room.fEntityCount; ++i) {
+            EntitySpec entity{};
+            unsigned roll = random.range(0, 99);
+            if (roll < fConfig.fMonsterPercent) {
+                entity.fKind = 0;
+                entity.fTemplate = static_cast<uint8_t>(random.range(0, countOf(kMonsters) - 1));
+                entity.fStatA = static_cast<int>(random.range(20, 40) + 5 * aDepth);
+                entity.fStatB = static_cast<int>(random.range(5, 15) + aDepth);
+            } else if (roll < fConfig.fMonsterPercent + fConfig.fItemPercent) {
+                entity.fKind = 1;
+                entity.fTemplate = static_cast<uint8_t>(random.range(0, countOf(kItems) - 1));
+                entity.fStatA = static_cast<int>(random.range(10, 100) * (1 + aDepth / 2));
+            } else {
+                entity.fKind = 2;
+                entity.fTemplate = static_cast<uint8_t>(random.range(0, countOf(kClues) - 1));
+            }
+            aEntities.push_back(entity);
+        }
+        return room;
+    }
+
+    // Generate a whole subtree in pre-order
+    void generateSubtree(uint64_t aSeed, unsigned aDepth, SubtreeSpec& aOut) const {
+        aOut.fRooms.push_back(makeRoom(aSeed, aDepth, aOut.fEntities));
+        unsigned childCount = aOut.fRooms.back().fChildCount;
+        for (unsigned i = 0; i < childCount; ++i) {
+            generateSubtree(childSeed(aSeed, i), aDepth + 1, aOut);
+        }
+    }
+
+    // Generate the rooms above the split depth; rooms at the split depth
+    // become parallel jobs and appear here only as placeholders
+    void generateTop(uint64_t aSeed, unsigned aDepth, unsigned aSplitDepth,
+                     SubtreeSpec& aTop, std::vector<SubtreeJob>& aJobs) const {
+        if (aDepth == aSplitDepth) {
+            RoomSpec placeholder{};
+            placeholder.fSubtree = static_cast<int32_t>(aJobs.size());
+            aTop.fRooms.push_back(placeholder);
+            aJobs.push_back(SubtreeJob{aSeed, aDepth});
+            return;
+        }
+        aTop.fRooms.push_back(makeRoom(aSeed, aDepth, aTop.fEntities));
+        unsigned childCount = aTop.fRooms.back().fChildCount;
+        for (unsigned i = 0; i < childCount; ++i) {
+            generateTop(childSeed(aSeed, i), aDepth + 1, aSplitDepth, aTop, aJobs);
+        }
+    }
+
+    // Shallowest depth with enough rooms to give every thread several jobs
+    unsigned chooseSplitDepth() const {
+        if (fConfig.fThreads <= 1) {
+            return 0;
+        }
+        const size_t target = fConfig.fThreads * 8;
+        std::vector<uint64_t> level{mix(fConfig.fSeed)};
+        std::vector<EntitySpec> scratch;
+        for (unsigned depth = 0; depth < fConfig.fDepth; ++depth) {
+            if (level.size() >= target) {
+                return depth;
+            }
+            std::vector<uint64_t> next;
+            for (uint64_t seed : level) {
+                scratch.clear();
+                unsigned childCount = makeRoom(seed, depth, scratch).fChildCount;
+                for (unsigned i = 0; i < childCount; ++i) {
+                    next.push_back(childSeed(seed, i));
+                }
+            }
+            level.swap(next);
+        }
+        return fConfig.fDepth;
+    }
+
+    // Builds specs into the dungeon, connecting each room to its pre-order parent
+    class Builder {
+    private:
+        Dungeon& fDungeon;
+        struct OpenRoom {
+            Room* fRoom;
+            unsigned fRemaining;
+            unsigned fNextDoor;
+        };
+        std::vector<OpenRoom> fStack;
+        size_t fRoomNumber;
+
+    public:
+        explicit Builder(Dungeon& aDungeon) : fDungeon(aDungeon), fRoomNumber(0) {}
+
+        void add(const RoomSpec& aSpec, const std::vector<EntitySpec>& aEntities) {
+            char name[64];
+            int length = std::snprintf(name, sizeof(name), "%.*s %.*s %zu",
+                static_cast<int>(kAdjectives[aSpec.fAdjective].size()), kAdjectives[aSpec.fAdjective].data(),
+                static_cast<int>(kNouns[aSpec.fNoun].size()), kNouns[aSpec.fNoun].data(), ++fRoomNumber);
+            Room* room = fDungeon.createRoomView(fDungeon.storeText(std::string_view(name, static_cast<size_t>(length))),
+                                                 kRoomDescriptions[aSpec.fDescription]);
+
+            for (uint32_t i = 0; i < aSpec.fEntityCount; ++i) {
+                const EntitySpec& entity = aEntities[aSpec.fFirstEntity + i];
+                if (entity.fKind == 0) {
+                    const TextTemplate& text = kMonsters[entity.fTemplate];
+                    room->addEntity(fDungeon.createEntity<Monster>(text.fName, text.fDescription, entity.fStatA, entity.fStatB));
+                } else if (entity.fKind == 1) {
+                    const TextTemplate& text = kItems[entity.fTemplate];
+                    room->addEntity(fDungeon.createEntity<Item>(text.fName, text.fDescription, entity.fStatA));
+                } else {
+                    const ClueTemplate& text = kClues[entity.fTemplate];
+                    room->addEntity(fDungeon.createEntity<Clue>(text.fName, text.fDescription, text.fHiddenInfo));
+                }
+            }
+
+            if (fStack.empty()) {
+                fDungeon.setEntrance(room);
+            } else {
+                OpenRoom& parent = fStack.back();
+                fDungeon.connectRooms(parent.fRoom, room, kDoorNames[parent.fNextDoor++ % countOf(kDoorNames)]);
+                if (--parent.fRemaining == 0) {
+                    fStack.pop_back();
+                }
+            }
+            if (aSpec.fChildCount > 0) {
+                fStack.push_back(OpenRoom{room, aSpec.fChildCount, 0});
+            }
+        }
+    };
+
+public:
+    explicit DungeonGenerator(const GeneratorConfig& aConfig) : fConfig(aConfig) {}
+
+    Dungeon generate() const {
+        unsigned splitDepth = chooseSplitDepth();
+        SubtreeSpec top;
+        std::vector<SubtreeJob> jobs;
+        generateTop(mix(fConfig.fSeed), 0, splitDepth, top, jobs);
+
+        std::vector<SubtreeSpec> subtrees(jobs.size());
+        if (fConfig.fThreads <= 1) {
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                generateSubtree(jobs[i].fSeed, jobs[i].fDepth, subtrees[i]);
+            }
+        } else {
+            WorkStealingPool pool(fConfig.fThreads);
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                pool.submit([this, &jobs, &subtrees, i] {
+                    generateSubtree(jobs[i].fSeed, jobs[i].fDepth, subtrees[i]);
+                });
+            }
+            pool.wait();
+        }
+
+        size_t roomCount = top.fRooms.size();
+        size_t entityCount = top.fEntities.size();
+        for (const SubtreeSpec& subtree : subtrees) {
+            roomCount += subtree.fRooms.size();
+            entityCount += subtree.fEntities.size();
+        }
+
+        Dungeon dungeon;
+        dungeon.reserve(roomCount, entityCount);
+        Builder builder(dungeon);
+        for (const RoomSpec& spec : top.fRooms) {
+            if (spec.fSubtree < 0) {
+                builder.add(spec, top.fEntities);
+                continue;
+            }
+            SubtreeSpec& subtree = subtrees[static_cast<size_t>(spec.fSubtree)];
+            for (const RoomSpec& room : subtree.fRooms) {
+                builder.add(room, subtree.fEntities);
+            }
+            subtree = SubtreeSpec();  // Release the spec memory early
+        }
+        dungeon.buildIndex();
+        return dungeon;
+    }
+};
+
+// Order-sensitive hash of a dungeon's rooms, doors and entities, e.g. to check
+// that a seed produces the same dungeon on different thread counts
+inline uint64_t dungeonFingerprint(const Dungeon& aDungeon) {
+    uint64_t hash = 1469598103934665603ull;  // FNV-1a
+    auto addText = [&hash](std::string_view aText) {
+        for (char c : aText) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ull;
+    };
+    struct StatsHasher : EntityVisitor {
+        uint64_t& fHash;
+        explicit StatsHasher(uint64_t& aHash) : fHash(aHash) {}
+        void add(int aValue) { fHash = (fHash ^ static_cast<uint32_t>(aValue)) * 1099511628211ull; }
+        void visitMonster(Monster& aMonster) override { add(aMonster.getHealth()); add(aMonster.getDamage()); }
+        void visitItem(Item& aItem) override { add(aItem.getValue()); }
+        void visitClue(Clue& aClue) override { add(static_cast<int>(aClue.getHiddenInfo().size())); }
+    } stats(hash);
+
+    for (const Room* room : aDungeon.getRooms()) {
+        addText(room->getName());
+        addText(room->getDescription());
+        for (Entity* entity : room->getEntities()) {
+            addText(entity->getName());
+            entity->accept(stats);
+        }
+        for (const Room* child : room->getConnectedRooms()) {
+            addText(child->getName());
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,417 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Player.h"
+#include "Room.h"
+#include "Dungeon.h"
+#include "SessionState.h"
+#include "ActionJournal.h"
+#include "WorkStealingPool.h"
+
+/**
+ * Best score a player can reach in a dungeon without dying, and how
+ *
+ * When the doors the player can use have no cycles, every room is entered at
+ * most once with its entities untouched. The rest of
+ * a game then depends only on (room, player health), and that pair is the
+ * whole search state:
+ * - items with a positive value and unexamined clues cost nothing and are
+ *   always taken
+ * - fighting a monster to the end costs (ceil(health / attack) - 1) * damage
+ *   whatever else happens, and every kill is worth the same, so in each room
+ *   only "kill the k cheapest monsters" needs to be considered
+ * - the player then moves through one door or stops
+ * Attacking a monster without finishing it only loses health and is never
+ * part of an optimal game.
+ *
+ * States are memoized in a transposition table keyed by Zobrist hashes
+ * (a random key per room xor one per health value) and split into
+ * mutex-protected shards. The search expands the states near the entrance
+ * breadth-first until there are enough of them, solves those on a
+ * WorkStealingPool sharing the table, then finishes the top levels from the
+ * cached results. Solving uses an explicit stack, so deep dungeons are fine.
+ *
+ * Locked doors are only used if the player starts with their key, as keys
+ * picked up on the way would make the inventory part of the state.
+ * When the usable doors do form cycles (two-way doors, loops), revisiting a
+ * room would make the rooms already cleared part of the state too. The
+ * solver then leaves out the doors that lead back: the back edges of a
+ * depth-first search from the entrance, without which the doors have no
+ * cycle. Every room is still reachable, the game found is still a real
+ * game, but a better one may need a door that was left out, so the score
+ * is only a lower bound (Result::fIsExact is false).
+ * The dungeon must have been indexed with Dungeon::buildIndex().
+ */
+class DungeonSolver {
+public:
+    static constexpr uint32_t kNoDoor = UINT32_MAX;
+
+    struct Result {
+        int64_t fScore = 0;            // Final score of the best game
+        int fHealth = 0;               // Player health at the end of it
+        ActionJournal fJournal;        // Actions that reach it from the entrance
+        std::vector<Room*> fRoute;     // Rooms visited, entrance first
+        size_t fStates = 0;            // Distinct states solved
+        bool fIsExact = true;          // False if doors leading back were left out
+    };
+
+private:
+    static constexpr size_t kShardCount = 64;
+    static constexpr size_t kMaxSplitDepth = 16;
+
+    struct State {
+        uint32_t fRoom;
+        int fHealth;
+
+        bool operator==(const State& aOther) const {
+            return fRoom == aOther.fRoom && fHealth == aOther.fHealth;
+        }
+    };
+
+    // Best continuation from entering a room with some health
+    struct Entry {
+        int64_t fGain;     // Score gained from here on
+        uint32_t fKills;   // Cheapest monsters to kill in this room
+        uint32_t fDoor;    // Door to take afterwards, or kNoDoor to stop
+    };
+
+    // Zobrist key of a state: the room's random key xor the health's
+    struct ZobristHash {
+        const DungeonSolver* fSolver;
+
+        explicit ZobristHash(const DungeonSolver* aSolver) : fSolver(aSolver) {}
+
+        size_t operator()(const State& aState) const {
+            return static_cast<size_t>(fSolver->fRoomKeys[aState.fRoom] ^ fSolver->fHealthKeys[aState.fHealth]);
+        }
+    };
+
+    struct Shard {
+        std::mutex fMutex;
+        std::unordered_map<State, Entry, ZobristHash> fEntries;
+
+        Shard() : fEntries(0, ZobristHash(nullptr)) {}
+    };
+
+    const Dungeon& fDungeon;
+    const Player& fPlayer;
+    std::vector<int64_t> fFreeScore;    // Item values and clue points, by room id
+    std::vector<size_t> fFirstKill;     // Room's range in fKillCost/fKillEntity (CSR)
+    std::vector<int> fKillCost;         // Cumulative cost of the k cheapest monsters
+    std::vector<uint32_t> fKillEntity;  // Entity index of the k-th cheapest monster
+    std::vector<uint32_t> fKillTurns;   // Attacks needed to kill it
+    std::vector<uint64_t> fRoomKeys;
+    std::vector<uint64_t> fHealthKeys;
+    std::unordered_set<uint64_t> fBackDoors;  // (room << 32 | door) of the doors left out
+    std::unique_ptr<Shard[]> fShards;
+
+    static uint64_t mix(uint64_t aValue) {
+        aValue += 0x9E3779B97F4A7C15ull;
+        aValue = (aValue ^ (aValue >> 30)) * 0xBF58476D1CE4E5B9ull;
+        aValue = (aValue ^ (aValue >> 27)) * 0x94D049BB133111EBull;
+        return aValue ^ (aValue >> 31);
+    }
+
+    // Collects a room's free score and the cost of each monster fight
+    class RoomScanner : public EntityVisitor {
+    private:
+        int fAttackPower;
+
+    public:
+        int64_t fFreeScore = 0;
+        std::vector<std::pair<int, uint32_t>> fFights;  // (cost, turns) per live monster
+        std::vector<uint32_t> fFightEntity;
+        uint32_t fEntityIndex = 0;
+
+        explicit RoomScanner(int aAttackPower) : fAttackPower(aAttackPower) {}
+
+        void visitMonster(Monster& aMonster) override {
+            if (!aMonster.isAlive() || fAttackPower <= 0) {
+                return;
+            }
+            int64_t turns = (int64_t(aMonster.getHealth()) + fAttackPower - 1) / fAttackPower;
+            int64_t cost = (turns - 1) * std::max(aMonster.getDamage(), 0);
+            if (cost < std::numeric_limits<int>::max()) {
+                fFights.emplace_back(static_cast<int>(cost), static_cast<uint32_t>(turns));
+                fFightEntity.push_back(fEntityIndex);
+            }
+        }
+
+        void visitItem(Item& aItem) override {
+            if (!aItem.isCollected() && aItem.getValue() > 0) fFreeScore += aItem.getValue();
+        }
+
+        void visitClue(Clue& aClue) override {
+            if (!aClue.isExamined()) fFreeScore += 25;
+        }
+    };
+
+    // Same rules as RoomScanner, replayed to write the actions of one room
+    class RoomRecorder : public EntityVisitor {
+    private:
+        ActionJournal& fJournal;
+
+    public:
+        size_t fEntityIndex = 0;
+
+        explicit RoomRecorder(ActionJournal& aJournal) : fJournal(aJournal) {}
+
+        void visitMonster(Monster&) override {}
+
+        void visitItem(Item& aItem) override {
+            if (!aItem.isCollected() && aItem.getValue() > 0) fJournal.recordAction(fEntityIndex, ActionType::Collect);
+        }
+
+        void visitClue(Clue& aClue) override {
+            if (!aClue.isExamined()) fJournal.recordAction(fEntityIndex, ActionType::Examine);
+        }
+    };
+
+    RoomView doorsOf(uint32_t aRoom) const {
+        return fDungeon.getGraph().getDoors(aRoom);
+    }
+
+    static uint64_t doorKey(uint32_t aRoom, size_t aDoor) {
+        return uint64_t(aRoom) << 32 | aDoor;
+    }
+
+    bool canUse(uint32_t aRoom, const RoomView& aDoors, size_t aDoor) const {
+        if (aDoors.getKey(aDoor) != 0 && !fPlayer.getInventory().has(aDoors.getKey(aDoor))) {
+            return false;
+        }
+        return fBackDoors.empty() || fBackDoors.count(doorKey(aRoom, aDoor)) == 0;
+    }
+
+    // Depth-first search of the usable doors from the entrance; a door to a
+    // room still on the search path closes a cycle and is left out
+    void findBackDoors() {
+        Room* entrance = fDungeon.getEntrance();
+        if (!entrance) {
+            return;
+        }
+        enum : uint8_t { kUnseen, kOnPath, kDone };
+        std::vector<uint8_t> mark(fDungeon.getRoomCount(), kUnseen);
+        std::vector<std::pair<uint32_t, size_t>> path;  // (room, next door to try)
+        uint32_t root = static_cast<uint32_t>(entrance->getId());
+        mark[root] = kOnPath;
+        path.emplace_back(root, 0);
+        while (!path.empty()) {
+            auto& [room, door] = path.back();
+            RoomView doors = doorsOf(room);
+            if (door == doors.size()) {
+                mark[room] = kDone;
+                path.pop_back();
+                continue;
+            }
+            size_t current = door++;
+            if (!canUse(room, doors, current)) {
+                continue;
+            }
+            uint32_t next = doors.getRoomId(current);
+            if (mark[next] == kOnPath) {
+                fBackDoors.insert(doorKey(room, current));
+            } else if (mark[next] == kUnseen) {
+                mark[next] = kOnPath;
+                path.emplace_back(next, 0);
+            }
+        }
+    }
+
+    void scanRooms() {
+        size_t roomCount = fDungeon.getRoomCount();
+        fFreeScore.assign(roomCount, 0);
+        fFirstKill.assign(roomCount + 1, 0);
+        for (size_t id = 0; id < roomCount; ++id) {
+            fFirstKill[id] = fKillCost.size();
+            RoomScanner scanner(fPlayer.getAttackPower());
+            for (Entity* entity : fDungeon.getRooms()[id]->getEntities()) {
+                entity->accept(scanner);
+                ++scanner.fEntityIndex;
+            }
+            fFreeScore[id] = scanner.fFreeScore;
+
+            std::vector<size_t> order(scanner.fFights.size());
+            for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t aFirst, size_t aSecond) { return scanner.fFights[aFirst].first < scanner.fFights[aSecond].first; });
+            int64_t total = 0;
+            for (size_t i : order) {
+                total += scanner.fFights[i].first;
+                if (total >= std::numeric_limits<int>::max()) break;
+                fKillCost.push_back(static_cast<int>(total));
+                fKillEntity.push_back(scanner.fFightEntity[i]);
+                fKillTurns.push_back(scanner.fFights[i].second);
+            }
+        }
+        fFirstKill[roomCount] = fKillCost.size();
+    }
+
+    // The top bits of the key pick the shard, the low bits the bucket inside it
+    Shard& shardOf(const State& aState) const {
+        return fShards[(fRoomKeys[aState.fRoom] ^ fHealthKeys[aState.fHealth]) >> 58];
+    }
+
+    bool lookup(const State& aState, Entry& aEntry) const {
+        Shard& shard = shardOf(aState);
+        std::lock_guard<std::mutex> lock(shard.fMutex);
+        auto found = shard.fEntries.find(aState);
+        if (found == shard.fEntries.end()) {
+            return false;
+        }
+        aEntry = found->second;
+        return true;
+    }
+
+    void store(const State& aState, const Entry& aEntry) {
+        Shard& shard = shardOf(aState);
+        std::lock_guard<std::mutex> lock(shard.fMutex);
+        shard.fEntries.emplace(aState, aEntry);
+    }
+
+    // Number of monsters of a room that can be killed one after the other with
+    // aHealth left, including k = 0
+    size_t killOptions(uint32_t aRoom, int aHealth) const {
+        size_t options = 1;
+        for (size_t i = fFirstKill[aRoom]; i < fFirstKill[aRoom + 1] && fKillCost[i] < aHealth; ++i) ++options;
+        return options;
+    }
+
+    int healthAfter(uint32_t aRoom, size_t aKills, int aHealth) const {
+        return aKills ? aHealth - fKillCost[fFirstKill[aRoom] + aKills - 1] : aHealth;
+    }
+
+    // Solve a state and everything below it, depth first with an explicit stack
+    void solve(const State& aState) {
+        Entry entry;
+        std::vector<State> stack{aState};
+        while (!stack.empty()) {
+            State state = stack.back();
+            if (lookup(state, entry)) {
+                stack.pop_back();
+                continue;
+            }
+
+            // Push whatever successor is still unsolved; otherwise combine them
+            RoomView doors = doorsOf(state.fRoom);
+            size_t options = killOptions(state.fRoom, state.fHealth);
+            size_t stackSize = stack.size();
+            Entry best{-1, 0, kNoDoor};
+            for (size_t kills = 0; kills < options; ++kills) {
+                int health = healthAfter(state.fRoom, kills, state.fHealth);
+                int64_t gain = fFreeScore[state.fRoom] + int64_t(50) * kills;
+                if (gain > best.fGain) best = Entry{gain, static_cast<uint32_t>(kills), kNoDoor};
+                for (size_t door = 0; door < doors.size(); ++door) {
+                    if (!canUse(state.fRoom, doors, door)) continue;
+                    State next{doors.getRoomId(door), health};
+                    if (!lookup(next, entry)) {
+                        stack.push_back(next);
+                    } else if (gain + entry.fGain > best.fGain) {
+                        best = Entry{gain + entry.fGain, static_cast<uint32_t>(kills), static_cast<uint32_t>(door)};
+                    }
+                }
+            }
+            if (stack.size() == stackSize) {
+                store(state, best);
+                stack.pop_back();
+            }
+        }
+    }
+
+    // Successor states of a state, for the breadth-first split
+    void expand(const State& aState, std::unordered_set<State, ZobristHash>& aNext) const {
+        RoomView doors = doorsOf(aState.fRoom);
+        size_t options = killOptions(aState.fRoom, aState.fHealth);
+        for (size_t kills = 0; kills < options; ++kills) {
+            int health = healthAfter(aState.fRoom, kills, aState.fHealth);
+            for (size_t door = 0; door < doors.size(); ++door) {
+                if (canUse(aState.fRoom, doors, door)) aNext.insert(State{doors.getRoomId(door), health});
+            }
+        }
+    }
+
+public:
+    DungeonSolver(const Dungeon& aDungeon, const Player& aPlayer)
+        : fDungeon(aDungeon), fPlayer(aPlayer), fShards(new Shard[kShardCount]) {
+        findBackDoors();
+        scanRooms();
+        uint64_t seed = 0x5EED;
+        fRoomKeys.resize(aDungeon.getRoomCount());
+        for (uint64_t& key : fRoomKeys) key = mix(seed++);
+        fHealthKeys.resize(static_cast<size_t>(std::max(aPlayer.getHealth(), 0)) + 1);
+        for (uint64_t& key : fHealthKeys) key = mix(seed++);
+        for (size_t i = 0; i < kShardCount; ++i) {
+            fShards[i].fEntries = std::unordered_map<State, Entry, ZobristHash>(0, ZobristHash{this});
+        }
+    }
+
+    // Find the best game from the entrance, solving on aThreadCount threads
+    Result solve(size_t aThreadCount) {
+        Result result;
+        Room* entrance = fDungeon.getEntrance();
+        result.fScore = fPlayer.getScore();
+        result.fHealth = fPlayer.getHealth();
+        result.fIsExact = fBackDoors.empty();
+        if (!entrance || !fPlayer.isAlive()) {
+            return result;
+        }
+        uint32_t root = static_cast<uint32_t>(entrance->getId());
+
+        // Expand breadth-first until there is enough work to share out
+        std::unordered_set<State, ZobristHash> frontier(0, ZobristHash{this});
+        frontier.insert(State{root, fPlayer.getHealth()});
+        size_t target = aThreadCount * 8;
+        for (size_t depth = 0; aThreadCount > 1 && frontier.size() < target && depth < kMaxSplitDepth; ++depth) {
+            std::unordered_set<State, ZobristHash> next(0, ZobristHash{this});
+            for (const State& state : frontier) expand(state, next);
+            if (next.empty()) break;
+            frontier.swap(next);
+        }
+        if (frontier.size() > 1) {
+            WorkStealingPool pool(aThreadCount);
+            for (const State& state : frontier) {
+                pool.submit([this, state] { solve(state); });
+            }
+            pool.wait();
+        }
+        solve(State{root, fPlayer.getHealth()});
+
+        // Follow the stored choices to write the route and the actions
+        Entry entry;
+        uint32_t room = root;
+        int health = fPlayer.getHealth();
+        while (lookup(State{room, health}, entry)) {
+            Room* current = fDungeon.getRooms()[room];
+            result.fRoute.push_back(current);
+            RoomRecorder recorder(result.fJournal);
+            for (Entity* entity : current->getEntities()) {
+                entity->accept(recorder);
+                ++recorder.fEntityIndex;
+            }
+            for (size_t i = fFirstKill[room]; i < fFirstKill[room] + entry.fKills; ++i) {
+                for (uint32_t turn = 0; turn < fKillTurns[i]; ++turn) {
+                    result.fJournal.recordAction(fKillEntity[i], ActionType::Attack);
+                }
+            }
+            result.fScore += fFreeScore[room] + int64_t(50) * entry.fKills;
+            health = healthAfter(room, entry.fKills, health);
+            if (entry.fDoor == kNoDoor) {
+                break;
+            }
+            result.fJournal.recordMove(entry.fDoor);
+            room = doorsOf(room).getRoomId(entry.fDoor);
+        }
+        result.fHealth = health;
+        for (size_t i = 0; i < kShardCount; ++i) result.fStates += fShards[i].fEntries.size();
+        return result;
+    }
+};
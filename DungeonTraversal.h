@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Dungeon.h"
+#include "EntityVisitor.h"
+#include "WorkStealingPool.h"
+
+/**
+ * An EntityVisitor that is also told which room the entities it is about to
+ * visit are in (for example to group them by Dungeon::getIndex() depth)
+ */
+class DungeonVisitor : public EntityVisitor {
+public:
+    virtual void enterRoom(const Room& aRoom) = 0;
+};
+
+/**
+ * Applies entity visitors to every entity of a dungeon or of one subtree
+ *
+ * The rooms below a room are a contiguous range of the index's DFS preorder,
+ * so a subtree is walked as a range of room ids. In parallel the range is
+ * split in halves on a WorkStealingPool until pieces are at most the grain
+ * size: a worker keeps splitting the half it holds and queues the other, so
+ * idle workers steal the largest pieces (whole subtrees or runs of sibling
+ * subtrees) first. Each worker visits with a visitor of its own, made by a
+ * factory the first time it runs a piece; when everything is visited the
+ * visitors are folded into one result in worker order. Which worker visits
+ * which room is not fixed, so the fold must not depend on that split.
+ * Visitors of type DungeonVisitor get enterRoom() before a room's entities.
+ * Every entity is visited exactly once and by one thread, but entities are
+ * shared, so visitors that change them must not also read other rooms.
+ * Paged dungeons are walked on the calling thread, as reading them pages
+ * rooms in.
+ */
+class DungeonTraversal {
+public:
+    static constexpr size_t kDefaultGrain = 256;
+
+private:
+    const Dungeon& fDungeon;
+    size_t fGrain;  // Rooms per piece of parallel work
+
+    // Room ids of a subtree (aRoot set) or of every room, in visiting order
+    struct Range {
+        const uint32_t* fIds;  // Ids by position, or nullptr if position == id
+        size_t fBegin;
+        size_t fEnd;
+    };
+
+    Range rangeOf(const Room* aRoot) const {
+        if (!aRoot) {
+            return Range{nullptr, 0, fDungeon.getRoomCount()};
+        }
+        const RoomIndex& index = fDungeon.getIndex();
+        if (!index.isReachable(aRoot)) {
+            return Range{nullptr, 0, 0};
+        }
+        return Range{index.getPreorder().data(), index.getPreorderPosition(aRoot), index.getSubtreeEnd(aRoot)};
+    }
+
+    template <typename Visitor>
+    void visitRange(const Range& aRange, Visitor& aVisitor) const {
+        const std::vector<Room*>& rooms = fDungeon.getRooms();
+        for (size_t position = aRange.fBegin; position < aRange.fEnd; ++position) {
+            const Room& room = *rooms[aRange.fIds ? aRange.fIds[position] : position];
+            if constexpr (std::is_base_of<DungeonVisitor, Visitor>::value) {
+                aVisitor.enterRoom(room);
+            }
+            for (Entity* entity : room.getEntities()) {
+                entity->accept(aVisitor);
+            }
+        }
+    }
+
+    // Visit a range on a worker, queueing halves of it for other workers
+    template <typename VisitorPtr, typename MakeVisitor>
+    void visitPiece(Range aRange, WorkStealingPool& aPool, std::vector<VisitorPtr>& aVisitors,
+                    MakeVisitor& aMakeVisitor) const {
+        while (aRange.fEnd - aRange.fBegin > fGrain) {
+            size_t middle = aRange.fBegin + (aRange.fEnd - aRange.fBegin) / 2;
+            Range upper{aRange.fIds, middle, aRange.fEnd};
+            aPool.submit([this, upper, &aPool, &aVisitors, &aMakeVisitor] {
+                visitPiece(upper, aPool, aVisitors, aMakeVisitor);
+            });
+            aRange.fEnd = middle;
+        }
+        VisitorPtr& visitor = aVisitors[aPool.getWorkerIndex()];
+        if (!visitor) {
+            visitor = aMakeVisitor();
+        }
+        visitRange(aRange, *visitor);
+    }
+
+public:
+    explicit DungeonTraversal(const Dungeon& aDungeon, size_t aGrain = kDefaultGrain)
+        : fDungeon(aDungeon), fGrain(aGrain > 0 ? aGrain : 1) {}
+
+    // Visit every entity below aRoot (itself included) in preorder, or every
+    // entity of the dungeon in room order if aRoot is nullptr, on the calling
+    // thread. Subtrees follow the index's tree, so unreachable rooms are only
+    // visited without a root. The dungeon must have been indexed.
+    template <typename Visitor>
+    void visit(const Room* aRoot, Visitor& aVisitor) const {
+        visitRange(rangeOf(aRoot), aVisitor);
+    }
+
+    // Visit the same entities on aThreadCount workers. aMakeVisitor() returns
+    // a std::unique_ptr to a fresh visitor, called at most once per worker;
+    // aReduce(result, visitor) folds each worker's visitor into aInitial,
+    // which is then returned.
+    template <typename Result, typename MakeVisitor, typename Reduce>
+    Result reduce(const Room* aRoot, size_t aThreadCount, MakeVisitor aMakeVisitor, Result aInitial,
+                  Reduce aReduce) const {
+        using VisitorPtr = decltype(aMakeVisitor());
+        Range range = rangeOf(aRoot);
+        if (fDungeon.getLoader() || aThreadCount <= 1 || range.fEnd - range.fBegin <= fGrain) {
+            VisitorPtr visitor = aMakeVisitor();
+            visitRange(range, *visitor);
+            aReduce(aInitial, *visitor);
+            return aInitial;
+        }
+
+        std::vector<VisitorPtr> visitors(aThreadCount);
+        {
+            WorkStealingPool pool(aThreadCount);
+            pool.submit([&] { visitPiece(range, pool, visitors, aMakeVisitor); });
+            pool.wait();
+        }
+        for (VisitorPtr& visitor : visitors) {
+            if (visitor) {
+                aReduce(aInitial, *visitor);
+            }
+        }
+        return aInitial;
+    }
+};
@@ -1,5 +1,8 @@
 #pragma once
-#include <string>
+#include <cstddef>
+#include <string_view>
+#include "ColdText.h"
+#include "SymbolTable.h"
 
 // Forward declaration for Visitor pattern
 class EntityVisitor;
@@ -7,21 +10,29 @@ class EntityVisitor;
 /**
  * Abstract base class for all game entities
  * Uses the Visitor pattern to allow different actions to be performed on entities
+ * Text is not owned by the entity: the name is interned in the global
+ * SymbolTable and the description lives in the dungeon's arena, a file or a
+ * ColdTextStore, in which case getDescription() decodes it.
  */
 class Entity {
 protected:
-    std::string fName;
-    std::string fDescription;
+    Symbol fName;
+    StoredText fDescription;
+    size_t fId;  // Dense index assigned by Dungeon::indexEntities()
 
 public:
-    Entity(const std::string& aName, const std::string& aDescription)
-        : fName(aName), fDescription(aDescription) {}
+    Entity(std::string_view aName, StoredText aDescription)
+        : fName(SymbolTable::global().intern(aName)), fDescription(aDescription), fId(0) {}
 
     virtual ~Entity() = default;
 
     // Getter methods
-    const std::string& getName() const { return fName; }
-    const std::string& getDescription() const { return fDescription; }
+    std::string_view getName() const { return SymbolTable::global().resolve(fName); }
+    Symbol getNameSymbol() const { return fName; }
+    std::string_view getDescription() const { return fDescription.view(); }
+    const StoredText& getDescriptionText() const { return fDescription; }
+    size_t getId() const { return fId; }
+    void setId(size_t aId) { fId = aId; }
 
     // Accept method for Visitor pattern
     virtual void accept(EntityVisitor& aVisitor) = 0;
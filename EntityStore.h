@@ -0,0 +1,170 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <variant>
+#include <vector>
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Dungeon.h"
+
+/**
+ * Typed indices into the per-type arrays of an EntityStore
+ */
+struct MonsterHandle { uint32_t fIndex; };
+struct ItemHandle { uint32_t fIndex; };
+struct ClueHandle { uint32_t fIndex; };
+
+// A stored entity of any type; dispatch on it with std::visit
+using EntityHandle = std::variant<MonsterHandle, ItemHandle, ClueHandle>;
+
+/**
+ * Struct-of-arrays entity storage
+ * The fields actions touch (health, damage, value, collected/examined flags)
+ * are kept in contiguous per-type arrays instead of one heap object per
+ * entity. Entities built from a Dungeon remember their source object so that
+ * classic EntityVisitors can still be applied through accept().
+ */
+class EntityStore {
+private:
+    std::vector<int> fMonsterHealth;
+    std::vector<int> fMonsterDamage;
+    std::vector<Monster*> fMonsterSource;
+
+    std::vector<int> fItemValue;
+    std::vector<uint8_t> fItemCollected;
+    std::vector<Item*> fItemSource;
+
+    std::vector<uint8_t> fClueExamined;
+    std::vector<Clue*> fClueSource;
+
+    std::vector<EntityHandle> fHandles;  // In insertion order
+
+    // Copies a Dungeon's entities into the store in entity id order
+    class Importer : public EntityVisitor {
+    private:
+        EntityStore& fStore;
+
+    public:
+        Importer(EntityStore& aStore) : fStore(aStore) {}
+
+        void visitMonster(Monster& aMonster) override {
+            fStore.addMonster(aMonster.isAlive() ? aMonster.getHealth() : 0, aMonster.getDamage(), &aMonster);
+        }
+
+        void visitItem(Item& aItem) override {
+            fStore.addItem(aItem.getValue(), aItem.isCollected(), &aItem);
+        }
+
+        void visitClue(Clue& aClue) override {
+            fStore.addClue(aClue.isExamined(), &aClue);
+        }
+    };
+
+public:
+    // Build a store holding every indexed entity of a Dungeon; the handle at
+    // position i belongs to the entity with id i
+    static EntityStore fromDungeon(const Dungeon& aDungeon) {
+        EntityStore store;
+        store.reserve(aDungeon.getEntityCount(), aDungeon.getEntityCount(), aDungeon.getEntityCount());
+        Importer importer(store);
+        for (size_t i = 0; i < aDungeon.getEntityCount(); ++i) {
+            aDungeon.getEntity(i)->accept(importer);
+        }
+        return store;
+    }
+
+    void reserve(size_t aMonsters, size_t aItems, size_t aClues) {
+        fMonsterHealth.reserve(aMonsters);
+        fMonsterDamage.reserve(aMonsters);
+        fMonsterSource.reserve(aMonsters);
+        fItemValue.reserve(aItems);
+        fItemCollected.reserve(aItems);
+        fItemSource.reserve(aItems);
+        fClueExamined.reserve(aClues);
+        fClueSource.reserve(aClues);
+        fHandles.reserve(aMonsters + aItems + aClues);
+    }
+
+    MonsterHandle addMonster(int aHealth, int aDamage, Monster* aSource = nullptr) {
+        MonsterHandle handle{static_cast<uint32_t>(fMonsterHealth.size())};
+        fMonsterHealth.push_back(aHealth);
+        fMonsterDamage.push_back(aDamage);
+        fMonsterSource.push_back(aSource);
+        fHandles.push_back(handle);
+        return handle;
+    }
+
+    ItemHandle addItem(int aValue, bool aIsCollected = false, Item* aSource = nullptr) {
+        ItemHandle handle{static_cast<uint32_t>(fItemValue.size())};
+        fItemValue.push_back(aValue);
+        fItemCollected.push_back(aIsCollected);
+        fItemSource.push_back(aSource);
+        fHandles.push_back(handle);
+        return handle;
+    }
+
+    ClueHandle addClue(bool aIsExamined = false, Clue* aSource = nullptr) {
+        ClueHandle handle{static_cast<uint32_t>(fClueExamined.size())};
+        fClueExamined.push_back(aIsExamined);
+        fClueSource.push_back(aSource);
+        fHandles.push_back(handle);
+        return handle;
+    }
+
+    // Getter methods
+    const std::vector<EntityHandle>& getHandles() const { return fHandles; }
+    size_t getMonsterCount() const { return fMonsterHealth.size(); }
+    size_t getItemCount() const { return fItemValue.size(); }
+    size_t getClueCount() const { return fClueExamined.size(); }
+
+    // Hot fields
+    int& monsterHealth(MonsterHandle aHandle) { return fMonsterHealth[aHandle.fIndex]; }
+    int monsterDamage(MonsterHandle aHandle) const { return fMonsterDamage[aHandle.fIndex]; }
+    int itemValue(ItemHandle aHandle) const { return fItemValue[aHandle.fIndex]; }
+    bool isCollected(ItemHandle aHandle) const { return fItemCollected[aHandle.fIndex] != 0; }
+    void collect(ItemHandle aHandle) { fItemCollected[aHandle.fIndex] = 1; }
+    bool isExamined(ClueHandle aHandle) const { return fClueExamined[aHandle.fIndex] != 0; }
+    void examine(ClueHandle aHandle) { fClueExamined[aHandle.fIndex] = 1; }
+
+    // Source objects (nullptr for entities added without one)
+    Monster* getSource(MonsterHandle aHandle) const { return fMonsterSource[aHandle.fIndex]; }
+    Item* getSource(ItemHandle aHandle) const { return fItemSource[aHandle.fIndex]; }
+    Clue* getSource(ClueHandle aHandle) const { return fClueSource[aHandle.fIndex]; }
+
+    // Compatibility layer: apply a classic EntityVisitor to a stored entity.
+    // The stored state is copied into the source object, the visitor runs on
+    // it, and the (possibly changed) state is copied back.
+    void accept(EntityHandle aHandle, EntityVisitor& aVisitor) {
+        struct Bridge {
+            EntityStore& fStore;
+            EntityVisitor& fVisitor;
+
+            void operator()(MonsterHandle aMonster) {
+                Monster* source = fStore.getSource(aMonster);
+                assert(source && "entity was added without a source object");
+                source->setHealth(fStore.monsterHealth(aMonster));
+                source->accept(fVisitor);
+                fStore.monsterHealth(aMonster) = source->getHealth();
+            }
+
+            void operator()(ItemHandle aItem) {
+                Item* source = fStore.getSource(aItem);
+                assert(source && "entity was added without a source object");
+                source->setCollected(fStore.isCollected(aItem));
+                source->accept(fVisitor);
+                fStore.fItemCollected[aItem.fIndex] = source->isCollected();
+            }
+
+            void operator()(ClueHandle aClue) {
+                Clue* source = fStore.getSource(aClue);
+                assert(source && "entity was added without a source object");
+                source->setExamined(fStore.isExamined(aClue));
+                source->accept(fVisitor);
+                fStore.fClueExamined[aClue.fIndex] = source->isExamined();
+            }
+        };
+        std::visit(Bridge{*this, aVisitor}, aHandle);
+    }
+};
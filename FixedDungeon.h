@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Room.h"
+#include "Dungeon.h"
+
+/**
+ * Dungeons with fixed content declared as constexpr tables
+ *
+ * Rooms, entities and doors are listed in static read-only tables of views
+ * onto string literals, checked at compile time with isValid(). build()
+ * turns the tables into a Dungeon that references the table text in place
+ * (nothing is copied into the arena) and sizes every table and list from
+ * the compile-time counts, so the only work at startup is placing the room
+ * and entity objects. Entities have virtual functions and mutable state, so
+ * they cannot themselves be constexpr; SessionState keeps play state outside
+ * them, so the built dungeon is never changed by a game.
+ * Entities are listed in room order, which is also their id order.
+ */
+namespace FixedDungeon {
+
+enum class Kind : uint8_t {
+    Monster,
+    Item,
+    Clue
+};
+
+struct RoomSpec {
+    std::string_view fName;
+    std::string_view fDescription;
+};
+
+struct EntitySpec {
+    uint32_t fRoom;  // Index into the room table
+    Kind fKind;
+    std::string_view fName;
+    std::string_view fDescription;
+    int fStatA;  // Monster health / item value
+    int fStatB;  // Monster damage
+    std::string_view fHiddenInfo;  // Clues only
+};
+
+struct DoorSpec {
+    uint32_t fFrom;  // Room indices
+    uint32_t fTo;
+    std::string_view fName;
+    std::string_view fKey;  // Item that unlocks the door; empty if it is not locked
+};
+
+template <size_t kRooms, size_t kEntities, size_t kDoors>
+struct Tables {
+    RoomSpec fRooms[kRooms];
+    EntitySpec fEntities[kEntities];
+    DoorSpec fDoors[kDoors];
+    uint32_t fEntrance;
+};
+
+constexpr EntitySpec monster(uint32_t aRoom, std::string_view aName, std::string_view aDescription,
+                             int aHealth, int aDamage) {
+    return EntitySpec{aRoom, Kind::Monster, aName, aDescription, aHealth, aDamage, std::string_view()};
+}
+
+constexpr EntitySpec item(uint32_t aRoom, std::string_view aName, std::string_view aDescription, int aValue) {
+    return EntitySpec{aRoom, Kind::Item, aName, aDescription, aValue, 0, std::string_view()};
+}
+
+constexpr EntitySpec clue(uint32_t aRoom, std::string_view aName, std::string_view aDescription,
+                          std::string_view aHiddenInfo) {
+    return EntitySpec{aRoom, Kind::Clue, aName, aDescription, 0, 0, aHiddenInfo};
+}
+
+// Every index in range, entities in room order and every name set
+template <size_t kRooms, size_t kEntities, size_t kDoors>
+constexpr bool isValid(const Tables<kRooms, kEntities, kDoors>& aTables) {
+    if (aTables.fEntrance >= kRooms) return false;
+    for (size_t i = 0; i < kRooms; ++i) {
+        if (aTables.fRooms[i].fName.empty()) return false;
+    }
+    for (size_t i = 0; i < kEntities; ++i) {
+        const EntitySpec& entity = aTables.fEntities[i];
+        if (entity.fRoom >= kRooms || entity.fName.empty()) return false;
+        if (i > 0 && entity.fRoom < aTables.fEntities[i - 1].fRoom) return false;
+    }
+    for (size_t i = 0; i < kDoors; ++i) {
+        const DoorSpec& door = aTables.fDoors[i];
+        if (door.fFrom >= kRooms || door.fTo >= kRooms || door.fName.empty()) return false;
+    }
+    return true;
+}
+
+// Build an indexed Dungeon over the tables; they must outlive it (static
+// constexpr tables always do)
+template <size_t kRooms, size_t kEntities, size_t kDoors>
+Dungeon build(const Tables<kRooms, kEntities, kDoors>& aTables) {
+    Dungeon dungeon;
+    dungeon.reserve(kRooms, kEntities, kDoors);
+    Room* rooms[kRooms];
+    for (size_t i = 0; i < kRooms; ++i) {
+        rooms[i] = dungeon.createRoomView(aTables.fRooms[i].fName, aTables.fRooms[i].fDescription);
+    }
+
+    for (size_t first = 0, last = 0; first < kEntities; first = last) {
+        Room* room = rooms[aTables.fEntities[first].fRoom];
+        while (last < kEntities && aTables.fEntities[last].fRoom == aTables.fEntities[first].fRoom) ++last;
+        room->reserveEntities(last - first);
+        for (size_t i = first; i < last; ++i) {
+            const EntitySpec& entity = aTables.fEntities[i];
+            switch (entity.fKind) {
+                case Kind::Monster:
+                    room->addEntity(dungeon.createEntity<Monster>(entity.fName, entity.fDescription,
+                                                                  entity.fStatA, entity.fStatB));
+                    break;
+                case Kind::Item:
+                    room->addEntity(dungeon.createEntity<Item>(entity.fName, entity.fDescription, entity.fStatA));
+                    break;
+                case Kind::Clue:
+                    room->addEntity(dungeon.createEntity<Clue>(entity.fName, entity.fDescription,
+                                                               entity.fHiddenInfo));
+                    break;
+            }
+        }
+    }
+
+    for (const DoorSpec& door : aTables.fDoors) {
+        dungeon.connectRooms(rooms[door.fFrom], rooms[door.fTo], door.fName, door.fKey);
+    }
+    dungeon.setEntrance(rooms[aTables.fEntrance]);
+    dungeon.buildIndex();
+    return dungeon;
+}
+
+}  // namespace FixedDungeon
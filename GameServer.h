@@ -0,0 +1,329 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Dungeon.h"
+#include "OutputSink.h"
+#include "Player.h"
+#include "SessionProtocol.h"
+#include "SessionState.h"
+
+/**
+ * Multi-session game server on a Unix domain socket
+ *
+ * Every connection is a session with its own SessionState overlay on one
+ * shared Dungeon, played with the SessionProtocol line protocol. Sessions
+ * are sharded over a fixed number of threads, each running its own epoll
+ * loop: the listening socket is registered in every shard with
+ * EPOLLEXCLUSIVE, so a new connection wakes one shard, which accepts it and
+ * keeps it for its whole life. Sessions are never shared between threads
+ * and need no locking.
+ *
+ * Idle sessions stay small: input is read and replies are formatted in
+ * per-shard buffers, and a session only keeps the bytes of an unfinished
+ * command line or of a reply the client has not accepted yet.
+ * A client that sends commands without reading the replies is not read
+ * from either: while part of a reply is unsent the session waits for
+ * EPOLLOUT only, and commands received in one read stop running once their
+ * reply reaches kReplyBudget (the rest of that input waits with the reply).
+ * A session is closed if its unsent output would exceed kMaxUnsent, so
+ * each session holds a bounded amount of memory.
+ * Setup errors throw std::runtime_error.
+ */
+class GameServer {
+public:
+    static constexpr size_t kMaxLineLength = 1024;
+    static constexpr size_t kReplyBudget = 64 * 1024;  // Reply bytes one read's commands may produce
+    static constexpr size_t kMaxUnsent = 1024 * 1024;  // Unsent bytes a session may hold
+
+private:
+    static constexpr int kMaxEvents = 64;
+    static constexpr size_t kReadSize = 16 * 1024;
+
+    struct Session {
+        int fSocket;
+        SessionState fState;
+        std::string fPartialLine;  // Input after the last newline
+        std::string fUnread;       // Input held back while its earlier replies wait
+        std::string fUnsent;       // Reply bytes the socket did not take yet
+        bool fClosing = false;     // Close once fUnsent is empty
+
+        Session(int aSocket, const Dungeon& aDungeon, const Player& aPlayer)
+            : fSocket(aSocket), fState(aDungeon, aPlayer) {}
+    };
+
+    struct Shard {
+        int fEpoll = -1;
+        std::unordered_map<int, std::unique_ptr<Session>> fSessions;
+        std::thread fThread;
+    };
+
+    const Dungeon& fDungeon;
+    Player fPrototype;
+    std::vector<Shard> fShards;
+    int fListener = -1;
+    int fStopEvent = -1;
+    std::string fPath;
+    std::atomic<size_t> fSessionCount{0};
+
+    static void check(bool aOk, const char* aWhat) {
+        if (!aOk) {
+            throw std::runtime_error(std::string("GameServer: ") + aWhat + ": " + std::strerror(errno));
+        }
+    }
+
+    static void watch(int aEpoll, int aFd, uint32_t aEvents, void* aData, int aOperation) {
+        epoll_event event{};
+        event.events = aEvents;
+        event.data.ptr = aData;
+        epoll_ctl(aEpoll, aOperation, aFd, &event);
+    }
+
+    void closeSession(Shard& aShard, Session* aSession) {
+        epoll_ctl(aShard.fEpoll, EPOLL_CTL_DEL, aSession->fSocket, nullptr);
+        close(aSession->fSocket);
+        aShard.fSessions.erase(aSession->fSocket);
+        --fSessionCount;
+    }
+
+    // Send what the socket takes now and keep the rest, reading no more input
+    // until it is out; false if the peer is gone or the rest would not fit
+    bool send(Shard& aShard, Session& aSession, std::string_view aData) {
+        if (aSession.fUnsent.empty()) {
+            while (!aData.empty()) {
+                ssize_t sent = ::send(aSession.fSocket, aData.data(), aData.size(), MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+                    break;
+                }
+                aData.remove_prefix(static_cast<size_t>(sent));
+            }
+            if (aData.empty()) {
+                return true;
+            }
+            watch(aShard.fEpoll, aSession.fSocket, EPOLLOUT, &aSession, EPOLL_CTL_MOD);
+        }
+        if (aData.size() > kMaxUnsent - aSession.fUnsent.size()) {
+            return false;
+        }
+        aSession.fUnsent.append(aData.data(), aData.size());
+        return true;
+    }
+
+    // Retry a pending reply once the socket is writable again, and read input
+    // again once all of it is out
+    bool flushUnsent(Shard& aShard, Session& aSession) {
+        std::string pending;
+        pending.swap(aSession.fUnsent);
+        if (!send(aShard, aSession, pending)) {
+            return false;
+        }
+        if (aSession.fUnsent.empty()) {
+            watch(aShard.fEpoll, aSession.fSocket, EPOLLIN, &aSession, EPOLL_CTL_MOD);
+        }
+        return true;
+    }
+
+    void acceptSessions(Shard& aShard, BufferSink& aReply) {
+        for (;;) {
+            int socket = accept4(fListener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (socket < 0) {
+                return;  // EAGAIN: another shard took it, or no more pending
+            }
+            auto session = std::make_unique<Session>(socket, fDungeon, fPrototype);
+            Session* raw = session.get();
+            aShard.fSessions.emplace(socket, std::move(session));
+            ++fSessionCount;
+            watch(aShard.fEpoll, socket, EPOLLIN, raw, EPOLL_CTL_ADD);
+
+            aReply.clear();
+            SessionProtocol::greet(raw->fState, aReply);
+            if (!send(aShard, *raw, aReply.getText())) {
+                closeSession(aShard, raw);
+            }
+        }
+    }
+
+    // Run the complete command lines of aInput until the reply reaches
+    // kReplyBudget; input left over after that is held back in fUnread
+    void runInput(Session& aSession, std::string_view aInput, BufferSink& aReply) {
+        size_t newline;
+        while (!aSession.fClosing && (newline = aInput.find('\n')) != std::string_view::npos) {
+            if (aReply.getText().size() >= kReplyBudget) {
+                aSession.fUnread.assign(aInput.data(), aInput.size());
+                return;
+            }
+            std::string_view line = aInput.substr(0, newline);
+            aInput.remove_prefix(newline + 1);
+            if (!aSession.fPartialLine.empty()) {
+                aSession.fPartialLine.append(line.data(), line.size());
+                aSession.fClosing = !SessionProtocol::execute(aSession.fState, aSession.fPartialLine, aReply);
+                std::string().swap(aSession.fPartialLine);
+            } else {
+                aSession.fClosing = !SessionProtocol::execute(aSession.fState, line, aReply);
+            }
+        }
+        if (!aSession.fClosing) {
+            aSession.fPartialLine.append(aInput.data(), aInput.size());
+            if (aSession.fPartialLine.size() > kMaxLineLength) {
+                aReply << "ERR line too long\n";
+                aSession.fClosing = true;
+            }
+        }
+    }
+
+    // Run held-back input, then read what is available and run every complete
+    // command line, until a reply cannot be sent at once
+    bool readCommands(Shard& aShard, Session& aSession, char* aBuffer, BufferSink& aReply) {
+        for (;;) {
+            aReply.clear();
+            if (!aSession.fUnread.empty()) {
+                std::string unread;
+                unread.swap(aSession.fUnread);
+                runInput(aSession, unread, aReply);
+            } else {
+                ssize_t received = recv(aSession.fSocket, aBuffer, kReadSize, 0);
+                if (received == 0) {
+                    return false;
+                }
+                if (received < 0) {
+                    if (errno == EINTR) continue;
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+                runInput(aSession, std::string_view(aBuffer, static_cast<size_t>(received)), aReply);
+            }
+
+            if (!aReply.getText().empty() && !send(aShard, aSession, aReply.getText())) {
+                return false;
+            }
+            if (aSession.fClosing) {
+                return !aSession.fUnsent.empty();  // Keep it open until the reply is out
+            }
+            if (!aSession.fUnsent.empty()) {
+                return true;  // Read on once the client has taken the reply (see flushUnsent)
+            }
+        }
+    }
+
+    void runShard(Shard& aShard) {
+        epoll_event events[kMaxEvents];
+        std::unique_ptr<char[]> buffer(new char[kReadSize]);
+        BufferSink reply;
+        for (;;) {
+            int count = epoll_wait(aShard.fEpoll, events, kMaxEvents, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            for (int i = 0; i < count; ++i) {
+                void* data = events[i].data.ptr;
+                if (data == &fStopEvent) {
+                    return;
+                }
+                if (data == &fListener) {
+                    acceptSessions(aShard, reply);
+                    continue;
+                }
+
+                Session* session = static_cast<Session*>(data);
+                bool open = !(events[i].events & EPOLLERR);
+                bool readable = events[i].events & (EPOLLIN | EPOLLHUP);
+                if (open && (events[i].events & EPOLLOUT)) {
+                    open = flushUnsent(aShard, *session) && !(session->fClosing && session->fUnsent.empty());
+                    readable = readable || (open && session->fUnsent.empty());  // Held-back input may be waiting
+                }
+                if (open && readable && !session->fClosing) {
+                    open = readCommands(aShard, *session, buffer.get(), reply);
+                }
+                if (!open) {
+                    closeSession(aShard, session);
+                }
+            }
+        }
+    }
+
+public:
+    // Sessions start from a copy of aPrototype; the Dungeon must have been
+    // indexed with Dungeon::indexEntities() and outlive the server
+    GameServer(const Dungeon& aDungeon, const Player& aPrototype, size_t aShardCount)
+        : fDungeon(aDungeon), fPrototype(aPrototype), fShards(aShardCount ? aShardCount : 1) {}
+
+    ~GameServer() {
+        stop();
+        for (Shard& shard : fShards) {
+            if (shard.fThread.joinable()) shard.fThread.join();
+            for (auto& entry : shard.fSessions) close(entry.first);
+            if (shard.fEpoll >= 0) close(shard.fEpoll);
+        }
+        if (fListener >= 0) {
+            close(fListener);
+            unlink(fPath.c_str());
+        }
+        if (fStopEvent >= 0) close(fStopEvent);
+    }
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Bind the socket (replacing a stale socket file) and start the shard threads
+    void start(const std::string& aPath) {
+        sockaddr_un address{};
+        if (aPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("GameServer: socket path too long: " + aPath);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, aPath.c_str(), aPath.size() + 1);
+
+        fListener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        check(fListener >= 0, "socket");
+        unlink(aPath.c_str());
+        check(bind(fListener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, "bind");
+        fPath = aPath;
+        check(::listen(fListener, SOMAXCONN) == 0, "listen");
+        fStopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        check(fStopEvent >= 0, "eventfd");
+
+        for (Shard& shard : fShards) {
+            shard.fEpoll = epoll_create1(EPOLL_CLOEXEC);
+            check(shard.fEpoll >= 0, "epoll_create1");
+            watch(shard.fEpoll, fListener, EPOLLIN | EPOLLEXCLUSIVE, &fListener, EPOLL_CTL_ADD);
+            watch(shard.fEpoll, fStopEvent, EPOLLIN, &fStopEvent, EPOLL_CTL_ADD);
+        }
+        for (Shard& shard : fShards) {
+            shard.fThread = std::thread([this, &shard] { runShard(shard); });
+        }
+    }
+
+    // Ask every shard to stop; safe to call from any thread (and from a signal
+    // handler, as it only writes to an eventfd)
+    void stop() {
+        if (fStopEvent >= 0) {
+            uint64_t one = 1;
+            ssize_t written = write(fStopEvent, &one, sizeof(one));
+            (void)written;
+        }
+    }
+
+    // Block until the shards have stopped
+    void wait() {
+        for (Shard& shard : fShards) {
+            if (shard.fThread.joinable()) shard.fThread.join();
+        }
+    }
+
+    size_t getShardCount() const { return fShards.size(); }
+    size_t getSessionCount() const { return fSessionCount.load(); }
+};
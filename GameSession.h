@@ -0,0 +1,360 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Player.h"
+#include "Room.h"
+#include "Dungeon.h"
+#include "SessionState.h"
+#include "SessionActions.h"
+#include "WorldScheduler.h"
+#include "Instrumentation.h"
+
+/**
+ * What happened during one step of a GameSession
+ * Events carry the values a client needs to present them; the terminal
+ * wording lives in TerminalView.
+ */
+enum class GameEventType : uint8_t {
+    Welcome,            // The session started
+    RoomShown,          // fRoom is the current room
+    MainMenu,           // Waiting for a main menu choice (1-4)
+    NothingToInteract,  // The room has no entities
+    EntityMenu,         // Waiting for an entity of fRoom (1-based, 0 cancels)
+    InvalidSelection,   // The entity choice did not name an entity
+    ActionMenu,         // Waiting for an action on fEntity (1-3, anything else cancels)
+    NoAction,           // The action choice was not an action
+    NoExits,            // The room has no doors
+    DoorMenu,           // Waiting for a door of fRoom (1-based, 0 stays)
+    Moved,              // Went through a door into fRoom
+    DoorLocked,         // fValue = index of the door of fRoom the player lacks the key for
+    StatusShown,        // The player asked for their status
+    InvalidChoice,      // The main menu choice was not one of the choices
+    WrongTarget,        // fValue = attempted ActionType, fDetail = the one that fits fEntity
+    MonsterAlreadyDead, // Attacked a monster that is already dead
+    MonsterHit,         // fValue = damage dealt
+    MonsterDefeated,    // fValue = points scored
+    MonsterWounded,     // fValue = monster health left
+    MonsterStrikesBack, // fValue = damage taken, fDetail = player health left
+    AlreadyCollected,   // Tried to collect an item again
+    ItemCollected,      // fValue = points scored
+    MonsterExamined,    // fValue = monster health (0 if dead), fDetail = its damage
+    ItemExamined,       // fValue = item value, fDetail = 1 if collected
+    ClueRevealed,       // fValue = points scored
+    ClueRecalled,       // The clue had already been examined
+    MonsterArrived,     // fEntity wandered into fRoom (living worlds only)
+    MonsterLeft,        // fEntity wandered out of fRoom
+    MonsterRespawned,   // fEntity is back in fRoom at full health
+    ClueForgotten,      // fEntity in fRoom can be examined again
+    Quit,               // The player quit
+    PlayerDefeated,     // The player died
+    FinalScore          // fValue = final score; the session is over
+};
+
+struct GameEvent {
+    GameEventType fType;
+    const Room* fRoom;      // Room the event is about, if any
+    const Entity* fEntity;  // Entity the event is about, if any
+    int fValue;
+    int fDetail;
+};
+
+/**
+ * The game as a re-entrant state machine over a SessionState overlay
+ *
+ * The session follows the menus of the interactive game but never reads
+ * input or prints: start() and step() take the number a player would type
+ * at the current prompt, apply it and return the events it caused. Every
+ * step ends with a prompt event (MainMenu, EntityMenu, ActionMenu or
+ * DoorMenu) or, once the player quits or dies, with FinalScore.
+ * Events are kept in a fixed buffer inside the session and are valid until
+ * the next step. Without a world, step() does not allocate while the
+ * session has changed at most SessionState::kReservedEntities entities,
+ * except when an item the player does not hold yet joins the inventory
+ * (tests/step_alloc_test.cpp checks this).
+ * With enableWorld() every turn (each return to the main menu) also lets a
+ * WorldScheduler advance by one; what it changes in the current room is
+ * reported before the room is shown again. The world's timers and the
+ * session's lists of the rooms monsters roam between do allocate.
+ * The Dungeon must have been indexed with Dungeon::indexEntities().
+ */
+class GameSession {
+public:
+    // The prompt the next step() answers
+    enum class Phase {
+        MainMenu,
+        ChooseEntity,
+        ChooseAction,
+        ChooseDoor,
+        Over
+    };
+
+    // Events of the last step, in order
+    class Events {
+    private:
+        const GameEvent* fFirst;
+        size_t fCount;
+
+    public:
+        Events(const GameEvent* aFirst, size_t aCount) : fFirst(aFirst), fCount(aCount) {}
+
+        const GameEvent* begin() const { return fFirst; }
+        const GameEvent* end() const { return fFirst + fCount; }
+        size_t size() const { return fCount; }
+        const GameEvent& operator[](size_t aIndex) const { return fFirst[aIndex]; }
+    };
+
+    // No step emits more: a fight (hit, wounded, strike back) and what the
+    // world did in the room, followed by either the next menu (room, prompt)
+    // or the end (defeat, score); world events beyond that are not reported
+    static constexpr size_t kMaxEvents = 12;
+
+private:
+    SessionState fState;
+    Phase fPhase;
+    Entity* fChosenEntity;  // Entity picked in the entity menu
+    std::array<GameEvent, kMaxEvents> fEvents;
+    size_t fEventCount;
+    std::unique_ptr<WorldScheduler> fWorld;  // Living worlds only
+
+    void emit(GameEventType aType, const Entity* aEntity = nullptr, int aValue = 0, int aDetail = 0) {
+        fEvents[fEventCount++] = GameEvent{aType, fState.getCurrentRoom(), aEntity, aValue, aDetail};
+    }
+
+    // Applies one action through the session visitors and reports it
+    class ActionStep : public EntityVisitor {
+    private:
+        GameSession& fSession;
+        ActionType fAction;
+
+        void wrongTarget(Entity& aEntity, ActionType aFits) {
+            fSession.emit(GameEventType::WrongTarget, &aEntity, static_cast<int>(fAction), static_cast<int>(aFits));
+        }
+
+    public:
+        ActionStep(GameSession& aSession, ActionType aAction) : fSession(aSession), fAction(aAction) {}
+
+        void visitMonster(Monster& aMonster) override {
+            SessionState& state = fSession.fState;
+            if (fAction == ActionType::Collect) {
+                wrongTarget(aMonster, ActionType::Attack);
+            } else if (fAction == ActionType::Examine) {
+                fSession.emit(GameEventType::MonsterExamined, &aMonster, state.getMonsterHealth(aMonster),
+                              aMonster.getDamage());
+            } else if (!state.isMonsterAlive(aMonster)) {
+                fSession.emit(GameEventType::MonsterAlreadyDead, &aMonster);
+            } else {
+                Player& player = state.getPlayer();
+                int score = player.getScore();
+                SessionAttackAction(state).visitMonster(aMonster);
+                fSession.emit(GameEventType::MonsterHit, &aMonster, player.getAttackPower());
+                if (!state.isMonsterAlive(aMonster)) {
+                    fSession.emit(GameEventType::MonsterDefeated, &aMonster, player.getScore() - score);
+                } else {
+                    fSession.emit(GameEventType::MonsterWounded, &aMonster, state.getMonsterHealth(aMonster));
+                    fSession.emit(GameEventType::MonsterStrikesBack, &aMonster, aMonster.getDamage(),
+                                  player.getHealth());
+                }
+            }
+        }
+
+        void visitItem(Item& aItem) override {
+            SessionState& state = fSession.fState;
+            if (fAction == ActionType::Attack) {
+                wrongTarget(aItem, ActionType::Collect);
+            } else if (fAction == ActionType::Examine) {
+                fSession.emit(GameEventType::ItemExamined, &aItem, aItem.getValue(), state.isCollected(aItem));
+            } else if (state.isCollected(aItem)) {
+                fSession.emit(GameEventType::AlreadyCollected, &aItem);
+            } else {
+                int score = state.getPlayer().getScore();
+                SessionCollectAction(state).visitItem(aItem);
+                fSession.emit(GameEventType::ItemCollected, &aItem, state.getPlayer().getScore() - score);
+            }
+        }
+
+        void visitClue(Clue& aClue) override {
+            SessionState& state = fSession.fState;
+            if (fAction != ActionType::Examine) {
+                wrongTarget(aClue, ActionType::Examine);
+            } else if (state.isExamined(aClue)) {
+                fSession.emit(GameEventType::ClueRecalled, &aClue);
+            } else {
+                int score = state.getPlayer().getScore();
+                SessionExamineAction(state).visitClue(aClue);
+                fSession.emit(GameEventType::ClueRevealed, &aClue, state.getPlayer().getScore() - score);
+            }
+        }
+    };
+
+    // Let the world take its turn and report what happened in this room
+    void passTurn() {
+        fWorld->advance();
+        uint32_t room = static_cast<uint32_t>(fState.getCurrentRoom()->getId());
+        for (const WorldEvent& event : fWorld->getEvents()) {
+            GameEventType type;
+            if (event.fType == WorldEvent::Type::MonsterMoved && event.fRoom == room) {
+                type = GameEventType::MonsterArrived;
+            } else if (event.fType == WorldEvent::Type::MonsterMoved && event.fFromRoom == room) {
+                type = GameEventType::MonsterLeft;
+            } else if (event.fType == WorldEvent::Type::MonsterRespawned && event.fRoom == room) {
+                type = GameEventType::MonsterRespawned;
+            } else if (event.fType == WorldEvent::Type::ClueForgotten && event.fRoom == room) {
+                type = GameEventType::ClueForgotten;
+            } else {
+                continue;
+            }
+            if (fEventCount + 2 == kMaxEvents) {
+                break;  // Keep room for the room and the prompt
+            }
+            emit(type, fState.getDungeon().getEntity(event.fEntity));
+        }
+    }
+
+    // Back to the main menu, unless the game is over; a turn has passed
+    // unless the session is only starting
+    void endTurn(bool aQuit, bool aTurnPassed = true) {
+        const Player& player = fState.getPlayer();
+        if (!aQuit && player.isAlive()) {
+            if (fWorld && aTurnPassed) {
+                passTurn();
+            }
+            fPhase = Phase::MainMenu;
+            emit(GameEventType::RoomShown);
+            emit(GameEventType::MainMenu);
+            return;
+        }
+        if (!player.isAlive()) {
+            emit(GameEventType::PlayerDefeated);
+        }
+        emit(GameEventType::FinalScore, nullptr, player.getScore());
+        fPhase = Phase::Over;
+    }
+
+    void chooseFromMainMenu(int aChoice) {
+        Room* room = fState.getCurrentRoom();
+        switch (aChoice) {
+            case 1:
+                if (fState.getEntityCount(*room) == 0) {
+                    emit(GameEventType::NothingToInteract);
+                    break;
+                }
+                fPhase = Phase::ChooseEntity;
+                emit(GameEventType::EntityMenu);
+                return;
+
+            case 2:
+                if (room->getConnectedRooms().empty()) {
+                    emit(GameEventType::NoExits);
+                    break;
+                }
+                fPhase = Phase::ChooseDoor;
+                emit(GameEventType::DoorMenu);
+                return;
+
+            case 3:
+                emit(GameEventType::StatusShown);
+                break;
+
+            case 4:
+                emit(GameEventType::Quit);
+                endTurn(true);
+                return;
+
+            default:
+                emit(GameEventType::InvalidChoice);
+        }
+        endTurn(false);
+    }
+
+    void chooseEntity(int aChoice) {
+        Room* room = fState.getCurrentRoom();
+        if (aChoice == 0 || aChoice > static_cast<int>(fState.getEntityCount(*room))) {
+            endTurn(false);
+            return;
+        }
+        // Negative choices wrap around to an index past the end, as in the menu
+        fChosenEntity = fState.getEntity(*room, static_cast<size_t>(aChoice - 1));
+        if (!fChosenEntity) {
+            emit(GameEventType::InvalidSelection);
+            endTurn(false);
+            return;
+        }
+        fPhase = Phase::ChooseAction;
+        emit(GameEventType::ActionMenu, fChosenEntity);
+    }
+
+    void chooseAction(int aChoice) {
+        if (aChoice >= 1 && aChoice <= 3) {
+            INSTRUMENT_SCOPE(Instrumentation::actionMetric(aChoice));
+            ActionStep action(*this, static_cast<ActionType>(aChoice));
+            fChosenEntity->accept(action);
+        } else {
+            emit(GameEventType::NoAction);
+        }
+        endTurn(false);
+    }
+
+    void chooseDoor(int aChoice) {
+        size_t door = static_cast<size_t>(aChoice - 1);
+        if (aChoice > 0 && door < fState.getCurrentRoom()->getDoorCount() && fState.isDoorLocked(door)) {
+            emit(GameEventType::DoorLocked, nullptr, aChoice - 1);
+        } else if (aChoice > 0 && fState.move(door)) {
+            emit(GameEventType::Moved);
+        }
+        endTurn(false);
+    }
+
+public:
+    GameSession(const Dungeon& aDungeon, const Player& aPlayer)
+        : fState(aDungeon, aPlayer), fPhase(Phase::MainMenu), fChosenEntity(nullptr), fEvents(), fEventCount(0) {}
+
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    // Give the session a living world from now on
+    void enableWorld(const WorldRules& aRules) {
+        fWorld = std::make_unique<WorldScheduler>(fState, aRules);
+    }
+
+    WorldScheduler* getWorld() const { return fWorld.get(); }
+    SessionState& getState() { return fState; }
+    const SessionState& getState() const { return fState; }
+    Phase getPhase() const { return fPhase; }
+    bool isOver() const { return fPhase == Phase::Over; }
+
+    // Begin the session: the welcome and the first prompt
+    Events start() {
+        fEventCount = 0;
+        emit(GameEventType::Welcome);
+        endTurn(false, false);
+        return Events(fEvents.data(), fEventCount);
+    }
+
+    // Answer the current prompt; does nothing once the session is over
+    Events step(int aInput) {
+        fEventCount = 0;
+        switch (fPhase) {
+            case Phase::MainMenu:
+                chooseFromMainMenu(aInput);
+                break;
+            case Phase::ChooseEntity:
+                chooseEntity(aInput);
+                break;
+            case Phase::ChooseAction:
+                chooseAction(aInput);
+                break;
+            case Phase::ChooseDoor:
+                chooseDoor(aInput);
+                break;
+            case Phase::Over:
+                break;
+        }
+        return Events(fEvents.data(), fEventCount);
+    }
+};
@@ -0,0 +1,266 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Player.h"
+#include "Room.h"
+#include "Dungeon.h"
+#include "SessionState.h"
+#include "Varint.h"
+
+/**
+ * Binary snapshots of the mutable game state
+ *
+ *   magic "DSNP", then varints:
+ *   version, kind (delta or full), roomCount, entityCount, currentRoom
+ *   player name (length + bytes), maxHealth, attackPower, health, score
+ *   inventory entry count, then per entry: item name (length + bytes),
+ *     count, total value
+ *   record count, then per record: entity id, health, flags
+ *     (bit 0 collected, bit 1 examined, bit 2 spent: brought back by a living
+ *     world after it scored)
+ *
+ * The dungeon itself is never stored: a snapshot only holds what a
+ * playthrough changes and is restored onto the dungeon it was taken from
+ * (room and entity counts are checked). A SessionState snapshot is a delta
+ * that lists only the entities the session has changed, so capturing and
+ * restoring cost O(changed entities + inventory) whatever the dungeon size.
+ * The interactive game changes the entities themselves, so its snapshots
+ * are full and list every entity.
+ * Malformed input throws std::runtime_error, possibly after part of the
+ * state has been restored.
+ */
+namespace GameSnapshot {
+
+constexpr char kMagic[4] = {'D', 'S', 'N', 'P'};
+constexpr uint64_t kVersion = 2;
+
+enum class Kind : uint8_t {
+    Delta = 0,
+    Full = 1
+};
+
+namespace detail {
+
+constexpr uint8_t kCollectedFlag = 1;
+constexpr uint8_t kExaminedFlag = 2;
+constexpr uint8_t kSpentFlag = 4;
+
+inline void appendHeader(std::vector<uint8_t>& aOut, Kind aKind, const Dungeon& aDungeon, const Room* aCurrentRoom) {
+    aOut.insert(aOut.end(), kMagic, kMagic + sizeof(kMagic));
+    Varint::append(aOut, kVersion);
+    Varint::append(aOut, static_cast<uint64_t>(aKind));
+    Varint::append(aOut, aDungeon.getRoomCount());
+    Varint::append(aOut, aDungeon.getEntityCount());
+    Varint::append(aOut, aCurrentRoom->getId());
+}
+
+inline void appendPlayer(std::vector<uint8_t>& aOut, const Player& aPlayer) {
+    Varint::appendText(aOut, aPlayer.getName());
+    Varint::appendSigned(aOut, aPlayer.getMaxHealth());
+    Varint::appendSigned(aOut, aPlayer.getAttackPower());
+    Varint::appendSigned(aOut, aPlayer.getHealth());
+    Varint::appendSigned(aOut, aPlayer.getScore());
+    Varint::append(aOut, aPlayer.getInventory().getDistinctCount());
+    for (const Inventory::Entry& entry : aPlayer.getInventory()) {
+        Varint::appendText(aOut, SymbolTable::global().resolve(entry.fItem));
+        Varint::append(aOut, entry.fCount);
+        Varint::appendSigned(aOut, entry.fValue);
+    }
+}
+
+inline void appendRecord(std::vector<uint8_t>& aOut, size_t aId, int aHealth, bool aIsCollected, bool aIsExamined,
+                         bool aIsSpent = false) {
+    Varint::append(aOut, aId);
+    Varint::appendSigned(aOut, aHealth);
+    aOut.push_back(static_cast<uint8_t>((aIsCollected ? kCollectedFlag : 0) | (aIsExamined ? kExaminedFlag : 0) |
+                                        (aIsSpent ? kSpentFlag : 0)));
+}
+
+// Checks the header against the dungeon and returns the kind and current room
+inline Kind readHeader(Varint::Reader& aReader, const Dungeon& aDungeon, Room*& aCurrentRoom) {
+    if (aReader.read() != kVersion) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+    uint64_t kind = aReader.read();
+    if (kind > static_cast<uint64_t>(Kind::Full)) {
+        throw std::runtime_error("Unknown snapshot kind");
+    }
+    if (aReader.read() != aDungeon.getRoomCount() || aReader.read() != aDungeon.getEntityCount()) {
+        throw std::runtime_error("Snapshot was taken on a different dungeon");
+    }
+    uint64_t room = aReader.read();
+    if (room >= aDungeon.getRoomCount()) {
+        throw std::runtime_error("Snapshot room out of range");
+    }
+    aCurrentRoom = aDungeon.getRooms()[room];
+    return static_cast<Kind>(kind);
+}
+
+inline Varint::Reader openReader(const uint8_t* aData, size_t aSize) {
+    if (aSize < sizeof(kMagic) || std::memcmp(aData, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a game snapshot");
+    }
+    return Varint::Reader(aData + sizeof(kMagic), aSize - sizeof(kMagic));
+}
+
+inline int readInt(Varint::Reader& aReader) {
+    int64_t value = aReader.readSigned();
+    if (value < INT32_MIN || value > INT32_MAX) {
+        throw std::runtime_error("Snapshot value out of range");
+    }
+    return static_cast<int>(value);
+}
+
+// Reads the player, reusing aPlayer's storage when name and stats match
+inline void readPlayer(Varint::Reader& aReader, Player& aPlayer) {
+    std::string_view name = aReader.readText();
+    int maxHealth = readInt(aReader);
+    int attackPower = readInt(aReader);
+    int health = readInt(aReader);
+    int score = readInt(aReader);
+    if (name != aPlayer.getName() || maxHealth != aPlayer.getMaxHealth() || attackPower != aPlayer.getAttackPower()) {
+        aPlayer = Player(std::string(name), maxHealth, attackPower);
+    }
+    aPlayer.restoreState(health, score);
+    aPlayer.clearInventory();
+    uint64_t entryCount = aReader.read();
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        Symbol item = SymbolTable::global().intern(aReader.readText());
+        uint64_t count = aReader.read();
+        if (count == 0 || count > UINT32_MAX) {
+            throw std::runtime_error("Snapshot item count out of range");
+        }
+        aPlayer.restoreInventory(item, static_cast<uint32_t>(count), aReader.readSigned());
+    }
+}
+
+struct Record {
+    size_t fId;
+    SessionState::EntityState fState;
+};
+
+inline Record readRecord(Varint::Reader& aReader, size_t aEntityCount) {
+    uint64_t id = aReader.read();
+    if (id >= aEntityCount) {
+        throw std::runtime_error("Snapshot entity out of range");
+    }
+    int health = readInt(aReader);
+    uint64_t flags = aReader.read();
+    return Record{static_cast<size_t>(id),
+                  SessionState::EntityState{health, (flags & kCollectedFlag) != 0, (flags & kExaminedFlag) != 0,
+                                            (flags & kSpentFlag) != 0}};
+}
+
+// Writes a record for every entity from its own fields
+class LiveStateWriter : public EntityVisitor {
+private:
+    std::vector<uint8_t>& fOut;
+
+public:
+    LiveStateWriter(std::vector<uint8_t>& aOut) : fOut(aOut) {}
+
+    void visitMonster(Monster& aMonster) override {
+        appendRecord(fOut, aMonster.getId(), aMonster.isAlive() ? aMonster.getHealth() : 0, false, false);
+    }
+
+    void visitItem(Item& aItem) override {
+        appendRecord(fOut, aItem.getId(), 0, aItem.isCollected(), false);
+    }
+
+    void visitClue(Clue& aClue) override {
+        appendRecord(fOut, aClue.getId(), 0, false, aClue.isExamined());
+    }
+};
+
+// Applies one record to an entity through its setters
+class LiveStateReader : public EntityVisitor {
+private:
+    const SessionState::EntityState& fState;
+
+public:
+    LiveStateReader(const SessionState::EntityState& aState) : fState(aState) {}
+
+    void visitMonster(Monster& aMonster) override { aMonster.setHealth(fState.fHealth); }
+    void visitItem(Item& aItem) override { aItem.setCollected(fState.fIsCollected); }
+    void visitClue(Clue& aClue) override { aClue.setExamined(fState.fIsExamined); }
+};
+
+} // namespace detail
+
+// Write a delta snapshot of a session into aOut (cleared first, capacity kept)
+inline void capture(const SessionState& aState, std::vector<uint8_t>& aOut) {
+    aOut.clear();
+    detail::appendHeader(aOut, Kind::Delta, aState.getDungeon(), aState.getCurrentRoom());
+    detail::appendPlayer(aOut, aState.getPlayer());
+    const std::vector<uint32_t>& changed = aState.getChangedEntities();
+    Varint::append(aOut, changed.size());
+    for (uint32_t id : changed) {
+        SessionState::EntityState entity = aState.getEntityState(id);
+        detail::appendRecord(aOut, id, entity.fHealth, entity.fIsCollected, entity.fIsExamined, entity.fIsSpent);
+    }
+}
+
+inline std::vector<uint8_t> capture(const SessionState& aState) {
+    std::vector<uint8_t> out;
+    capture(aState, out);
+    return out;
+}
+
+// Restore a session from a delta or full snapshot taken on the same dungeon
+inline void restore(SessionState& aState, const uint8_t* aData, size_t aSize) {
+    Varint::Reader reader = detail::openReader(aData, aSize);
+    const Dungeon& dungeon = aState.getDungeon();
+    Room* currentRoom;
+    detail::readHeader(reader, dungeon, currentRoom);
+    detail::readPlayer(reader, aState.getPlayer());
+    aState.setCurrentRoom(currentRoom);
+    aState.resetEntities();
+    uint64_t recordCount = reader.read();
+    for (uint64_t i = 0; i < recordCount; ++i) {
+        detail::Record record = detail::readRecord(reader, dungeon.getEntityCount());
+        aState.setEntityState(record.fId, record.fState);
+    }
+}
+
+inline void restore(SessionState& aState, const std::vector<uint8_t>& aSnapshot) {
+    restore(aState, aSnapshot.data(), aSnapshot.size());
+}
+
+// Write a full snapshot of a game played directly on the dungeon's entities
+// The dungeon must have been indexed with Dungeon::indexEntities()
+inline void capture(const Dungeon& aDungeon, const Player& aPlayer, const Room* aCurrentRoom,
+                    std::vector<uint8_t>& aOut) {
+    aOut.clear();
+    detail::appendHeader(aOut, Kind::Full, aDungeon, aCurrentRoom);
+    detail::appendPlayer(aOut, aPlayer);
+    Varint::append(aOut, aDungeon.getEntityCount());
+    detail::LiveStateWriter writer(aOut);
+    for (size_t i = 0; i < aDungeon.getEntityCount(); ++i) {
+        aDungeon.getEntity(i)->accept(writer);
+    }
+}
+
+// Restore a full snapshot onto the dungeon's entities; returns the current room
+inline Room* restore(Dungeon& aDungeon, Player& aPlayer, const uint8_t* aData, size_t aSize) {
+    Varint::Reader reader = detail::openReader(aData, aSize);
+    Room* currentRoom;
+    if (detail::readHeader(reader, aDungeon, currentRoom) != Kind::Full) {
+        throw std::runtime_error("Only full snapshots can be restored onto a dungeon");
+    }
+    detail::readPlayer(reader, aPlayer);
+    uint64_t recordCount = reader.read();
+    for (uint64_t i = 0; i < recordCount; ++i) {
+        detail::Record record = detail::readRecord(reader, aDungeon.getEntityCount());
+        detail::LiveStateReader apply(record.fState);
+        aDungeon.getEntity(record.fId)->accept(apply);
+    }
+    return currentRoom;
+}
+
+} // namespace GameSnapshot
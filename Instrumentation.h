@@ -0,0 +1,275 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * Counts and latency histograms for the game's operations
+ *
+ * Code marks what it wants measured with INSTRUMENT_SCOPE(metric), which
+ * times the rest of the enclosing scope. Every thread records into its own
+ * histograms, so recording takes no lock and never shares a cache line with
+ * another thread; writeJson() merges all threads on demand.
+ *
+ * Histograms are HDR-style: values (nanoseconds) below 16 have one bucket
+ * each, and every power of two above that is split into 16 buckets, so any
+ * recorded value is known to within 1/16 (6.25%) over the whole 64-bit range.
+ *
+ * The macros only record when the program is built with
+ * -DDUNGEON_INSTRUMENTATION (make INSTRUMENT=1); otherwise they expand to
+ * nothing and the instrumented code is exactly the uninstrumented code.
+ */
+namespace Instrumentation {
+
+enum class Metric : uint8_t {
+    Attack,
+    Collect,
+    Examine,
+    Move,        // Going through a door
+    Describe,    // Room::describe
+    ParseInput,  // Reading and parsing one input value or command
+    Count
+};
+
+constexpr size_t kMetricCount = static_cast<size_t>(Metric::Count);
+
+inline const char* metricName(Metric aMetric) {
+    static const char* const kNames[kMetricCount] = {"attack", "collect", "examine", "move", "describe",
+                                                     "parse_input"};
+    return kNames[static_cast<size_t>(aMetric)];
+}
+
+// Metric of an action in menu numbering (1 attack, 2 collect, 3 examine)
+inline Metric actionMetric(int aAction) {
+    return static_cast<Metric>(aAction - 1);
+}
+
+constexpr unsigned kSubBucketBits = 4;
+constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+inline size_t bucketOf(uint64_t aValue) {
+    if (aValue < kSubBuckets) {
+        return static_cast<size_t>(aValue);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(aValue));
+    unsigned shift = exponent - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + ((aValue >> shift) & (kSubBuckets - 1));
+}
+
+// Largest value that falls into a bucket
+inline uint64_t bucketHighest(size_t aBucket) {
+    if (aBucket < kSubBuckets) {
+        return aBucket;
+    }
+    unsigned shift = static_cast<unsigned>(aBucket / kSubBuckets) - 1;
+    uint64_t lowest = (kSubBuckets + aBucket % kSubBuckets) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+/**
+ * Plain histogram, used for merged results
+ */
+class Histogram {
+private:
+    std::array<uint64_t, kBucketCount> fBuckets{};
+    uint64_t fCount = 0;
+    uint64_t fTotal = 0;
+    uint64_t fMax = 0;
+
+public:
+    void add(size_t aBucket, uint64_t aCount) {
+        fBuckets[aBucket] += aCount;
+    }
+
+    void addTotals(uint64_t aCount, uint64_t aTotal, uint64_t aMax) {
+        fCount += aCount;
+        fTotal += aTotal;
+        if (aMax > fMax) fMax = aMax;
+    }
+
+    uint64_t getCount() const { return fCount; }
+    uint64_t getTotal() const { return fTotal; }
+    uint64_t getMax() const { return fMax; }
+    double getMean() const { return fCount ? static_cast<double>(fTotal) / static_cast<double>(fCount) : 0.0; }
+
+    // Value at or below which aFraction of the recorded values lie
+    uint64_t getPercentile(double aFraction) const {
+        uint64_t bucketTotal = 0;
+        for (uint64_t count : fBuckets) bucketTotal += count;
+        if (bucketTotal == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(aFraction * static_cast<double>(bucketTotal) + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += fBuckets[i];
+            if (seen >= rank) {
+                uint64_t value = bucketHighest(i);
+                return value < fMax ? value : fMax;
+            }
+        }
+        return fMax;
+    }
+};
+
+/**
+ * One thread's histograms
+ * Only the owning thread writes, so updates are plain relaxed load/store
+ * pairs (no read-modify-write); other threads may read at any time.
+ */
+class ThreadRecorder {
+private:
+    struct Series {
+        std::array<std::atomic<uint64_t>, kBucketCount> fBuckets{};
+        std::atomic<uint64_t> fCount{0};
+        std::atomic<uint64_t> fTotal{0};
+        std::atomic<uint64_t> fMax{0};
+    };
+
+    static void bump(std::atomic<uint64_t>& aCounter, uint64_t aAmount) {
+        aCounter.store(aCounter.load(std::memory_order_relaxed) + aAmount, std::memory_order_relaxed);
+    }
+
+    std::array<Series, kMetricCount> fSeries;
+
+public:
+    void record(Metric aMetric, uint64_t aNanoseconds) {
+        Series& series = fSeries[static_cast<size_t>(aMetric)];
+        bump(series.fBuckets[bucketOf(aNanoseconds)], 1);
+        bump(series.fCount, 1);
+        bump(series.fTotal, aNanoseconds);
+        if (aNanoseconds > series.fMax.load(std::memory_order_relaxed)) {
+            series.fMax.store(aNanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    void mergeInto(Metric aMetric, Histogram& aHistogram) const {
+        const Series& series = fSeries[static_cast<size_t>(aMetric)];
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t count = series.fBuckets[i].load(std::memory_order_relaxed);
+            if (count) aHistogram.add(i, count);
+        }
+        aHistogram.addTotals(series.fCount.load(std::memory_order_relaxed),
+                             series.fTotal.load(std::memory_order_relaxed),
+                             series.fMax.load(std::memory_order_relaxed));
+    }
+
+    void clear() {
+        for (Series& series : fSeries) {
+            for (auto& bucket : series.fBuckets) bucket.store(0, std::memory_order_relaxed);
+            series.fCount.store(0, std::memory_order_relaxed);
+            series.fTotal.store(0, std::memory_order_relaxed);
+            series.fMax.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Every thread's recorder; recorders live until the program ends so the
+ * measurements of finished threads are still merged
+ */
+class Registry {
+private:
+    std::mutex fMutex;
+    std::vector<std::unique_ptr<ThreadRecorder>> fRecorders;
+
+public:
+    static Registry& get() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadRecorder* add() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fRecorders.push_back(std::make_unique<ThreadRecorder>());
+        return fRecorders.back().get();
+    }
+
+    Histogram merge(Metric aMetric) {
+        Histogram histogram;
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (const auto& recorder : fRecorders) {
+            recorder->mergeInto(aMetric, histogram);
+        }
+        return histogram;
+    }
+
+    // Racy against threads recording at the same time; meant for between runs
+    void clear() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (const auto& recorder : fRecorders) {
+            recorder->clear();
+        }
+    }
+};
+
+inline ThreadRecorder& threadRecorder() {
+    static thread_local ThreadRecorder* recorder = Registry::get().add();
+    return *recorder;
+}
+
+// Times the rest of the enclosing scope
+class ScopedTimer {
+private:
+    Metric fMetric;
+    std::chrono::steady_clock::time_point fStart;
+
+public:
+    explicit ScopedTimer(Metric aMetric) : fMetric(aMetric), fStart(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - fStart;
+        threadRecorder().record(fMetric, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Merge every thread and write count, mean, percentiles and max (in ns) of
+// each metric that has been recorded
+inline void writeJson(std::ostream& aOut) {
+    aOut << "{\"instrumentation\": {";
+    bool first = true;
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        Metric metric = static_cast<Metric>(i);
+        Histogram histogram = Registry::get().merge(metric);
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        aOut << (first ? "\n" : ",\n") << "  \"" << metricName(metric) << "\": {\"count\": " << histogram.getCount()
+             << ", \"total_ns\": " << histogram.getTotal() << ", \"mean_ns\": " << histogram.getMean()
+             << ", \"p50_ns\": " << histogram.getPercentile(0.50) << ", \"p90_ns\": " << histogram.getPercentile(0.90)
+             << ", \"p99_ns\": " << histogram.getPercentile(0.99)
+             << ", \"p999_ns\": " << histogram.getPercentile(0.999) << ", \"max_ns\": " << histogram.getMax() << "}";
+        first = false;
+    }
+    aOut << (first ? "}}\n" : "\n}}\n");
+}
+
+inline void clear() {
+    Registry::get().clear();
+}
+
+} // namespace Instrumentation
+
+#define INSTRUMENT_CONCAT_INNER(aFirst, aSecond) aFirst##aSecond
+#define INSTRUMENT_CONCAT(aFirst, aSecond) INSTRUMENT_CONCAT_INNER(aFirst, aSecond)
+
+#ifdef DUNGEON_INSTRUMENTATION
+#define INSTRUMENT_SCOPE(aMetric) \
+    Instrumentation::ScopedTimer INSTRUMENT_CONCAT(instrumentTimer, __LINE__)(aMetric)
+#define INSTRUMENT_DUMP(aStream) Instrumentation::writeJson(aStream)
+#else
+#define INSTRUMENT_SCOPE(aMetric) ((void)0)
+#define INSTRUMENT_DUMP(aStream) ((void)0)
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SymbolTable.h"
+
+/**
+ * A player's items, counted by name
+ *
+ * Each distinct item is one entry holding how many were picked up and
+ * their total value, kept in the order the item was first picked up.
+ * Lookups go through an open-addressing table of entry indices (linear
+ * probing on the item's Symbol), so has() and count() are O(1) however many
+ * items are held; small inventories skip the table and scan their entries.
+ * Totals are updated on every add, so bulk queries (item count, value) are
+ * O(1) as well. An entry is 16 bytes and a table slot 4, so thousands of
+ * items cost a few tens of kilobytes.
+ */
+class Inventory {
+public:
+    struct Entry {
+        Symbol fItem;
+        uint32_t fCount;
+        int64_t fValue;  // Total value of the fCount items
+    };
+
+private:
+    static constexpr size_t kScanLimit = 8;  // Entries looked up without the table
+    static constexpr uint32_t kEmptySlot = 0;
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    std::vector<Entry> fEntries;
+    std::vector<uint32_t> fSlots;  // Entry index + 1, or kEmptySlot; power-of-two size
+    size_t fTotalCount = 0;
+    int64_t fTotalValue = 0;
+
+    size_t slotOf(Symbol aItem) const {
+        // Fibonacci hashing; sequential symbols land on distinct slots
+        return (aItem * 0x9E3779B1u) & (fSlots.size() - 1);
+    }
+
+    void insertSlot(size_t aEntry) {
+        size_t slot = slotOf(fEntries[aEntry].fItem);
+        while (fSlots[slot] != kEmptySlot) {
+            slot = (slot + 1) & (fSlots.size() - 1);
+        }
+        fSlots[slot] = static_cast<uint32_t>(aEntry + 1);
+    }
+
+    // Rebuild the table at twice the entry count rounded up to a power of two
+    void rehash() {
+        size_t size = 16;
+        while (size < fEntries.size() * 2) size *= 2;
+        fSlots.assign(size, kEmptySlot);
+        for (size_t i = 0; i < fEntries.size(); ++i) {
+            insertSlot(i);
+        }
+    }
+
+    // Index of an item's entry, or kNotFound
+    size_t find(Symbol aItem) const {
+        if (fSlots.empty()) {
+            for (size_t i = 0; i < fEntries.size(); ++i) {
+                if (fEntries[i].fItem == aItem) return i;
+            }
+            return kNotFound;
+        }
+        for (size_t slot = slotOf(aItem);; slot = (slot + 1) & (fSlots.size() - 1)) {
+            uint32_t index = fSlots[slot];
+            if (index == kEmptySlot) return kNotFound;
+            if (fEntries[index - 1].fItem == aItem) return index - 1;
+        }
+    }
+
+public:
+    // Add aCount items worth aValue in total
+    void add(Symbol aItem, int64_t aValue = 0, uint32_t aCount = 1) {
+        fTotalCount += aCount;
+        fTotalValue += aValue;
+        size_t index = find(aItem);
+        if (index != kNotFound) {
+            fEntries[index].fCount += aCount;
+            fEntries[index].fValue += aValue;
+            return;
+        }
+
+        fEntries.push_back(Entry{aItem, aCount, aValue});
+        if (fEntries.size() > kScanLimit) {
+            // Keep the table at most half full
+            if (fEntries.size() * 2 > fSlots.size()) {
+                rehash();
+            } else {
+                insertSlot(fEntries.size() - 1);
+            }
+        }
+    }
+
+    bool has(Symbol aItem) const { return find(aItem) != kNotFound; }
+
+    uint32_t count(Symbol aItem) const {
+        size_t index = find(aItem);
+        return index != kNotFound ? fEntries[index].fCount : 0;
+    }
+
+    int64_t getValue(Symbol aItem) const {
+        size_t index = find(aItem);
+        return index != kNotFound ? fEntries[index].fValue : 0;
+    }
+
+    // Items held, counting every copy
+    size_t getTotalCount() const { return fTotalCount; }
+    int64_t getTotalValue() const { return fTotalValue; }
+    size_t getDistinctCount() const { return fEntries.size(); }
+    bool empty() const { return fEntries.empty(); }
+
+    // Entries in first pick-up order
+    std::vector<Entry>::const_iterator begin() const { return fEntries.begin(); }
+    std::vector<Entry>::const_iterator end() const { return fEntries.end(); }
+
+    void clear() {
+        fEntries.clear();
+        fSlots.clear();
+        fTotalCount = 0;
+        fTotalValue = 0;
+    }
+};
@@ -11,13 +11,14 @@ private:
     bool fIsCollected;
 
 public:
-    Item(const std::string& aName, const std::string& aDescription, int aValue)
+    Item(std::string_view aName, StoredText aDescription, int aValue)
         : Entity(aName, aDescription), fValue(aValue), fIsCollected(false) {}
 
     // Getter and setter methods
     int getValue() const { return fValue; }
     bool isCollected() const { return fIsCollected; }
     void collect() { fIsCollected = true; }
+    void setCollected(bool aIsCollected) { fIsCollected = aIsCollected; }
 
     // Accept method for Visitor pattern
     void accept(EntityVisitor& aVisitor) override {
@@ -0,0 +1,101 @@
+#pragma once
+#include <istream>
+#include <vector>
+#include "SessionState.h"
+#include "SessionActions.h"
+#include "ActionJournal.h"
+#include "WorldScheduler.h"
+
+/**
+ * A scripted bot made of the menu numbers a player would type into gameLoop
+ * (the format of test_input.txt). Playing it against a SessionState follows
+ * the same menu flow as the interactive game without printing anything.
+ * The script ends the session when it runs out of input.
+ * The moves and actions it makes can be recorded into an ActionJournal.
+ * In a living world, the world advances one turn after each main menu
+ * choice, as in GameSession.
+ */
+class MenuScript {
+private:
+    std::vector<int> fInputs;
+
+public:
+    MenuScript() = default;
+    explicit MenuScript(std::vector<int> aInputs) : fInputs(std::move(aInputs)) {}
+
+    // Read whitespace separated menu numbers until end of stream
+    static MenuScript load(std::istream& aInput) {
+        std::vector<int> inputs;
+        int value;
+        while (aInput >> value) {
+            inputs.push_back(value);
+        }
+        return MenuScript(std::move(inputs));
+    }
+
+    const std::vector<int>& getInputs() const { return fInputs; }
+
+    // Play the script against a session, mirroring gameLoop and interactWithRoom
+    void play(SessionState& aState, ActionJournal* aJournal = nullptr, WorldScheduler* aWorld = nullptr) const {
+        size_t next = 0;
+        auto read = [&](int& aValue) {
+            if (next >= fInputs.size()) {
+                return false;
+            }
+            aValue = fInputs[next++];
+            return true;
+        };
+
+        int choice;
+        while (aState.getPlayer().isAlive() && read(choice)) {
+            Room* room = aState.getCurrentRoom();
+            switch (choice) {
+                case 1: {
+                    if (aState.getEntityCount(*room) == 0) {
+                        break;
+                    }
+                    int entityChoice;
+                    if (!read(entityChoice)) {
+                        return;
+                    }
+                    if (entityChoice <= 0 || entityChoice > static_cast<int>(aState.getEntityCount(*room))) {
+                        break;
+                    }
+                    int action;
+                    if (!read(action)) {
+                        return;
+                    }
+                    if (action >= 1 && action <= 3 &&
+                        performAction(aState, entityChoice - 1, static_cast<ActionType>(action)) && aJournal) {
+                        aJournal->recordAction(entityChoice - 1, static_cast<ActionType>(action));
+                    }
+                    break;
+                }
+
+                case 2: {
+                    if (room->getConnectedRooms().empty()) {
+                        break;
+                    }
+                    int roomChoice;
+                    if (!read(roomChoice)) {
+                        return;
+                    }
+                    if (roomChoice > 0 && aState.move(roomChoice - 1) && aJournal) {
+                        aJournal->recordMove(roomChoice - 1);
+                    }
+                    break;
+                }
+
+                case 4:
+                    return;
+
+                default:
+                    // Status display and invalid choices do not change the state
+                    break;
+            }
+            if (aWorld && aState.getPlayer().isAlive()) {
+                aWorld->advance();
+            }
+        }
+    }
+};
@@ -4,6 +4,8 @@
 
 /**
  * Monster entity that can be fought by the player
+ * A monster with no health left (as a dungeon file may hold) starts out
+ * defeated, like one restored with setHealth(0).
  */
 class Monster : public Entity {
 private:
@@ -12,14 +14,20 @@ private:
     bool fIsAlive;
 
 public:
-    Monster(const std::string& aName, const std::string& aDescription, int aHealth, int aDamage)
-        : Entity(aName, aDescription), fHealth(aHealth), fDamage(aDamage), fIsAlive(true) {}
+    Monster(std::string_view aName, StoredText aDescription, int aHealth, int aDamage)
+        : Entity(aName, aDescription), fHealth(aHealth > 0 ? aHealth : 0), fDamage(aDamage), fIsAlive(aHealth > 0) {}
 
     // Getter and setter methods
     int getHealth() const { return fHealth; }
     int getDamage() const { return fDamage; }
     bool isAlive() const { return fIsAlive; }
 
+    // Overwrite the mutable state (used when restoring saved state)
+    void setHealth(int aHealth) {
+        fHealth = aHealth > 0 ? aHealth : 0;
+        fIsAlive = aHealth > 0;
+    }
+
     void takeDamage(int aDamage) {
         fHealth -= aDamage;
         if (fHealth <= 0) {
@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Abstract destination for all game text
+ * Game code formats through operator<< and ends lines with "\n"; nothing is
+ * flushed until the sink decides to (or flush() is called). A disabled sink
+ * skips formatting entirely, so headless runs pay almost nothing for output.
+ */
+class OutputSink {
+private:
+    bool fEnabled;
+
+protected:
+    // Receives already formatted text
+    virtual void write(const char* aData, size_t aSize) = 0;
+
+public:
+    explicit OutputSink(bool aEnabled = true) : fEnabled(aEnabled) {}
+    virtual ~OutputSink() = default;
+
+    bool isEnabled() const { return fEnabled; }
+
+    // Push buffered text to its final destination, if there is one
+    virtual void flush() {}
+
+    OutputSink& operator<<(std::string_view aText) {
+        if (fEnabled) write(aText.data(), aText.size());
+        return *this;
+    }
+
+    OutputSink& operator<<(const std::string& aText) {
+        return *this << std::string_view(aText);
+    }
+
+    OutputSink& operator<<(const char* aText) {
+        return *this << std::string_view(aText);
+    }
+
+    OutputSink& operator<<(char aChar) {
+        if (fEnabled) write(&aChar, 1);
+        return *this;
+    }
+
+    OutputSink& operator<<(int aValue) { return writeInteger(aValue); }
+    OutputSink& operator<<(long aValue) { return writeInteger(aValue); }
+    OutputSink& operator<<(long long aValue) { return writeInteger(aValue); }
+    OutputSink& operator<<(unsigned aValue) { return writeInteger(aValue); }
+    OutputSink& operator<<(unsigned long aValue) { return writeInteger(aValue); }
+    OutputSink& operator<<(unsigned long long aValue) { return writeInteger(aValue); }
+
+private:
+    template <typename T>
+    OutputSink& writeInteger(T aValue) {
+        if (fEnabled) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), aValue);
+            write(buffer, static_cast<size_t>(result.ptr - buffer));
+        }
+        return *this;
+    }
+};
+
+/**
+ * Discards everything without formatting it
+ */
+class NullSink : public OutputSink {
+protected:
+    void write(const char*, size_t) override {}
+
+public:
+    NullSink() : OutputSink(false) {}
+};
+
+/**
+ * Writes to a std::ostream (usually std::cout) and leaves flushing to the
+ * stream; std::cin is tied to std::cout, so prompts still appear before input
+ */
+class StreamSink : public OutputSink {
+private:
+    std::ostream& fStream;
+
+protected:
+    void write(const char* aData, size_t aSize) override {
+        fStream.write(aData, static_cast<std::streamsize>(aSize));
+    }
+
+public:
+    explicit StreamSink(std::ostream& aStream) : fStream(aStream) {}
+
+    void flush() override {
+        fStream.flush();
+    }
+};
+
+/**
+ * Collects all text in memory
+ */
+class BufferSink : public OutputSink {
+private:
+    std::string fBuffer;
+
+protected:
+    void write(const char* aData, size_t aSize) override {
+        fBuffer.append(aData, aSize);
+    }
+
+public:
+    const std::string& getText() const { return fBuffer; }
+    void clear() { fBuffer.clear(); }
+    void reserve(size_t aSize) { fBuffer.reserve(aSize); }
+
+    // Hand the collected text over, leaving the sink empty
+    std::string takeText() { return std::move(fBuffer); }
+};
+
+/**
+ * Keeps only the most recent text in a fixed-size ring, e.g. the tail of a
+ * long replay for diagnostics; never allocates after construction
+ */
+class RingBufferSink : public OutputSink {
+private:
+    std::vector<char> fRing;
+    size_t fHead;   // Next write position
+    size_t fTotal;  // Total bytes ever written
+
+protected:
+    void write(const char* aData, size_t aSize) override {
+        if (fRing.empty()) return;
+        fTotal += aSize;
+        if (aSize >= fRing.size()) {
+            // Only the last capacity bytes survive
+            aData += aSize - fRing.size();
+            aSize = fRing.size();
+        }
+        size_t firstPart = std::min(aSize, fRing.size() - fHead);
+        std::copy(aData, aData + firstPart, fRing.begin() + fHead);
+        std::copy(aData + firstPart, aData + aSize, fRing.begin());
+        fHead = (fHead + aSize) % fRing.size();
+    }
+
+public:
+    explicit RingBufferSink(size_t aCapacity) : fRing(aCapacity), fHead(0), fTotal(0) {}
+
+    size_t getCapacity() const { return fRing.size(); }
+    size_t getTotalWritten() const { return fTotal; }
+
+    // Most recent text, oldest first
+    std::string getText() const {
+        if (fTotal < fRing.size()) {
+            return std::string(fRing.begin(), fRing.begin() + fHead);
+        }
+        std::string text(fRing.begin() + fHead, fRing.end());
+        text.append(fRing.begin(), fRing.begin() + fHead);
+        return text;
+    }
+};
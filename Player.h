@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
-#include <vector>
+#include <string_view>
+#include "Inventory.h"
+#include "OutputSink.h"
+#include "SymbolTable.h"
 
 /**
  * Player class represents the player character in the game
@@ -11,7 +14,7 @@ private:
     int fHealth;
     int fMaxHealth;
     int fAttackPower;
-    std::vector<std::string> fInventory;
+    Inventory fInventory;
     int fScore;
 
 public:
@@ -25,7 +28,7 @@ public:
     int getMaxHealth() const { return fMaxHealth; }
     int getAttackPower() const { return fAttackPower; }
     int getScore() const { return fScore; }
-    const std::vector<std::string>& getInventory() const { return fInventory; }
+    const Inventory& getInventory() const { return fInventory; }
 
     // Action methods
     void takeDamage(int aDamage) {
@@ -38,33 +41,55 @@ public:
         if (fHealth > fMaxHealth) fHealth = fMaxHealth;
     }
 
-    void addToInventory(const std::string& aItem) {
-        fInventory.push_back(aItem);
+    void addToInventory(Symbol aItem, int aValue = 0) {
+        fInventory.add(aItem, aValue);
+    }
+
+    void addToInventory(std::string_view aItem, int aValue = 0) {
+        addToInventory(SymbolTable::global().intern(aItem), aValue);
     }
 
     void addScore(int aPoints) {
         fScore += aPoints;
     }
 
+    // Overwrite the mutable state (used when restoring saved state)
+    void restoreState(int aHealth, int aScore) {
+        fHealth = aHealth;
+        fScore = aScore;
+    }
+
+    void restoreInventory(Symbol aItem, uint32_t aCount, int64_t aValue) {
+        fInventory.add(aItem, aValue, aCount);
+    }
+
+    void clearInventory() {
+        fInventory.clear();
+    }
+
     bool isAlive() const {
         return fHealth > 0;
     }
 
-    void displayStatus() const {
-        std::cout << "\n=== Player Status ===" << std::endl;
-        std::cout << "Name: " << fName << std::endl;
-        std::cout << "Health: " << fHealth << "/" << fMaxHealth << std::endl;
-        std::cout << "Attack Power: " << fAttackPower << std::endl;
-        std::cout << "Score: " << fScore << std::endl;
-        std::cout << "Inventory: ";
+    void displayStatus(OutputSink& aOut) const {
+        aOut << "\n=== Player Status ===\n";
+        aOut << "Name: " << fName << "\n";
+        aOut << "Health: " << fHealth << "/" << fMaxHealth << "\n";
+        aOut << "Attack Power: " << fAttackPower << "\n";
+        aOut << "Score: " << fScore << "\n";
+        aOut << "Inventory: ";
         if (fInventory.empty()) {
-            std::cout << "Empty" << std::endl;
+            aOut << "Empty\n";
         } else {
-            std::cout << std::endl;
-            for (const auto& item : fInventory) {
-                std::cout << "  - " << item << std::endl;
+            aOut << "\n";
+            for (const Inventory::Entry& entry : fInventory) {
+                aOut << "  - " << SymbolTable::global().resolve(entry.fItem);
+                if (entry.fCount > 1) {
+                    aOut << " x" << entry.fCount;
+                }
+                aOut << "\n";
             }
         }
-        std::cout << "===================" << std::endl;
+        aOut << "===================\n";
     }
 };
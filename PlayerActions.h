@@ -4,7 +4,8 @@
 #include "Item.h"
 #include "Clue.h"
 #include "Player.h"
-#include <iostream>
+#include "OutputSink.h"
+#include "ActionListener.h"
 
 /**
  * Concrete Visitor: Attack Action
@@ -13,40 +14,44 @@
 class AttackAction : public EntityVisitor {
 private:
     Player& fPlayer;
+    OutputSink& fOut;
+    ActionListener* fListener;  // Optional, notified of state changes
 
 public:
-    AttackAction(Player& aPlayer) : fPlayer(aPlayer) {}
+    AttackAction(Player& aPlayer, OutputSink& aOut, ActionListener* aListener = nullptr)
+        : fPlayer(aPlayer), fOut(aOut), fListener(aListener) {}
 
     void visitMonster(Monster& aMonster) override {
         if (!aMonster.isAlive()) {
-            std::cout << "The " << aMonster.getName() << " is already dead." << std::endl;
+            fOut << "The " << aMonster.getName() << " is already dead.\n";
             return;
         }
 
-        std::cout << "\n" << fPlayer.getName() << " attacks the " << aMonster.getName() << "!" << std::endl;
+        fOut << "\n" << fPlayer.getName() << " attacks the " << aMonster.getName() << "!\n";
         aMonster.takeDamage(fPlayer.getAttackPower());
-        std::cout << "You deal " << fPlayer.getAttackPower() << " damage!" << std::endl;
+        fOut << "You deal " << fPlayer.getAttackPower() << " damage!\n";
 
         if (!aMonster.isAlive()) {
-            std::cout << "The " << aMonster.getName() << " has been defeated!" << std::endl;
+            fOut << "The " << aMonster.getName() << " has been defeated!\n";
             fPlayer.addScore(50);
-            std::cout << "+50 points!" << std::endl;
+            fOut << "+50 points!\n";
+            if (fListener) fListener->onMonsterDefeated(aMonster);
         } else {
-            std::cout << "The " << aMonster.getName() << " has " << aMonster.getHealth()
-                     << " health remaining." << std::endl;
-            std::cout << "\nThe " << aMonster.getName() << " strikes back!" << std::endl;
+            fOut << "The " << aMonster.getName() << " has " << aMonster.getHealth()
+                     << " health remaining.\n";
+            fOut << "\nThe " << aMonster.getName() << " strikes back!\n";
             fPlayer.takeDamage(aMonster.getDamage());
-            std::cout << "You take " << aMonster.getDamage() << " damage! Health: "
-                     << fPlayer.getHealth() << "/" << fPlayer.getMaxHealth() << std::endl;
+            fOut << "You take " << aMonster.getDamage() << " damage! Health: "
+                     << fPlayer.getHealth() << "/" << fPlayer.getMaxHealth() << "\n";
         }
     }
 
     void visitItem(Item& aItem) override {
-        std::cout << "You can't attack the " << aItem.getName() << "! Try collecting it instead." << std::endl;
+        fOut << "You can't attack the " << aItem.getName() << "! Try collecting it instead.\n";
     }
 
     void visitClue(Clue& aClue) override {
-        std::cout << "You can't attack the " << aClue.getName() << "! Try examining it instead." << std::endl;
+        fOut << "You can't attack the " << aClue.getName() << "! Try examining it instead.\n";
     }
 };
 
@@ -57,30 +62,34 @@ public:
 class CollectAction : public EntityVisitor {
 private:
     Player& fPlayer;
+    OutputSink& fOut;
+    ActionListener* fListener;  // Optional, notified of state changes
 
 public:
-    CollectAction(Player& aPlayer) : fPlayer(aPlayer) {}
+    CollectAction(Player& aPlayer, OutputSink& aOut, ActionListener* aListener = nullptr)
+        : fPlayer(aPlayer), fOut(aOut), fListener(aListener) {}
 
     void visitMonster(Monster& aMonster) override {
-        std::cout << "You can't collect the " << aMonster.getName() << "! Try attacking it instead." << std::endl;
+        fOut << "You can't collect the " << aMonster.getName() << "! Try attacking it instead.\n";
     }
 
     void visitItem(Item& aItem) override {
         if (aItem.isCollected()) {
-            std::cout << "You have already collected the " << aItem.getName() << "." << std::endl;
+            fOut << "You have already collected the " << aItem.getName() << ".\n";
             return;
         }
 
-        std::cout << "\nYou collect the " << aItem.getName() << "!" << std::endl;
-        std::cout << aItem.getDescription() << std::endl;
+        fOut << "\nYou collect the " << aItem.getName() << "!\n";
+        fOut << aItem.getDescription() << "\n";
         aItem.collect();
-        fPlayer.addToInventory(aItem.getName());
+        fPlayer.addToInventory(aItem.getNameSymbol(), aItem.getValue());
         fPlayer.addScore(aItem.getValue());
-        std::cout << "+" << aItem.getValue() << " points!" << std::endl;
+        fOut << "+" << aItem.getValue() << " points!\n";
+        if (fListener) fListener->onItemCollected(aItem);
     }
 
     void visitClue(Clue& aClue) override {
-        std::cout << "You can't collect the " << aClue.getName() << "! Try examining it instead." << std::endl;
+        fOut << "You can't collect the " << aClue.getName() << "! Try examining it instead.\n";
     }
 };
 
@@ -91,45 +100,49 @@ public:
 class ExamineAction : public EntityVisitor {
 private:
     Player& fPlayer;
+    OutputSink& fOut;
+    ActionListener* fListener;  // Optional, notified of state changes
 
 public:
-    ExamineAction(Player& aPlayer) : fPlayer(aPlayer) {}
+    ExamineAction(Player& aPlayer, OutputSink& aOut, ActionListener* aListener = nullptr)
+        : fPlayer(aPlayer), fOut(aOut), fListener(aListener) {}
 
     void visitMonster(Monster& aMonster) override {
-        std::cout << "\nYou examine the " << aMonster.getName() << ":" << std::endl;
-        std::cout << aMonster.getDescription() << std::endl;
+        fOut << "\nYou examine the " << aMonster.getName() << ":\n";
+        fOut << aMonster.getDescription() << "\n";
         if (aMonster.isAlive()) {
-            std::cout << "Health: " << aMonster.getHealth() << std::endl;
-            std::cout << "Damage: " << aMonster.getDamage() << std::endl;
-            std::cout << "Status: Hostile and ready to attack!" << std::endl;
+            fOut << "Health: " << aMonster.getHealth() << "\n";
+            fOut << "Damage: " << aMonster.getDamage() << "\n";
+            fOut << "Status: Hostile and ready to attack!\n";
         } else {
-            std::cout << "Status: Defeated" << std::endl;
+            fOut << "Status: Defeated\n";
         }
     }
 
     void visitItem(Item& aItem) override {
-        std::cout << "\nYou examine the " << aItem.getName() << ":" << std::endl;
-        std::cout << aItem.getDescription() << std::endl;
-        std::cout << "Value: " << aItem.getValue() << " points" << std::endl;
+        fOut << "\nYou examine the " << aItem.getName() << ":\n";
+        fOut << aItem.getDescription() << "\n";
+        fOut << "Value: " << aItem.getValue() << " points\n";
         if (aItem.isCollected()) {
-            std::cout << "Status: Already collected" << std::endl;
+            fOut << "Status: Already collected\n";
         } else {
-            std::cout << "Status: Available to collect" << std::endl;
+            fOut << "Status: Available to collect\n";
         }
     }
 
     void visitClue(Clue& aClue) override {
-        std::cout << "\nYou examine the " << aClue.getName() << ":" << std::endl;
-        std::cout << aClue.getDescription() << std::endl;
+        fOut << "\nYou examine the " << aClue.getName() << ":\n";
+        fOut << aClue.getDescription() << "\n";
 
         if (!aClue.isExamined()) {
-            std::cout << "\n*** Hidden Information Revealed: ***" << std::endl;
-            std::cout << aClue.getHiddenInfo() << std::endl;
+            fOut << "\n*** Hidden Information Revealed: ***\n";
+            fOut << aClue.getHiddenInfo() << "\n";
             aClue.examine();
             fPlayer.addScore(25);
-            std::cout << "+25 points for discovering a clue!" << std::endl;
+            fOut << "+25 points for discovering a clue!\n";
+            if (fListener) fListener->onClueExamined(aClue);
         } else {
-            std::cout << "\nPreviously discovered: " << aClue.getHiddenInfo() << std::endl;
+            fOut << "\nPreviously discovered: " << aClue.getHiddenInfo() << "\n";
         }
     }
 };
@@ -1,73 +1,213 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
+#include "ColdText.h"
 #include "Entity.h"
+#include "OutputSink.h"
+#include "RoomGraph.h"
+#include "SymbolTable.h"
+#include "Instrumentation.h"
+
+class Room;
 
 /**
- * Room class - represents a node in the dungeon tree
- * Each room can contain multiple entities and connect to other rooms (children)
+ * Supplies the content of rooms that are loaded on demand (see RoomPager)
+ */
+class RoomLoader {
+public:
+    virtual ~RoomLoader() = default;
+
+    // Make a room's content resident and mark it most recently used
+    virtual void pageIn(const Room& aRoom) = 0;
+
+    // Entities of the whole dungeon, by id; the entity's room is paged in
+    virtual size_t getEntityCount() const = 0;
+    virtual Entity* getEntity(size_t aId) = 0;
+
+    // Mutable state of an entity, read without paging its room in: health
+    // (0 for anything but a live monster) and the collected/examined flags
+    struct EntityState {
+        int fHealth;
+        bool fIsCollected;
+        bool fIsExamined;
+    };
+
+    virtual EntityState getEntityState(size_t aId) = 0;
+
+    // What an entity is, the room it starts in and, for an item, its value,
+    // read without paging its room in
+    struct EntityInfo {
+        enum class Kind : uint8_t {
+            Monster,
+            Item,
+            Clue
+        };
+
+        Kind fKind;
+        uint32_t fRoom;
+        int fValue;  // Items only
+    };
+
+    virtual EntityInfo getEntityInfo(size_t aId) = 0;
+};
+
+/**
+ * Room class - represents a node in the dungeon graph
+ * Each room can contain multiple entities; its doors to other rooms are kept
+ * by the dungeon's RoomGraph and read through it.
+ * Rooms are created by Dungeon: the entity list allocates from the dungeon's
+ * arena and all text must outlive the room. The description may be held
+ * compressed (see ColdTextStore) and is then decoded when read.
+ * A paged room (one with a RoomLoader) only keeps its name; its description
+ * and entities are loaded on first use and may be dropped again, so views
+ * and pointers into them are only valid until another room is paged in.
+ * describe() renders the room once and then writes the cached text; the
+ * text changes only with the room's content or doors, which drop it (play
+ * state lives in SessionState and is not part of it). Rendering is safe
+ * from several threads at once, changing the room is not.
  */
 class Room {
 private:
-    std::string fName;
-    std::string fDescription;
-    std::vector<std::shared_ptr<Entity>> fEntities;
-    std::vector<Room*> fConnectedRooms;  // Child nodes in the tree
-    std::vector<std::string> fDoorNames;  // Names for each door/edge
+    static constexpr size_t kRenderedSizeHint = 512;  // Typical describe() text, so rendering rarely regrows
+
+    std::string_view fName;
+    StoredText fDescription;
+    std::pmr::vector<Entity*> fEntities;  // Owned by the Dungeon
+    const RoomGraph* fGraph;  // Doors; owned by the Dungeon
+    size_t fId;  // Position in Dungeon::getRooms()
+    RoomLoader* fLoader;  // Set for paged rooms
+    mutable std::atomic<const std::string*> fRendered;  // describe() text, built on first use
+
+    void page() const {
+        if (fLoader) fLoader->pageIn(*this);
+    }
+
+    template <typename EntityAt>
+    void render(OutputSink& aOut, size_t aEntityCount, EntityAt aEntityAt) const {
+        aOut << "\n========================================\n";
+        aOut << "  " << fName << "\n";
+        aOut << "========================================\n";
+        aOut << fDescription.view() << "\n";
+
+        if (aEntityCount > 0) {
+            aOut << "\nYou see the following:\n";
+            for (size_t i = 0; i < aEntityCount; ++i) {
+                const Entity* entity = aEntityAt(i);
+                aOut << "  " << (i + 1) << ". " << entity->getName() << " - " << entity->getDescription() << "\n";
+            }
+        } else {
+            aOut << "\nThe room appears empty.\n";
+        }
+
+        size_t doorCount = getDoorCount();
+        if (doorCount > 0) {
+            aOut << "\nDoors/Exits:\n";
+            for (size_t i = 0; i < doorCount; ++i) {
+                aOut << "  " << (i + 1) << ". " << getDoorName(i) << "\n";
+            }
+        } else {
+            aOut << "\nThere are no visible exits. This might be the final room!\n";
+        }
+        aOut << "========================================\n";
+    }
 
 public:
-    Room(const std::string& aName, const std::string& aDescription)
-        : fName(aName), fDescription(aDescription) {}
+    Room(std::string_view aName, StoredText aDescription,
+         std::pmr::memory_resource* aArena = std::pmr::get_default_resource())
+        : fName(aName), fDescription(aDescription),
+          fEntities(aArena), fGraph(nullptr), fId(0), fLoader(nullptr), fRendered(nullptr) {}
+
+    ~Room() {
+        delete fRendered.load(std::memory_order_relaxed);
+    }
+
+    Room(const Room&) = delete;
+    Room& operator=(const Room&) = delete;
 
     // Getter methods
-    const std::string& getName() const { return fName; }
-    const std::string& getDescription() const { return fDescription; }
-    const std::vector<std::shared_ptr<Entity>>& getEntities() const { return fEntities; }
-    const std::vector<Room*>& getConnectedRooms() const { return fConnectedRooms; }
-    const std::vector<std::string>& getDoorNames() const { return fDoorNames; }
+    size_t getId() const { return fId; }
+    void setId(size_t aId) { fId = aId; }
+    std::string_view getName() const { return fName; }
+    std::string_view getDescription() const { page(); return fDescription.view(); }
+    const StoredText& getDescriptionText() const { page(); return fDescription; }
+    const std::pmr::vector<Entity*>& getEntities() const { page(); return fEntities; }
+
+    // Doors, in the order they were added
+    RoomView getConnectedRooms() const { return fGraph->getDoors(static_cast<uint32_t>(fId)); }
+    size_t getDoorCount() const { return fGraph->getDoorCount(static_cast<uint32_t>(fId)); }
+    std::string_view getDoorName(size_t aIndex) const {
+        return SymbolTable::global().resolve(fGraph->getDoorName(static_cast<uint32_t>(fId), aIndex));
+    }
+    Symbol getDoorKey(size_t aIndex) const { return fGraph->getDoorKey(static_cast<uint32_t>(fId), aIndex); }
 
     // Add an entity to this room
-    void addEntity(std::shared_ptr<Entity> aEntity) {
+    void addEntity(Entity* aEntity) {
         fEntities.push_back(aEntity);
+        invalidateText();
+    }
+
+    void reserveEntities(size_t aCount) {
+        fEntities.reserve(aCount);
+    }
+
+    // Set by the Dungeon when the room is created
+    void setGraph(const RoomGraph* aGraph) { fGraph = aGraph; }
+
+    // Paging support (used by the RoomLoader)
+    void setLoader(RoomLoader* aLoader) { fLoader = aLoader; }
+    void setDescription(StoredText aDescription) {
+        fDescription = aDescription;
+        invalidateText();
+    }
+    const std::pmr::vector<Entity*>& getResidentEntities() const { return fEntities; }  // Without paging in
+
+    // Forget the content, freeing the lists; entities are not destroyed
+    void releaseContent() {
+        fDescription = StoredText();
+        std::pmr::vector<Entity*>(fEntities.get_allocator()).swap(fEntities);
+        invalidateText();
     }
 
-    // Connect this room to another room (add child node)
-    void connectRoom(Room* aRoom, const std::string& aDoorName) {
-        fConnectedRooms.push_back(aRoom);
-        fDoorNames.push_back(aDoorName);
+    // Drop the cached describe() text; called whenever what it shows changes
+    void invalidateText() {
+        delete fRendered.exchange(nullptr, std::memory_order_acq_rel);
     }
 
     // Display room information
-    void describe() const {
-        std::cout << "\n========================================" << std::endl;
-        std::cout << "  " << fName << std::endl;
-        std::cout << "========================================" << std::endl;
-        std::cout << fDescription << std::endl;
-
-        if (!fEntities.empty()) {
-            std::cout << "\nYou see the following:" << std::endl;
-            for (size_t i = 0; i < fEntities.size(); ++i) {
-                std::cout << "  " << (i + 1) << ". " << fEntities[i]->getName()
-                         << " - " << fEntities[i]->getDescription() << std::endl;
+    void describe(OutputSink& aOut) const {
+        INSTRUMENT_SCOPE(Instrumentation::Metric::Describe);
+        page();
+        const std::string* text = fRendered.load(std::memory_order_acquire);
+        if (!text) {
+            // Threads rendering at the same time keep whichever text is published first
+            BufferSink buffer;
+            buffer.reserve(kRenderedSizeHint);
+            render(buffer, fEntities.size(), [this](size_t aIndex) { return fEntities[aIndex]; });
+            auto rendered = std::make_unique<const std::string>(buffer.takeText());
+            if (fRendered.compare_exchange_strong(text, rendered.get(), std::memory_order_acq_rel)) {
+                text = rendered.release();
             }
-        } else {
-            std::cout << "\nThe room appears empty." << std::endl;
         }
+        aOut << *text;
+    }
 
-        if (!fConnectedRooms.empty()) {
-            std::cout << "\nDoors/Exits:" << std::endl;
-            for (size_t i = 0; i < fDoorNames.size(); ++i) {
-                std::cout << "  " << (i + 1) << ". " << fDoorNames[i] << std::endl;
-            }
-        } else {
-            std::cout << "\nThere are no visible exits. This might be the final room!" << std::endl;
-        }
-        std::cout << "========================================" << std::endl;
+    // Display the room with other entities than its own (a session's view of
+    // it), rendered afresh; aEntityAt(i) returns the i-th entity
+    template <typename EntityAt>
+    void describe(OutputSink& aOut, size_t aEntityCount, EntityAt aEntityAt) const {
+        INSTRUMENT_SCOPE(Instrumentation::Metric::Describe);
+        page();
+        render(aOut, aEntityCount, aEntityAt);
     }
 
     // Get entity by index
-    std::shared_ptr<Entity> getEntity(size_t aIndex) {
+    Entity* getEntity(size_t aIndex) const {
+        page();
         if (aIndex < fEntities.size()) {
             return fEntities[aIndex];
         }
@@ -75,9 +215,10 @@ public:
     }
 
     // Get connected room by index
-    Room* getConnectedRoom(size_t aIndex) {
-        if (aIndex < fConnectedRooms.size()) {
-            return fConnectedRooms[aIndex];
+    Room* getConnectedRoom(size_t aIndex) const {
+        RoomView doors = getConnectedRooms();
+        if (aIndex < doors.size()) {
+            return doors[aIndex];
         }
         return nullptr;
     }
@@ -0,0 +1,323 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "Inventory.h"
+#include "SymbolTable.h"
+
+class Room;
+
+/**
+ * Rooms behind the doors of one room, in door order
+ * A view into the dungeon's door arrays: valid until rooms or doors are
+ * added to the dungeon.
+ */
+class RoomView {
+private:
+    Room* const* fRooms;      // All rooms, by id
+    const uint32_t* fTargets; // Room id behind each door
+    const Symbol* fKeys;      // Key of each door (0 if unlocked)
+    size_t fCount;
+
+public:
+    class iterator {
+    private:
+        Room* const* fRooms;
+        const uint32_t* fTarget;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Room*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Room* const*;
+        using reference = Room*;
+
+        iterator() : fRooms(nullptr), fTarget(nullptr) {}
+        iterator(Room* const* aRooms, const uint32_t* aTarget) : fRooms(aRooms), fTarget(aTarget) {}
+
+        Room* operator*() const { return fRooms[*fTarget]; }
+        Room* operator[](difference_type aOffset) const { return fRooms[fTarget[aOffset]]; }
+        iterator& operator++() { ++fTarget; return *this; }
+        iterator operator++(int) { iterator previous = *this; ++fTarget; return previous; }
+        iterator& operator--() { --fTarget; return *this; }
+        iterator operator--(int) { iterator previous = *this; --fTarget; return previous; }
+        iterator& operator+=(difference_type aOffset) { fTarget += aOffset; return *this; }
+        iterator& operator-=(difference_type aOffset) { fTarget -= aOffset; return *this; }
+        iterator operator+(difference_type aOffset) const { return iterator(fRooms, fTarget + aOffset); }
+        iterator operator-(difference_type aOffset) const { return iterator(fRooms, fTarget - aOffset); }
+        friend iterator operator+(difference_type aOffset, const iterator& aIt) { return aIt + aOffset; }
+        difference_type operator-(const iterator& aOther) const { return fTarget - aOther.fTarget; }
+        bool operator==(const iterator& aOther) const { return fTarget == aOther.fTarget; }
+        bool operator!=(const iterator& aOther) const { return fTarget != aOther.fTarget; }
+        bool operator<(const iterator& aOther) const { return fTarget < aOther.fTarget; }
+        bool operator>(const iterator& aOther) const { return fTarget > aOther.fTarget; }
+        bool operator<=(const iterator& aOther) const { return fTarget <= aOther.fTarget; }
+        bool operator>=(const iterator& aOther) const { return fTarget >= aOther.fTarget; }
+    };
+
+    RoomView(Room* const* aRooms, const uint32_t* aTargets, const Symbol* aKeys, size_t aCount)
+        : fRooms(aRooms), fTargets(aTargets), fKeys(aKeys), fCount(aCount) {}
+
+    size_t size() const { return fCount; }
+    bool empty() const { return fCount == 0; }
+    Room* operator[](size_t aDoor) const { return fRooms[fTargets[aDoor]]; }
+    iterator begin() const { return iterator(fRooms, fTargets); }
+    iterator end() const { return iterator(fRooms, fTargets + fCount); }
+
+    // Id of the room behind a door, without touching the room
+    uint32_t getRoomId(size_t aDoor) const { return fTargets[aDoor]; }
+
+    // Item a player needs to go through a door (0 if it is not locked)
+    Symbol getKey(size_t aDoor) const { return fKeys[aDoor]; }
+};
+
+/**
+ * The rooms of a dungeon and the doors between them, in compressed sparse
+ * row form
+ *
+ * Doors are directed: a door leads from one room to another, and a way back
+ * is a door of its own, so any graph can be built (back-edges, cycles,
+ * one-way doors, several doors between the same rooms). The doors of room r
+ * are entries fFirstDoor[r] to fFirstDoor[r + 1] - 1 of parallel arrays
+ * (target room id, name, key), so traversals walk contiguous arrays of ids
+ * without touching the Room objects. A door with a key is locked: only a
+ * player holding an item of that name can go through.
+ * Doors wait in a pending list until the next read, which folds them into
+ * the arrays while keeping every room's doors in the order they were added.
+ * Reading therefore changes the graph while doors are pending: a dungeon
+ * shared between threads must have been compacted first (Dungeon::buildIndex
+ * does this).
+ */
+class RoomGraph {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+private:
+    struct PendingDoor {
+        uint32_t fFrom;
+        uint32_t fTo;
+        Symbol fName;
+        Symbol fKey;
+    };
+
+    std::vector<Room*> fRooms;  // By room id
+    mutable std::vector<uint32_t> fFirstDoor;  // Per room, plus the end of the last room's doors
+    mutable std::vector<uint32_t> fTargets;
+    mutable std::vector<Symbol> fNames;
+    mutable std::vector<Symbol> fKeys;
+    mutable std::vector<PendingDoor> fPending;
+
+    void update() const {
+        if (!fPending.empty() || fFirstDoor.size() != fRooms.size() + 1) {
+            compact();
+        }
+    }
+
+    bool canPass(size_t aDoor, const Inventory* aKeys) const {
+        return !aKeys || fKeys[aDoor] == 0 || aKeys->has(fKeys[aDoor]);
+    }
+
+    // Rooms reachable from a start room, each once, breadth- or depth-first
+    // in door order
+    template <bool kBreadthFirst>
+    class Traversal {
+    private:
+        const RoomGraph& fGraph;
+        std::vector<uint32_t> fWaiting;  // Queue (from fHead) or stack
+        size_t fHead;
+        std::vector<bool> fSeen;
+
+    public:
+        class iterator {
+        private:
+            Traversal* fTraversal;
+            uint32_t fRoom;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = uint32_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const uint32_t*;
+            using reference = uint32_t;
+
+            iterator(Traversal* aTraversal, uint32_t aRoom) : fTraversal(aTraversal), fRoom(aRoom) {}
+
+            uint32_t operator*() const { return fRoom; }
+            iterator& operator++() { fRoom = fTraversal->next(); return *this; }
+            bool operator==(const iterator& aOther) const { return fRoom == aOther.fRoom; }
+            bool operator!=(const iterator& aOther) const { return fRoom != aOther.fRoom; }
+        };
+
+        Traversal(const RoomGraph& aGraph, uint32_t aStart)
+            : fGraph(aGraph), fHead(0), fSeen(aGraph.getRoomCount(), false) {
+            fGraph.update();
+            if (aStart < fSeen.size()) {
+                fWaiting.push_back(aStart);
+                fSeen[aStart] = kBreadthFirst;
+            }
+        }
+
+        // Next room in order, or kNone once every reachable room was visited.
+        // Breadth-first marks rooms when queued; depth-first when visited, so
+        // a room is reached by the first door of the deepest room leading to it
+        uint32_t next() {
+            uint32_t room;
+            if (kBreadthFirst) {
+                if (fHead == fWaiting.size()) return kNone;
+                room = fWaiting[fHead++];
+            } else {
+                do {
+                    if (fWaiting.empty()) return kNone;
+                    room = fWaiting.back();
+                    fWaiting.pop_back();
+                } while (fSeen[room]);
+                fSeen[room] = true;
+            }
+            uint32_t first = fGraph.fFirstDoor[room];
+            uint32_t last = fGraph.fFirstDoor[room + 1];
+            for (uint32_t i = first; i < last; ++i) {
+                // Depth-first pushes the last door first so the first is taken first
+                uint32_t target = fGraph.fTargets[kBreadthFirst ? i : first + last - 1 - i];
+                if (!fSeen[target]) {
+                    fSeen[target] = kBreadthFirst;
+                    fWaiting.push_back(target);
+                }
+            }
+            return room;
+        }
+
+        iterator begin() { return iterator(this, next()); }
+        iterator end() { return iterator(this, kNone); }
+    };
+
+public:
+    using BreadthFirst = Traversal<true>;
+    using DepthFirst = Traversal<false>;
+
+    // Register the next room; its id is its position
+    void addRoom(Room* aRoom) {
+        fRooms.push_back(aRoom);
+    }
+
+    void reserve(size_t aRooms, size_t aDoors = 0) {
+        fRooms.reserve(aRooms);
+        fPending.reserve(aDoors);
+    }
+
+    // Add a door; aKey is the item needed to go through it (0 if none)
+    void addDoor(uint32_t aFrom, uint32_t aTo, Symbol aName, Symbol aKey = 0) {
+        fPending.push_back(PendingDoor{aFrom, aTo, aName, aKey});
+    }
+
+    // Fold pending doors into the arrays; a counting sort by room, stable so
+    // each room keeps its doors in the order they were added
+    void compact() const {
+        size_t roomCount = fRooms.size();
+        std::vector<uint32_t> first(roomCount + 1, 0);
+        for (size_t room = 0; room + 1 < fFirstDoor.size(); ++room) {
+            first[room + 1] = fFirstDoor[room + 1] - fFirstDoor[room];
+        }
+        for (const PendingDoor& door : fPending) {
+            ++first[door.fFrom + 1];
+        }
+        for (size_t room = 0; room < roomCount; ++room) {
+            first[room + 1] += first[room];
+        }
+
+        size_t doorCount = first[roomCount];
+        std::vector<uint32_t> targets(doorCount);
+        std::vector<Symbol> names(doorCount);
+        std::vector<Symbol> keys(doorCount);
+        std::vector<uint32_t> next(first.begin(), first.end() - 1);
+        for (size_t room = 0; room + 1 < fFirstDoor.size(); ++room) {
+            for (uint32_t door = fFirstDoor[room]; door < fFirstDoor[room + 1]; ++door) {
+                uint32_t slot = next[room]++;
+                targets[slot] = fTargets[door];
+                names[slot] = fNames[door];
+                keys[slot] = fKeys[door];
+            }
+        }
+        for (const PendingDoor& door : fPending) {
+            uint32_t slot = next[door.fFrom]++;
+            targets[slot] = door.fTo;
+            names[slot] = door.fName;
+            keys[slot] = door.fKey;
+        }
+
+        fFirstDoor.swap(first);
+        fTargets.swap(targets);
+        fNames.swap(names);
+        fKeys.swap(keys);
+        fPending.clear();
+        fPending.shrink_to_fit();
+    }
+
+    const std::vector<Room*>& getRooms() const { return fRooms; }
+    size_t getRoomCount() const { return fRooms.size(); }
+
+    size_t getDoorCount() const {
+        update();
+        return fTargets.size();
+    }
+
+    RoomView getDoors(uint32_t aRoom) const {
+        update();
+        uint32_t first = fFirstDoor[aRoom];
+        return RoomView(fRooms.data(), fTargets.data() + first, fKeys.data() + first, fFirstDoor[aRoom + 1] - first);
+    }
+
+    size_t getDoorCount(uint32_t aRoom) const {
+        update();
+        return fFirstDoor[aRoom + 1] - fFirstDoor[aRoom];
+    }
+
+    Symbol getDoorName(uint32_t aRoom, size_t aDoor) const {
+        update();
+        return fNames[fFirstDoor[aRoom] + aDoor];
+    }
+
+    Symbol getDoorKey(uint32_t aRoom, size_t aDoor) const {
+        update();
+        return fKeys[fFirstDoor[aRoom] + aDoor];
+    }
+
+    // Rooms reachable from aStart (ids), nearest first / one way down at a
+    // time; locked doors are followed too
+    BreadthFirst breadthFirst(uint32_t aStart) const { return BreadthFirst(*this, aStart); }
+    DepthFirst depthFirst(uint32_t aStart) const { return DepthFirst(*this, aStart); }
+
+    // Doors (each an index among its room's doors) on a shortest way from
+    // aFrom to aTo, found breadth-first. Locked doors are only used if aKeys
+    // holds their key; without aKeys locks are ignored. Returns false if aTo
+    // cannot be reached.
+    bool findPath(uint32_t aFrom, uint32_t aTo, std::vector<uint32_t>& aDoors,
+                  const Inventory* aKeys = nullptr) const {
+        update();
+        aDoors.clear();
+        std::vector<uint32_t> cameFrom(fRooms.size(), kNone);  // Room and door that first reached each room
+        std::vector<uint32_t> cameBy(fRooms.size(), kNone);
+        std::vector<uint32_t> queue{aFrom};
+        cameFrom[aFrom] = aFrom;
+        for (size_t head = 0; head < queue.size() && cameFrom[aTo] == kNone; ++head) {
+            uint32_t room = queue[head];
+            for (uint32_t door = fFirstDoor[room]; door < fFirstDoor[room + 1]; ++door) {
+                uint32_t target = fTargets[door];
+                if (cameFrom[target] == kNone && canPass(door, aKeys)) {
+                    cameFrom[target] = room;
+                    cameBy[target] = door - fFirstDoor[room];
+                    queue.push_back(target);
+                }
+            }
+        }
+        if (cameFrom[aTo] == kNone) {
+            return false;
+        }
+        for (uint32_t room = aTo; room != aFrom; room = cameFrom[room]) {
+            aDoors.push_back(cameBy[room]);
+        }
+        std::reverse(aDoors.begin(), aDoors.end());
+        return true;
+    }
+};
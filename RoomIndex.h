@@ -0,0 +1,242 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Room.h"
+
+/**
+ * Lookup structures over a dungeon's room tree: the spanning tree a DFS
+ * from the entrance takes through the doors (each room's parent is the room
+ * it was first reached from). Built once after construction
+ * (Dungeon::buildIndex), it answers:
+ * - name -> Room in O(1) (first room with that name)
+ * - parent, depth and door index of the door leading into each room
+ * - "is A an ancestor of B" in O(1) using DFS entry/exit times
+ * - lowest common ancestor in O(log n) using a range minimum over the Euler
+ *   tour: blocks of kBlockSize entries are scanned directly and whole blocks
+ *   are covered by a sparse table, so memory stays O(n)
+ * - paths between rooms and routes (door indices) from a room to a descendant
+ * - the rooms below a room, as a contiguous range of the DFS preorder
+ * Rooms that cannot be reached from the entrance have no parent and no depth.
+ */
+class RoomIndex {
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+private:
+    static constexpr size_t kBlockSize = 32;
+
+    std::vector<Room*> fRooms;  // By Room::getId()
+    std::unordered_map<std::string_view, uint32_t> fByName;
+    std::vector<uint32_t> fParent;
+    std::vector<uint32_t> fDepth;
+    std::vector<uint32_t> fDoorIndex;  // Index of the door in the parent leading here
+    std::vector<uint32_t> fEnter;      // DFS entry time, also first position in the Euler tour
+    std::vector<uint32_t> fExit;       // Last position in the Euler tour
+    std::vector<uint32_t> fEuler;      // Room ids in Euler-tour order
+    std::vector<uint32_t> fPreorder;   // Reachable room ids, parents before children
+    std::vector<uint32_t> fPosition;   // Position in fPreorder
+    std::vector<uint32_t> fSubtreeEnd; // Position in fPreorder after the last room below
+    std::vector<std::vector<uint32_t>> fBlockMin;  // Sparse table of block minima (Euler positions)
+
+    // Euler position with the smaller depth
+    uint32_t shallower(uint32_t aFirst, uint32_t aSecond) const {
+        return fDepth[fEuler[aSecond]] < fDepth[fEuler[aFirst]] ? aSecond : aFirst;
+    }
+
+    uint32_t scanMinimum(size_t aFrom, size_t aTo) const {
+        uint32_t best = static_cast<uint32_t>(aFrom);
+        for (size_t i = aFrom + 1; i <= aTo; ++i) {
+            best = shallower(best, static_cast<uint32_t>(i));
+        }
+        return best;
+    }
+
+    // Euler position of the shallowest room in [aFrom, aTo]
+    uint32_t rangeMinimum(size_t aFrom, size_t aTo) const {
+        size_t firstBlock = aFrom / kBlockSize;
+        size_t lastBlock = aTo / kBlockSize;
+        if (lastBlock - firstBlock <= 1) {
+            return scanMinimum(aFrom, aTo);
+        }
+        uint32_t best = shallower(scanMinimum(aFrom, (firstBlock + 1) * kBlockSize - 1),
+                                  scanMinimum(lastBlock * kBlockSize, aTo));
+        size_t from = firstBlock + 1;
+        size_t to = lastBlock - 1;
+        size_t level = 0;
+        while ((size_t(2) << level) <= to - from + 1) ++level;
+        best = shallower(best, fBlockMin[level][from]);
+        return shallower(best, fBlockMin[level][to - (size_t(1) << level) + 1]);
+    }
+
+    void buildBlockTable() {
+        size_t blockCount = (fEuler.size() + kBlockSize - 1) / kBlockSize;
+        fBlockMin.assign(1, std::vector<uint32_t>(blockCount));
+        for (size_t b = 0; b < blockCount; ++b) {
+            fBlockMin[0][b] = scanMinimum(b * kBlockSize, std::min(fEuler.size(), (b + 1) * kBlockSize) - 1);
+        }
+        for (size_t level = 1; (size_t(1) << level) <= blockCount; ++level) {
+            const std::vector<uint32_t>& previous = fBlockMin[level - 1];
+            std::vector<uint32_t> current(blockCount - (size_t(1) << level) + 1);
+            for (size_t b = 0; b < current.size(); ++b) {
+                current[b] = shallower(previous[b], previous[b + (size_t(1) << (level - 1))]);
+            }
+            fBlockMin.push_back(std::move(current));
+        }
+    }
+
+public:
+    // Index the rooms reachable from aRoot; aRooms must be ordered by Room::getId()
+    void build(const std::vector<Room*>& aRooms, Room* aRoot) {
+        size_t count = aRooms.size();
+        fRooms = aRooms;
+        fByName.clear();
+        fByName.reserve(count);
+        for (Room* room : aRooms) {
+            fByName.emplace(room->getName(), static_cast<uint32_t>(room->getId()));
+        }
+        fParent.assign(count, kNone);
+        fDepth.assign(count, kNone);
+        fDoorIndex.assign(count, kNone);
+        fEnter.assign(count, kNone);
+        fExit.assign(count, kNone);
+        fEuler.clear();
+        fEuler.reserve(count * 2);
+        fPreorder.clear();
+        fPreorder.reserve(count);
+        fPosition.assign(count, kNone);
+        fSubtreeEnd.assign(count, kNone);
+        fBlockMin.clear();
+        if (!aRoot) {
+            return;
+        }
+
+        // Iterative DFS: (room, next child to visit)
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+        uint32_t root = static_cast<uint32_t>(aRoot->getId());
+        fDepth[root] = 0;
+        fEnter[root] = 0;
+        fEuler.push_back(root);
+        fPosition[root] = 0;
+        fPreorder.push_back(root);
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [current, nextChild] = stack.back();
+            const auto& children = fRooms[current]->getConnectedRooms();
+            if (nextChild < children.size()) {
+                uint32_t doorIndex = nextChild++;
+                uint32_t child = children.getRoomId(doorIndex);
+                if (fDepth[child] != kNone) {
+                    continue;  // Already reached through another door
+                }
+                fParent[child] = current;
+                fDepth[child] = fDepth[current] + 1;
+                fDoorIndex[child] = doorIndex;
+                fEnter[child] = static_cast<uint32_t>(fEuler.size());
+                fEuler.push_back(child);
+                fPosition[child] = static_cast<uint32_t>(fPreorder.size());
+                fPreorder.push_back(child);
+                stack.emplace_back(child, 0);
+            } else {
+                uint32_t finished = current;
+                fExit[finished] = static_cast<uint32_t>(fEuler.size() - 1);
+                fSubtreeEnd[finished] = static_cast<uint32_t>(fPreorder.size());
+                stack.pop_back();
+                if (!stack.empty()) {
+                    fEuler.push_back(stack.back().first);
+                }
+            }
+        }
+        buildBlockTable();
+    }
+
+    // First room with the given name, or nullptr
+    Room* findRoom(std::string_view aName) const {
+        auto found = fByName.find(aName);
+        return found != fByName.end() ? fRooms[found->second] : nullptr;
+    }
+
+    // Ids of the rooms reachable from the entrance, every parent before its children
+    const std::vector<uint32_t>& getPreorder() const { return fPreorder; }
+
+    // The rooms below a room (itself included) are getPreorder() from its
+    // position up to its subtree end; both are kNone if it is unreachable
+    uint32_t getPreorderPosition(const Room* aRoom) const { return fPosition[aRoom->getId()]; }
+    uint32_t getSubtreeEnd(const Room* aRoom) const { return fSubtreeEnd[aRoom->getId()]; }
+
+    bool isReachable(const Room* aRoom) const { return fDepth[aRoom->getId()] != kNone; }
+
+    Room* getParent(const Room* aRoom) const {
+        uint32_t parent = fParent[aRoom->getId()];
+        return parent != kNone ? fRooms[parent] : nullptr;
+    }
+
+    // Number of doors between the entrance and the room (kNone if unreachable)
+    uint32_t getDepth(const Room* aRoom) const { return fDepth[aRoom->getId()]; }
+
+    // Index of the door in the parent room that leads to this room (kNone for the root)
+    uint32_t getDoorIndex(const Room* aRoom) const { return fDoorIndex[aRoom->getId()]; }
+
+    // True if aAncestor is aRoom or lies on the path from the entrance to aRoom
+    bool isAncestor(const Room* aAncestor, const Room* aRoom) const {
+        size_t a = aAncestor->getId();
+        size_t r = aRoom->getId();
+        return isReachable(aAncestor) && isReachable(aRoom) &&
+               fEnter[a] <= fEnter[r] && fExit[r] <= fExit[a];
+    }
+
+    // Deepest room that is an ancestor of both, or nullptr if either is unreachable
+    Room* lowestCommonAncestor(const Room* aFirst, const Room* aSecond) const {
+        if (!isReachable(aFirst) || !isReachable(aSecond)) {
+            return nullptr;
+        }
+        size_t from = fEnter[aFirst->getId()];
+        size_t to = fEnter[aSecond->getId()];
+        if (from > to) std::swap(from, to);
+        return fRooms[fEuler[rangeMinimum(from, to)]];
+    }
+
+    // Number of doors on the tree path between two rooms
+    uint32_t getDistance(const Room* aFirst, const Room* aSecond) const {
+        Room* common = lowestCommonAncestor(aFirst, aSecond);
+        if (!common) return kNone;
+        return getDepth(aFirst) + getDepth(aSecond) - 2 * getDepth(common);
+    }
+
+    // Rooms on the tree path from aFrom to aTo, both included (empty if unconnected)
+    std::vector<Room*> getPath(const Room* aFrom, const Room* aTo) const {
+        std::vector<Room*> path;
+        Room* common = lowestCommonAncestor(aFrom, aTo);
+        if (!common) {
+            return path;
+        }
+        for (Room* room = fRooms[aFrom->getId()]; room != common; room = getParent(room)) {
+            path.push_back(room);
+        }
+        size_t upLength = path.size();
+        for (Room* room = fRooms[aTo->getId()]; room != common; room = getParent(room)) {
+            path.push_back(room);
+        }
+        path.insert(path.begin() + static_cast<std::ptrdiff_t>(upLength), common);
+        std::reverse(path.begin() + static_cast<std::ptrdiff_t>(upLength) + 1, path.end());
+        return path;
+    }
+
+    // Door indices to follow from aFrom to reach aTo along the index's DFS
+    // spanning tree, so this succeeds only if aFrom is an ancestor of aTo there.
+    // Back-edges, cycles and locks are not considered and the route need not be
+    // the shortest; RoomGraph::findPath finds shortest ways through any doors
+    bool getRoute(const Room* aFrom, const Room* aTo, std::vector<uint32_t>& aDoors) const {
+        aDoors.clear();
+        if (!isAncestor(aFrom, aTo)) {
+            return false;
+        }
+        for (const Room* room = aTo; room != aFrom; room = getParent(room)) {
+            aDoors.push_back(getDoorIndex(room));
+        }
+        std::reverse(aDoors.begin(), aDoors.end());
+        return true;
+    }
+};
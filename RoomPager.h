@@ -0,0 +1,377 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Dungeon.h"
+#include "DungeonFile.h"
+#include "EntityVisitor.h"
+
+/**
+ * Loads the rooms of a dungeon file on first use and evicts the least
+ * recently used ones to stay within a memory budget
+ *
+ * A dungeon from loadPagedDungeon() keeps only its rooms and doors (room
+ * names and the door graph, with door names and keys) in memory. A room's
+ * description and entities are created from the mapped file when the room
+ * is first used and destroyed again when it is evicted. The budget covers
+ * the heap memory of resident content (entity objects and the entity list);
+ * the text itself stays in the mapping, which the kernel pages as it sees
+ * fit. The most recently used room is never evicted, so the room being
+ * played is always resident even if it alone exceeds the budget.
+ * Entities changed in place (monster health, collected and examined flags)
+ * have their state saved when their room is evicted and put back when it is
+ * loaded again. A SessionState keeps its own state outside the dungeon and
+ * is not affected by paging at all.
+ */
+class RoomPager : public RoomLoader {
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Slot {
+        Room* fRoom;
+        uint32_t fNewer;  // Next room towards the most recently used
+        uint32_t fOlder;  // Next room towards the least recently used
+        uint32_t fBytes;  // Heap memory of the content while resident
+        bool fIsResident;
+    };
+
+    DungeonFile::Loader fFile;
+    const DungeonFile::RoomRecord* fRoomRecords;
+    const DungeonFile::EntityRecord* fEntityRecords;
+    std::vector<Slot> fSlots;  // Indexed by room id
+    uint32_t fNewest;
+    uint32_t fOldest;
+    uint32_t fLastEntityRoom;  // Room of the last getEntity(), checked first
+    std::unordered_map<uint32_t, int> fSaved;  // Changed state of evicted entities, by entity id
+    size_t fBudget;
+    size_t fResidentRooms;
+    size_t fResidentBytes;
+    size_t fPeakBytes;
+    size_t fLoads;
+    size_t fEvictions;
+
+    // Records the state of entities that differ from the file: monster
+    // health, or 1 for a collected item or examined clue
+    class StateSaver : public EntityVisitor {
+    private:
+        RoomPager& fPager;
+
+    public:
+        StateSaver(RoomPager& aPager) : fPager(aPager) {}
+
+        void visitMonster(Monster& aMonster) override {
+            if (!aMonster.isAlive() || aMonster.getHealth() != fPager.fEntityRecords[aMonster.getId()].fStatA) {
+                fPager.fSaved[static_cast<uint32_t>(aMonster.getId())] = aMonster.getHealth();
+            }
+        }
+
+        void visitItem(Item& aItem) override {
+            if (aItem.isCollected()) fPager.fSaved[static_cast<uint32_t>(aItem.getId())] = 1;
+        }
+
+        void visitClue(Clue& aClue) override {
+            if (aClue.isExamined()) fPager.fSaved[static_cast<uint32_t>(aClue.getId())] = 1;
+        }
+    };
+
+    class StateRestorer : public EntityVisitor {
+    private:
+        int fState;
+
+    public:
+        StateRestorer(int aState) : fState(aState) {}
+
+        void visitMonster(Monster& aMonster) override { aMonster.setHealth(fState); }
+        void visitItem(Item& aItem) override { aItem.setCollected(true); }
+        void visitClue(Clue& aClue) override { aClue.setExamined(true); }
+    };
+
+    // State of a resident entity
+    class StateReader : public EntityVisitor {
+    public:
+        EntityState fState{0, false, false};
+
+        void visitMonster(Monster& aMonster) override {
+            fState.fHealth = aMonster.isAlive() ? aMonster.getHealth() : 0;
+        }
+        void visitItem(Item& aItem) override { fState.fIsCollected = aItem.isCollected(); }
+        void visitClue(Clue& aClue) override { fState.fIsExamined = aClue.isExamined(); }
+    };
+
+    std::unique_ptr<Entity> createEntity(const DungeonFile::EntityRecord& aRecord, size_t& aBytes) const {
+        std::string_view name = fFile.text(aRecord.fName);
+        StoredText description = fFile.storedText(aRecord.fDescription);
+        switch (aRecord.fKind) {
+            case DungeonFile::kMonster:
+                aBytes += sizeof(Monster);
+                return std::make_unique<Monster>(name, description, aRecord.fStatA, aRecord.fStatB);
+            case DungeonFile::kItem:
+                aBytes += sizeof(Item);
+                return std::make_unique<Item>(name, description, aRecord.fStatA);
+            case DungeonFile::kClue:
+                aBytes += sizeof(Clue);
+                return std::make_unique<Clue>(name, description, fFile.storedText(aRecord.fHiddenInfo));
+        }
+        throw std::runtime_error("DungeonFile: unknown entity kind");
+    }
+
+    void unlink(uint32_t aRoom) {
+        Slot& slot = fSlots[aRoom];
+        (slot.fNewer != kNone ? fSlots[slot.fNewer].fOlder : fNewest) = slot.fOlder;
+        (slot.fOlder != kNone ? fSlots[slot.fOlder].fNewer : fOldest) = slot.fNewer;
+    }
+
+    void pushNewest(uint32_t aRoom) {
+        Slot& slot = fSlots[aRoom];
+        slot.fNewer = kNone;
+        slot.fOlder = fNewest;
+        (fNewest != kNone ? fSlots[fNewest].fNewer : fOldest) = aRoom;
+        fNewest = aRoom;
+    }
+
+    // Create the room's content; nothing changes if the file is malformed
+    void load(uint32_t aRoom) {
+        Slot& slot = fSlots[aRoom];
+        const DungeonFile::RoomRecord& record = fRoomRecords[aRoom];
+        StoredText description = fFile.storedText(record.fDescription);
+        size_t bytes = record.fEntityCount * sizeof(Entity*);
+        std::vector<std::unique_ptr<Entity>> entities;
+        entities.reserve(record.fEntityCount);
+        for (uint32_t e = 0; e < record.fEntityCount; ++e) {
+            entities.push_back(createEntity(fEntityRecords[record.fFirstEntity + e], bytes));
+        }
+
+        Room& room = *slot.fRoom;
+        room.setDescription(description);
+        for (uint32_t e = 0; e < record.fEntityCount; ++e) {
+            Entity* entity = entities[e].release();
+            size_t id = record.fFirstEntity + e;
+            entity->setId(id);
+            auto saved = fSaved.find(static_cast<uint32_t>(id));
+            if (saved != fSaved.end()) {
+                StateRestorer restorer(saved->second);
+                entity->accept(restorer);
+                fSaved.erase(saved);
+            }
+            room.addEntity(entity);
+        }
+
+        slot.fBytes = static_cast<uint32_t>(bytes);
+        slot.fIsResident = true;
+        ++fResidentRooms;
+        fResidentBytes += bytes;
+        if (fResidentBytes > fPeakBytes) fPeakBytes = fResidentBytes;
+        ++fLoads;
+    }
+
+    void evict(uint32_t aRoom) {
+        Slot& slot = fSlots[aRoom];
+        StateSaver saver(*this);
+        for (Entity* entity : slot.fRoom->getResidentEntities()) {
+            entity->accept(saver);
+            delete entity;
+        }
+        slot.fRoom->releaseContent();
+        unlink(aRoom);
+        fResidentBytes -= slot.fBytes;
+        slot.fBytes = 0;
+        slot.fIsResident = false;
+        --fResidentRooms;
+        ++fEvictions;
+    }
+
+    // Room holding an entity; entities are stored in room order
+    uint32_t roomOfEntity(size_t aId) const {
+        const DungeonFile::RoomRecord& last = fRoomRecords[fLastEntityRoom];
+        if (aId >= last.fFirstEntity && aId - last.fFirstEntity < last.fEntityCount) {
+            return fLastEntityRoom;
+        }
+        size_t low = 0;
+        size_t high = fSlots.size();  // First room starting after aId
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (fRoomRecords[middle].fFirstEntity <= aId) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return static_cast<uint32_t>(low - 1);
+    }
+
+public:
+    RoomPager(const DungeonFile::Loader& aFile, size_t aBudget)
+        : fFile(aFile), fRoomRecords(aFile.getRoomRecords()), fEntityRecords(aFile.getEntityRecords()),
+          fNewest(kNone), fOldest(kNone), fLastEntityRoom(0),
+          fBudget(aBudget), fResidentRooms(0), fResidentBytes(0), fPeakBytes(0), fLoads(0), fEvictions(0) {
+        fSlots.reserve(aFile.getHeader().fRoomCount);
+    }
+
+    ~RoomPager() override {
+        while (fOldest != kNone) {
+            evict(fOldest);
+        }
+    }
+
+    RoomPager(const RoomPager&) = delete;
+    RoomPager& operator=(const RoomPager&) = delete;
+
+    // Register the next room, in file order
+    void addRoom(Room* aRoom) {
+        aRoom->setLoader(this);
+        fSlots.push_back(Slot{aRoom, kNone, kNone, 0, false});
+    }
+
+    void pageIn(const Room& aRoom) override {
+        uint32_t id = static_cast<uint32_t>(aRoom.getId());
+        if (id == fNewest) {
+            return;
+        }
+        if (fSlots[id].fIsResident) {
+            unlink(id);
+            pushNewest(id);
+            return;
+        }
+        load(id);
+        pushNewest(id);
+        while (fResidentBytes > fBudget && fOldest != id) {
+            evict(fOldest);
+        }
+    }
+
+    size_t getEntityCount() const override {
+        return fFile.getHeader().fEntityCount;
+    }
+
+    Entity* getEntity(size_t aId) override {
+        fLastEntityRoom = roomOfEntity(aId);
+        const Room& room = *fSlots[fLastEntityRoom].fRoom;
+        return room.getEntities()[aId - fRoomRecords[fLastEntityRoom].fFirstEntity];
+    }
+
+    EntityState getEntityState(size_t aId) override {
+        uint32_t room = roomOfEntity(aId);
+        const Slot& slot = fSlots[room];
+        if (slot.fIsResident) {
+            StateReader reader;
+            slot.fRoom->getResidentEntities()[aId - fRoomRecords[room].fFirstEntity]->accept(reader);
+            return reader.fState;
+        }
+
+        const DungeonFile::EntityRecord& record = fEntityRecords[aId];
+        auto saved = fSaved.find(static_cast<uint32_t>(aId));
+        switch (record.fKind) {
+            case DungeonFile::kMonster:
+                return EntityState{saved != fSaved.end() ? saved->second : record.fStatA, false, false};
+            case DungeonFile::kItem:
+                return EntityState{0, saved != fSaved.end(), false};
+            case DungeonFile::kClue:
+                return EntityState{0, false, saved != fSaved.end()};
+        }
+        throw std::runtime_error("DungeonFile: unknown entity kind");
+    }
+
+    EntityInfo getEntityInfo(size_t aId) override {
+        const DungeonFile::EntityRecord& record = fEntityRecords[aId];
+        uint32_t room = roomOfEntity(aId);
+        switch (record.fKind) {
+            case DungeonFile::kMonster:
+                return EntityInfo{EntityInfo::Kind::Monster, room, 0};
+            case DungeonFile::kItem:
+                return EntityInfo{EntityInfo::Kind::Item, room, record.fStatA};
+            case DungeonFile::kClue:
+                return EntityInfo{EntityInfo::Kind::Clue, room, 0};
+        }
+        throw std::runtime_error("DungeonFile: unknown entity kind");
+    }
+
+    // Paging statistics
+    size_t getBudget() const { return fBudget; }
+    size_t getResidentRooms() const { return fResidentRooms; }
+    size_t getResidentBytes() const { return fResidentBytes; }
+    size_t getPeakBytes() const { return fPeakBytes; }
+    size_t getLoadCount() const { return fLoads; }
+    size_t getEvictionCount() const { return fEvictions; }
+    size_t getSavedStateCount() const { return fSaved.size(); }
+};
+
+// Map a binary dungeon file and build a paged Dungeon over it: only the rooms
+// and doors are built up front, room content is loaded on demand and kept
+// within aBudget bytes (see RoomPager); every room and entity record is checked
+// here, so paging a room in later cannot fail on a malformed file
+inline Dungeon loadPagedDungeon(const std::string& aPath, size_t aBudget) {
+    DungeonFile::Loader file(aPath);
+    const DungeonFile::Header& header = file.getHeader();
+    const DungeonFile::RoomRecord* rooms = file.getRoomRecords();
+    const DungeonFile::EdgeRecord* edges = file.getEdgeRecords();
+
+    Dungeon dungeon;
+    dungeon.adoptExternalText(file.getFile());
+    if (file.getColdText()) {
+        dungeon.adoptExternalText(file.getColdText());
+    }
+    auto pager = std::make_unique<RoomPager>(file, aBudget);
+    RoomPager& pagerRef = *pager;
+    dungeon.setLoader(std::move(pager));
+    dungeon.reserve(header.fRoomCount, 0);
+
+    // The lists are freed on eviction, so they cannot come from the arena
+    uint64_t nextEntity = 0;
+    for (uint64_t i = 0; i < header.fRoomCount; ++i) {
+        const DungeonFile::RoomRecord& record = rooms[i];
+        if (record.fFirstEntity != nextEntity || record.fEntityCount > header.fEntityCount - nextEntity) {
+            throw std::runtime_error("DungeonFile: entities out of room order");
+        }
+        nextEntity += record.fEntityCount;
+        file.storedText(record.fDescription);  // Rejects a corrupt description now rather than when paged in
+        pagerRef.addRoom(dungeon.createRoomView(file.text(record.fName), std::string_view(),
+                                                std::pmr::new_delete_resource()));
+    }
+    if (nextEntity != header.fEntityCount) {
+        throw std::runtime_error("DungeonFile: entities out of room order");
+    }
+
+    // Reject a bad entity record now rather than when its room is paged in
+    const DungeonFile::EntityRecord* entities = file.getEntityRecords();
+    for (uint64_t i = 0; i < header.fEntityCount; ++i) {
+        const DungeonFile::EntityRecord& entity = entities[i];
+        if (entity.fKind != DungeonFile::kMonster && entity.fKind != DungeonFile::kItem &&
+            entity.fKind != DungeonFile::kClue) {
+            throw std::runtime_error("DungeonFile: unknown entity kind");
+        }
+        file.text(entity.fName);
+        file.storedText(entity.fDescription);
+        if (entity.fKind == DungeonFile::kClue) {
+            file.storedText(entity.fHiddenInfo);
+        }
+    }
+
+    const std::vector<Room*>& created = dungeon.getRooms();
+    for (uint64_t i = 0; i < header.fRoomCount; ++i) {
+        const DungeonFile::RoomRecord& record = rooms[i];
+        if (record.fFirstEdge > header.fEdgeCount || record.fEdgeCount > header.fEdgeCount - record.fFirstEdge) {
+            throw std::runtime_error("DungeonFile: door range out of bounds");
+        }
+        for (uint32_t e = 0; e < record.fEdgeCount; ++e) {
+            const DungeonFile::EdgeRecord& edge = edges[record.fFirstEdge + e];
+            if (edge.fTarget >= created.size()) {
+                throw std::runtime_error("DungeonFile: door leads to unknown room");
+            }
+            dungeon.connectRooms(created[i], created[edge.fTarget], file.text(edge.fDoorName), file.text(edge.fKey));
+        }
+    }
+
+    if (header.fRoomCount > 0) {
+        if (header.fEntrance >= created.size()) {
+            throw std::runtime_error("DungeonFile: unknown entrance room");
+        }
+        dungeon.setEntrance(created[header.fEntrance]);
+    }
+    dungeon.buildIndex();
+    return dungeon;
+}
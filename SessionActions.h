@@ -0,0 +1,115 @@
+#pragma once
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "SessionState.h"
+#include "Instrumentation.h"
+
+/**
+ * Headless counterparts of the visitors in PlayerActions.h
+ * They apply exactly the same rules and scores, but read and write a
+ * SessionState overlay instead of the shared entities and print nothing.
+ * A monster or clue the world brought back (see SessionState::isSpent)
+ * scores only the first time, so a living world cannot be farmed for points.
+ */
+class SessionAttackAction : public EntityVisitor {
+private:
+    SessionState& fState;
+
+public:
+    SessionAttackAction(SessionState& aState) : fState(aState) {}
+
+    void visitMonster(Monster& aMonster) override {
+        if (!fState.isMonsterAlive(aMonster)) {
+            return;
+        }
+
+        Player& player = fState.getPlayer();
+        fState.damageMonster(aMonster, player.getAttackPower());
+
+        if (!fState.isMonsterAlive(aMonster)) {
+            if (!fState.isSpent(aMonster)) player.addScore(50);
+            if (fState.getListener()) fState.getListener()->onMonsterDefeated(aMonster);
+        } else {
+            if (fState.getListener()) fState.getListener()->onMonsterWounded(aMonster);
+            player.takeDamage(aMonster.getDamage());
+        }
+    }
+
+    void visitItem(Item&) override {}
+    void visitClue(Clue&) override {}
+};
+
+class SessionCollectAction : public EntityVisitor {
+private:
+    SessionState& fState;
+
+public:
+    SessionCollectAction(SessionState& aState) : fState(aState) {}
+
+    void visitMonster(Monster&) override {}
+
+    void visitItem(Item& aItem) override {
+        if (fState.isCollected(aItem)) {
+            return;
+        }
+
+        fState.collect(aItem);
+        fState.getPlayer().addToInventory(aItem.getNameSymbol(), aItem.getValue());
+        fState.getPlayer().addScore(aItem.getValue());
+        if (fState.getListener()) fState.getListener()->onItemCollected(aItem);
+    }
+
+    void visitClue(Clue&) override {}
+};
+
+class SessionExamineAction : public EntityVisitor {
+private:
+    SessionState& fState;
+
+public:
+    SessionExamineAction(SessionState& aState) : fState(aState) {}
+
+    void visitMonster(Monster&) override {}
+    void visitItem(Item&) override {}
+
+    void visitClue(Clue& aClue) override {
+        if (!fState.isExamined(aClue)) {
+            fState.examine(aClue);
+            if (!fState.isSpent(aClue)) fState.getPlayer().addScore(25);
+            if (fState.getListener()) fState.getListener()->onClueExamined(aClue);
+        }
+    }
+};
+
+// Apply an action to the entity with the given index in the session's current room
+// Returns false if the room has no such entity
+inline bool performAction(SessionState& aState, size_t aEntityIndex, ActionType aAction) {
+    auto entity = aState.getEntity(*aState.getCurrentRoom(), aEntityIndex);
+    if (!entity) {
+        return false;
+    }
+
+    switch (aAction) {
+        case ActionType::Attack: {
+            INSTRUMENT_SCOPE(Instrumentation::Metric::Attack);
+            SessionAttackAction attack(aState);
+            entity->accept(attack);
+            break;
+        }
+        case ActionType::Collect: {
+            INSTRUMENT_SCOPE(Instrumentation::Metric::Collect);
+            SessionCollectAction collect(aState);
+            entity->accept(collect);
+            break;
+        }
+        case ActionType::Examine: {
+            INSTRUMENT_SCOPE(Instrumentation::Metric::Examine);
+            SessionExamineAction examine(aState);
+            entity->accept(examine);
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <charconv>
+#include <string_view>
+#include "ActionListener.h"
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "OutputSink.h"
+#include "SessionState.h"
+#include "SessionActions.h"
+#include "Instrumentation.h"
+
+/**
+ * Text line protocol for playing a SessionState remotely
+ *
+ *   look                 describe the current room
+ *   status               show the player's status
+ *   attack|collect|examine <n>   act on entity n of the room (1-based)
+ *   move <n>             go through door n (1-based) and describe the new room;
+ *                        a locked door the player has no key for is refused
+ *   quit                 end the session
+ *
+ * Actions follow the same rules as the interactive game (performAction).
+ * What happened is reported as event lines (HIT, HURT, DEFEATED, COLLECTED,
+ * EXAMINED) and every reply ends with one line starting with OK, ERR, DEAD or
+ * BYE, so clients can read replies without knowing their length in advance.
+ * After DEAD or BYE the session is over.
+ */
+class SessionProtocol {
+private:
+    // Reports state changes of an action as event lines, and passes them on
+    // to the session's own listener
+    class EventWriter : public ActionListener {
+    private:
+        const SessionState& fState;
+        OutputSink& fOut;
+        ActionListener* fNext;
+
+    public:
+        EventWriter(const SessionState& aState, OutputSink& aOut, ActionListener* aNext)
+            : fState(aState), fOut(aOut), fNext(aNext) {}
+
+        void onMonsterDefeated(const Monster& aMonster) override {
+            fOut << "DEFEATED " << aMonster.getName() << " +" << (fState.isSpent(aMonster) ? 0 : 50) << "\n";
+            if (fNext) fNext->onMonsterDefeated(aMonster);
+        }
+
+        void onItemCollected(const Item& aItem) override {
+            fOut << "COLLECTED " << aItem.getName() << " +" << aItem.getValue() << "\n";
+            if (fNext) fNext->onItemCollected(aItem);
+        }
+
+        void onClueExamined(const Clue& aClue) override {
+            fOut << "EXAMINED " << aClue.getName() << " +" << (fState.isSpent(aClue) ? 0 : 25) << ": "
+                 << aClue.getHiddenInfo() << "\n";
+            if (fNext) fNext->onClueExamined(aClue);
+        }
+
+        void onMonsterWounded(const Monster& aMonster) override {
+            if (fNext) fNext->onMonsterWounded(aMonster);
+        }
+
+        void onRoomEntered(const Room& aRoom) override {
+            if (fNext) fNext->onRoomEntered(aRoom);
+        }
+
+        void onMonsterRespawned(const Monster& aMonster) override {
+            if (fNext) fNext->onMonsterRespawned(aMonster);
+        }
+
+        void onClueForgotten(const Clue& aClue) override {
+            if (fNext) fNext->onClueForgotten(aClue);
+        }
+
+        void onEntityMoved(const Entity& aEntity, const Room& aFrom, const Room& aTo) override {
+            if (fNext) fNext->onEntityMoved(aEntity, aFrom, aTo);
+        }
+    };
+
+    // Reports a monster that survived an attack
+    class HitWriter : public EntityVisitor {
+    private:
+        const SessionState& fState;
+        OutputSink& fOut;
+
+    public:
+        HitWriter(const SessionState& aState, OutputSink& aOut) : fState(aState), fOut(aOut) {}
+
+        void visitMonster(Monster& aMonster) override {
+            if (fState.isMonsterAlive(aMonster)) {
+                fOut << "HIT " << aMonster.getName() << " " << fState.getMonsterHealth(aMonster) << "\n";
+            }
+        }
+
+        void visitItem(Item&) override {}
+        void visitClue(Clue&) override {}
+    };
+
+    static bool parseIndex(std::string_view aText, size_t& aIndex) {
+        INSTRUMENT_SCOPE(Instrumentation::Metric::ParseInput);
+        while (!aText.empty() && aText.front() == ' ') aText.remove_prefix(1);
+        while (!aText.empty() && (aText.back() == ' ' || aText.back() == '\r')) aText.remove_suffix(1);
+        size_t value = 0;
+        auto [end, error] = std::from_chars(aText.data(), aText.data() + aText.size(), value);
+        if (error != std::errc() || end != aText.data() + aText.size() || value == 0) {
+            return false;
+        }
+        aIndex = value - 1;
+        return true;
+    }
+
+    static void writeStatusLine(const SessionState& aState, OutputSink& aOut) {
+        const Player& player = aState.getPlayer();
+        if (!player.isAlive()) {
+            aOut << "DEAD score " << player.getScore() << "\n";
+        } else {
+            aOut << "OK health " << player.getHealth() << "/" << player.getMaxHealth()
+                 << " score " << player.getScore() << "\n";
+        }
+    }
+
+    static bool act(SessionState& aState, size_t aIndex, ActionType aAction, OutputSink& aOut) {
+        Entity* entity = aState.getEntity(*aState.getCurrentRoom(), aIndex);
+        if (!entity) {
+            aOut << "ERR no such entity\n";
+            return true;
+        }
+
+        ActionListener* previous = aState.getListener();
+        EventWriter events(aState, aOut, previous);
+        aState.setListener(&events);
+        int health = aState.getPlayer().getHealth();
+        performAction(aState, aIndex, aAction);
+        aState.setListener(previous);
+
+        if (aAction == ActionType::Attack) {
+            HitWriter hits(aState, aOut);
+            entity->accept(hits);
+        }
+        if (aState.getPlayer().getHealth() < health) {
+            aOut << "HURT " << health - aState.getPlayer().getHealth() << "\n";
+        }
+        writeStatusLine(aState, aOut);
+        return aState.getPlayer().isAlive();
+    }
+
+public:
+    // Text sent when a session starts
+    static void greet(const SessionState& aState, OutputSink& aOut) {
+        aOut << "Welcome, " << aState.getPlayer().getName() << "!\n";
+        aState.describeRoom(*aState.getCurrentRoom(), aOut);
+        writeStatusLine(aState, aOut);
+    }
+
+    // Execute one command line and write the reply; returns false once the
+    // session is over
+    static bool execute(SessionState& aState, std::string_view aLine, OutputSink& aOut) {
+        while (!aLine.empty() && (aLine.back() == '\r' || aLine.back() == ' ')) aLine.remove_suffix(1);
+        size_t space = aLine.find(' ');
+        std::string_view command = aLine.substr(0, space);
+        std::string_view argument = space == std::string_view::npos ? std::string_view() : aLine.substr(space + 1);
+
+        if (command == "look") {
+            aState.describeRoom(*aState.getCurrentRoom(), aOut);
+            writeStatusLine(aState, aOut);
+            return true;
+        }
+        if (command == "status") {
+            aState.getPlayer().displayStatus(aOut);
+            writeStatusLine(aState, aOut);
+            return true;
+        }
+        if (command == "quit") {
+            aOut << "BYE score " << aState.getPlayer().getScore() << "\n";
+            return false;
+        }
+
+        size_t index;
+        if (command == "move") {
+            if (!parseIndex(argument, index) || index >= aState.getCurrentRoom()->getDoorCount()) {
+                aOut << "ERR no such door\n";
+                return true;
+            }
+            if (!aState.move(index)) {
+                aOut << "ERR door locked\n";
+                return true;
+            }
+            aState.describeRoom(*aState.getCurrentRoom(), aOut);
+            writeStatusLine(aState, aOut);
+            return true;
+        }
+
+        ActionType action;
+        if (command == "attack") {
+            action = ActionType::Attack;
+        } else if (command == "collect") {
+            action = ActionType::Collect;
+        } else if (command == "examine") {
+            action = ActionType::Examine;
+        } else {
+            aOut << "ERR unknown command\n";
+            return true;
+        }
+        if (!parseIndex(argument, index)) {
+            aOut << "ERR expected an entity number\n";
+            return true;
+        }
+        return act(aState, index, action, aOut);
+    }
+};
@@ -0,0 +1,323 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "ActionListener.h"
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Player.h"
+#include "Room.h"
+#include "Dungeon.h"
+#include "OutputSink.h"
+#include "Instrumentation.h"
+
+/**
+ * Actions a player can apply to an entity (same numbering as the game menu)
+ */
+enum class ActionType {
+    Attack = 1,
+    Collect = 2,
+    Examine = 3
+};
+
+/**
+ * Per-session state overlay on a shared Dungeon
+ * Holds everything a playthrough changes (monster health, collected and
+ * examined flags, the player and the current room) so the Dungeon itself is
+ * only ever read and can be shared by many sessions at once.
+ * The overlay is sparse: it keeps only the entities this session changed
+ * and reads every other one from the dungeon (or its loader), so a session
+ * costs O(1) to create and O(changed) memory, whatever the dungeon size.
+ * Changed entities are found through an open-addressing table of indices
+ * into the changed list (linear probing on the id, as in Inventory), sized
+ * for kReservedEntities when the session is created, so changing the first
+ * kReservedEntities entities does not allocate; beyond that the table
+ * doubles.
+ * Monsters can also be moved between rooms for one session (see moveEntity);
+ * the entities of a room are then read through the session, which keeps
+ * the changed lists of just the rooms concerned.
+ * The Dungeon must have been indexed with Dungeon::indexEntities().
+ */
+class SessionState {
+public:
+    // Raw overlay values of one entity (health is 0 for anything but a live monster)
+    struct EntityState {
+        int fHealth;
+        bool fIsCollected;
+        bool fIsExamined;
+        bool fIsSpent;  // Brought back by the world after it scored; it scores no more
+    };
+
+private:
+    static constexpr uint32_t kEmptySlot = 0;
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    const Dungeon& fDungeon;
+    Player fPlayer;
+    Room* fCurrentRoom;
+    std::vector<uint32_t> fChanged;        // Ids of the entities this session has changed
+    std::vector<EntityState> fStates;      // State of each changed entity, parallel to fChanged
+    std::vector<uint32_t> fSlots;          // Index in fChanged + 1, or kEmptySlot; power-of-two size
+    std::unordered_map<uint32_t, std::vector<uint32_t>> fRoomEntities;  // Ids now in rooms entities moved in or out of
+    ActionListener* fListener;        // Optional, notified of state changes
+
+    size_t slotOf(uint32_t aId) const {
+        // Fibonacci hashing; sequential ids land on distinct slots
+        return (aId * 0x9E3779B1u) & (fSlots.size() - 1);
+    }
+
+    void insertSlot(size_t aIndex) {
+        size_t slot = slotOf(fChanged[aIndex]);
+        while (fSlots[slot] != kEmptySlot) {
+            slot = (slot + 1) & (fSlots.size() - 1);
+        }
+        fSlots[slot] = static_cast<uint32_t>(aIndex + 1);
+    }
+
+    // Index of an entity in fChanged, or kNotFound
+    size_t find(uint32_t aId) const {
+        for (size_t slot = slotOf(aId);; slot = (slot + 1) & (fSlots.size() - 1)) {
+            uint32_t index = fSlots[slot];
+            if (index == kEmptySlot) return kNotFound;
+            if (fChanged[index - 1] == aId) return index - 1;
+        }
+    }
+
+    // The overlay entry of an entity about to change, copied from the
+    // dungeon the first time
+    EntityState& changeState(size_t aId) {
+        uint32_t id = static_cast<uint32_t>(aId);
+        size_t index = find(id);
+        if (index != kNotFound) {
+            return fStates[index];
+        }
+        fChanged.push_back(id);
+        fStates.push_back(getInitialState(aId));
+        // Keep the table at most half full
+        if (fChanged.size() * 2 > fSlots.size()) {
+            fSlots.assign(fSlots.size() * 2, kEmptySlot);
+            for (size_t i = 0; i < fChanged.size(); ++i) {
+                insertSlot(i);
+            }
+        } else {
+            insertSlot(fChanged.size() - 1);
+        }
+        return fStates.back();
+    }
+
+    class InitialStateReader : public EntityVisitor {
+    private:
+        EntityState& fState;
+
+    public:
+        InitialStateReader(EntityState& aState) : fState(aState) {}
+
+        void visitMonster(Monster& aMonster) override {
+            fState.fHealth = aMonster.isAlive() ? aMonster.getHealth() : 0;
+        }
+
+        void visitItem(Item& aItem) override {
+            fState.fIsCollected = aItem.isCollected();
+        }
+
+        void visitClue(Clue& aClue) override {
+            fState.fIsExamined = aClue.isExamined();
+        }
+    };
+
+    // The ids of a room's entities for this session, copied from the room
+    // the first time entities move in or out
+    std::vector<uint32_t>& roomEntities(const Room& aRoom) {
+        auto [entry, isNew] = fRoomEntities.try_emplace(static_cast<uint32_t>(aRoom.getId()));
+        if (isNew) {
+            for (const Entity* entity : aRoom.getEntities()) {
+                entry->second.push_back(static_cast<uint32_t>(entity->getId()));
+            }
+        }
+        return entry->second;
+    }
+
+public:
+    // Entities a session can change before its overlay table grows
+    static constexpr size_t kReservedEntities = 32;
+
+    SessionState(const Dungeon& aDungeon, const Player& aPlayer)
+        : fDungeon(aDungeon), fPlayer(aPlayer), fCurrentRoom(aDungeon.getEntrance()),
+          fSlots(2 * kReservedEntities, kEmptySlot), fListener(nullptr) {
+        fChanged.reserve(kReservedEntities);
+        fStates.reserve(kReservedEntities);
+    }
+
+    // Getter methods
+    const Dungeon& getDungeon() const { return fDungeon; }
+    Player& getPlayer() { return fPlayer; }
+    const Player& getPlayer() const { return fPlayer; }
+    Room* getCurrentRoom() const { return fCurrentRoom; }
+    void setCurrentRoom(Room* aRoom) { fCurrentRoom = aRoom; }
+    ActionListener* getListener() const { return fListener; }
+    void setListener(ActionListener* aListener) { fListener = aListener; }
+
+    // Overlay state for individual entities
+    int getMonsterHealth(const Monster& aMonster) const { return getEntityState(aMonster.getId()).fHealth; }
+    bool isMonsterAlive(const Monster& aMonster) const { return getMonsterHealth(aMonster) > 0; }
+    bool isCollected(const Item& aItem) const { return getEntityState(aItem.getId()).fIsCollected; }
+    bool isExamined(const Clue& aClue) const { return getEntityState(aClue.getId()).fIsExamined; }
+    bool isSpent(const Entity& aEntity) const { return getEntityState(aEntity.getId()).fIsSpent; }
+
+    // Same rules as Monster::takeDamage
+    void damageMonster(const Monster& aMonster, int aDamage) {
+        int& health = changeState(aMonster.getId()).fHealth;
+        health -= aDamage;
+        if (health < 0) health = 0;
+    }
+
+    void collect(const Item& aItem) {
+        changeState(aItem.getId()).fIsCollected = true;
+    }
+
+    void examine(const Clue& aClue) {
+        changeState(aClue.getId()).fIsExamined = true;
+    }
+
+    // Changes made by the world rather than the player (see WorldScheduler)
+    // Give a live monster up to aAmount health back, no more than it started with
+    void healMonster(const Monster& aMonster, int aAmount) {
+        int& health = changeState(aMonster.getId()).fHealth;
+        if (health > 0) {
+            health = std::max(health, std::min(health + aAmount, getInitialState(aMonster.getId()).fHealth));
+        }
+    }
+
+    // Bring a monster back with the health it started with; defeating it
+    // again scores nothing
+    void reviveMonster(const Monster& aMonster) {
+        EntityState& state = changeState(aMonster.getId());
+        state.fHealth = getInitialState(aMonster.getId()).fHealth;
+        state.fIsSpent = true;
+    }
+
+    // Examining the clue again reveals it again but scores nothing
+    void forgetClue(const Clue& aClue) {
+        EntityState& state = changeState(aClue.getId());
+        state.fIsExamined = false;
+        state.fIsSpent = true;
+    }
+
+    // Move an entity to another room for this session, where it is listed
+    // last, and tell the listener; returns false (and moves nothing) if it
+    // is not in aFrom
+    bool moveEntity(size_t aId, const Room& aFrom, const Room& aTo) {
+        std::vector<uint32_t>& from = roomEntities(aFrom);
+        auto found = std::find(from.begin(), from.end(), static_cast<uint32_t>(aId));
+        if (found == from.end()) {
+            return false;
+        }
+        from.erase(found);
+        roomEntities(aTo).push_back(static_cast<uint32_t>(aId));
+        if (fListener) fListener->onEntityMoved(*fDungeon.getEntity(aId), aFrom, aTo);
+        return true;
+    }
+
+    // The entities of a room as this session sees them
+    size_t getEntityCount(const Room& aRoom) const {
+        auto moved = fRoomEntities.find(static_cast<uint32_t>(aRoom.getId()));
+        return moved != fRoomEntities.end() ? moved->second.size() : aRoom.getEntities().size();
+    }
+
+    // nullptr if the room has no such entity
+    Entity* getEntity(const Room& aRoom, size_t aIndex) const {
+        if (fRoomEntities.empty()) {
+            return aRoom.getEntity(aIndex);
+        }
+        auto moved = fRoomEntities.find(static_cast<uint32_t>(aRoom.getId()));
+        if (moved == fRoomEntities.end()) {
+            return aRoom.getEntity(aIndex);
+        }
+        return aIndex < moved->second.size() ? fDungeon.getEntity(moved->second[aIndex]) : nullptr;
+    }
+
+    // Room::describe() with the entities this session sees in the room
+    void describeRoom(const Room& aRoom, OutputSink& aOut) const {
+        auto moved = fRoomEntities.find(static_cast<uint32_t>(aRoom.getId()));
+        if (moved == fRoomEntities.end()) {
+            aRoom.describe(aOut);
+            return;
+        }
+        const std::vector<uint32_t>& ids = moved->second;
+        aRoom.describe(aOut, ids.size(), [this, &ids](size_t aIndex) { return fDungeon.getEntity(ids[aIndex]); });
+    }
+
+    // Entity ids of every room entities moved in or out of, by room id; an
+    // entity that moved is listed in exactly one of them, its current room
+    const std::unordered_map<uint32_t, std::vector<uint32_t>>& getMovedRooms() const { return fRoomEntities; }
+
+    // Entities that may differ from the shared dungeon, in order of first change
+    const std::vector<uint32_t>& getChangedEntities() const { return fChanged; }
+
+    // An entity's state in the shared dungeon, before this session changed it
+    // (paged dungeons supply it without loading the entity)
+    EntityState getInitialState(size_t aId) const {
+        if (RoomLoader* loader = fDungeon.getLoader()) {
+            RoomLoader::EntityState state = loader->getEntityState(aId);
+            return EntityState{state.fHealth, state.fIsCollected, state.fIsExamined, false};
+        }
+        EntityState state{0, false, false, false};
+        InitialStateReader reader(state);
+        fDungeon.getEntity(aId)->accept(reader);
+        return state;
+    }
+
+    // An entity's state in this session
+    EntityState getEntityState(size_t aId) const {
+        size_t index = find(static_cast<uint32_t>(aId));
+        return index != kNotFound ? fStates[index] : getInitialState(aId);
+    }
+
+    // Overwrite one entity's overlay values (used when restoring snapshots)
+    void setEntityState(size_t aId, const EntityState& aState) {
+        EntityState& state = changeState(aId);
+        state.fHealth = aState.fHealth > 0 ? aState.fHealth : 0;
+        state.fIsCollected = aState.fIsCollected;
+        state.fIsExamined = aState.fIsExamined;
+        state.fIsSpent = aState.fIsSpent;
+    }
+
+    // Put every changed entity back to its state (and room) in the dungeon,
+    // in O(changed); the overlay table keeps its capacity
+    void resetEntities() {
+        fRoomEntities.clear();
+        for (uint32_t id : fChanged) {
+            size_t slot = slotOf(id);
+            while (fSlots[slot] == kEmptySlot || fChanged[fSlots[slot] - 1] != id) {
+                slot = (slot + 1) & (fSlots.size() - 1);
+            }
+            fSlots[slot] = kEmptySlot;
+        }
+        fChanged.clear();
+        fStates.clear();
+    }
+
+    // Whether a door of the current room is locked to the player: it has a
+    // key and the player holds no item of that name
+    bool isDoorLocked(size_t aDoorIndex) const {
+        Symbol key = fCurrentRoom->getDoorKey(aDoorIndex);
+        return key != 0 && !fPlayer.getInventory().has(key);
+    }
+
+    // Move through the door with the given index; returns false if there is
+    // no such door or it is locked
+    bool move(size_t aDoorIndex) {
+        INSTRUMENT_SCOPE(Instrumentation::Metric::Move);
+        Room* next = fCurrentRoom->getConnectedRoom(aDoorIndex);
+        if (!next || isDoorLocked(aDoorIndex)) {
+            return false;
+        }
+        fCurrentRoom = next;
+        if (fListener) fListener->onRoomEntered(*next);
+        return true;
+    }
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <variant>
+#include "EntityStore.h"
+#include "Player.h"
+
+/**
+ * Statically dispatched counterparts of the visitors in PlayerActions.h
+ * Each action is a function object with one overload per handle type, so
+ * std::visit resolves it with a jump table instead of two virtual calls.
+ * They follow the same rules and scores as the interactive actions but
+ * operate on an EntityStore and print nothing.
+ */
+class StaticAttackAction {
+private:
+    EntityStore& fStore;
+    Player& fPlayer;
+
+public:
+    StaticAttackAction(EntityStore& aStore, Player& aPlayer) : fStore(aStore), fPlayer(aPlayer) {}
+
+    void operator()(MonsterHandle aMonster) {
+        int& health = fStore.monsterHealth(aMonster);
+        if (health <= 0) {
+            return;
+        }
+
+        health -= fPlayer.getAttackPower();
+        if (health <= 0) {
+            health = 0;
+            fPlayer.addScore(50);
+        } else {
+            fPlayer.takeDamage(fStore.monsterDamage(aMonster));
+        }
+    }
+
+    void operator()(ItemHandle) {}
+    void operator()(ClueHandle) {}
+};
+
+class StaticCollectAction {
+private:
+    EntityStore& fStore;
+    Player& fPlayer;
+
+public:
+    StaticCollectAction(EntityStore& aStore, Player& aPlayer) : fStore(aStore), fPlayer(aPlayer) {}
+
+    void operator()(MonsterHandle) {}
+
+    void operator()(ItemHandle aItem) {
+        if (fStore.isCollected(aItem)) {
+            return;
+        }
+
+        fStore.collect(aItem);
+        if (Item* source = fStore.getSource(aItem)) {
+            fPlayer.addToInventory(source->getName(), fStore.itemValue(aItem));
+        }
+        fPlayer.addScore(fStore.itemValue(aItem));
+    }
+
+    void operator()(ClueHandle) {}
+};
+
+class StaticExamineAction {
+private:
+    EntityStore& fStore;
+    Player& fPlayer;
+
+public:
+    StaticExamineAction(EntityStore& aStore, Player& aPlayer) : fStore(aStore), fPlayer(aPlayer) {}
+
+    void operator()(MonsterHandle) {}
+    void operator()(ItemHandle) {}
+
+    void operator()(ClueHandle aClue) {
+        if (!fStore.isExamined(aClue)) {
+            fStore.examine(aClue);
+            fPlayer.addScore(25);
+        }
+    }
+};
+
+// Apply a static action to a stored entity
+template <typename Action>
+inline void dispatchAction(Action& aAction, EntityHandle aHandle) {
+    std::visit(aAction, aHandle);
+}
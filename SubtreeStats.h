@@ -0,0 +1,286 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ActionListener.h"
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Dungeon.h"
+#include "OutputSink.h"
+#include "SessionState.h"
+
+/**
+ * Per-subtree totals of what is left to do in a dungeon
+ * For every room it keeps the live monsters, uncollected items (count and
+ * value) and unexamined clues in that room and everything below it. Totals are
+ * computed once in O(n), from the entities themselves or from a session's
+ * overlay, and then kept up to date as an ActionListener: each
+ * event walks the parent links from the entity's room to the entrance, so
+ * both updates and queries cost O(depth).
+ * In a living world (WorldScheduler) respawned monsters and forgotten clues
+ * count again, but their points do not come back: like the session, the
+ * remaining score counts each monster and clue once. Entities are counted
+ * in the room they are in: a monster that roams takes its counts from the
+ * path of the room it left to the path of the room it entered.
+ * Counting a paged dungeon reads its entities through the RoomLoader, so no
+ * room is paged in.
+ * The dungeon must have been indexed with Dungeon::buildIndex().
+ */
+class SubtreeStats : public ActionListener {
+public:
+    // Points a player gets for defeating a monster and examining a clue
+    static constexpr int kMonsterScore = 50;
+    static constexpr int kClueScore = 25;
+
+private:
+    const Dungeon& fDungeon;
+    const SessionState* fState;  // Session whose view is counted, if any
+    std::vector<uint32_t> fEntityRoom;  // Room id by entity id
+    std::vector<uint32_t> fLiveMonsters;
+    std::vector<uint32_t> fUncollectedItems;
+    std::vector<int64_t> fUncollectedValue;
+    std::vector<uint32_t> fUnexaminedClues;
+    std::vector<int64_t> fRemainingScore;
+    std::vector<bool> fHasScored;  // By entity id: defeated or examined once already
+
+    // Whether an entity still counts (live monster, uncollected item,
+    // unexamined clue), as it is or as the session sees it
+    struct EntityReading {
+        RoomLoader::EntityInfo::Kind fKind;
+        bool fIsOpen;
+        bool fIsSpent;
+        int fValue;  // Items only
+    };
+
+    class EntityReader : public EntityVisitor {
+    private:
+        const SessionState* fState;
+
+    public:
+        EntityReading fReading{RoomLoader::EntityInfo::Kind::Monster, false, false, 0};
+
+        EntityReader(const SessionState* aState) : fState(aState) {}
+
+        void visitMonster(Monster& aMonster) override {
+            bool isAlive = fState ? fState->isMonsterAlive(aMonster) : aMonster.isAlive();
+            fReading = {RoomLoader::EntityInfo::Kind::Monster, isAlive, fState && fState->isSpent(aMonster), 0};
+        }
+
+        void visitItem(Item& aItem) override {
+            bool isCollected = fState ? fState->isCollected(aItem) : aItem.isCollected();
+            fReading = {RoomLoader::EntityInfo::Kind::Item, !isCollected, false, aItem.getValue()};
+        }
+
+        void visitClue(Clue& aClue) override {
+            bool isExamined = fState ? fState->isExamined(aClue) : aClue.isExamined();
+            fReading = {RoomLoader::EntityInfo::Kind::Clue, !isExamined, fState && fState->isSpent(aClue), 0};
+        }
+    };
+
+    // Entities of a paged dungeon are read from its loader (and the session's
+    // overlay), so no room is paged in
+    EntityReading read(size_t aId) const {
+        RoomLoader* loader = fDungeon.getLoader();
+        if (!loader) {
+            EntityReader reader(fState);
+            fDungeon.getEntity(aId)->accept(reader);
+            return reader.fReading;
+        }
+        RoomLoader::EntityInfo info = loader->getEntityInfo(aId);
+        SessionState::EntityState state{0, false, false, false};
+        if (fState) {
+            state = fState->getEntityState(aId);
+        } else {
+            RoomLoader::EntityState stored = loader->getEntityState(aId);
+            state = SessionState::EntityState{stored.fHealth, stored.fIsCollected, stored.fIsExamined, false};
+        }
+        switch (info.fKind) {
+            case RoomLoader::EntityInfo::Kind::Monster:
+                return EntityReading{info.fKind, state.fHealth > 0, state.fIsSpent, 0};
+            case RoomLoader::EntityInfo::Kind::Item:
+                return EntityReading{info.fKind, !state.fIsCollected, false, info.fValue};
+            case RoomLoader::EntityInfo::Kind::Clue:
+                break;
+        }
+        return EntityReading{info.fKind, !state.fIsExamined, state.fIsSpent, 0};
+    }
+
+    // Add (aSign 1) or remove (-1) an entity that still counts to a room's totals
+    void add(size_t aRoom, size_t aId, const EntityReading& aReading, int aSign) {
+        if (!aReading.fIsOpen) {
+            return;
+        }
+        switch (aReading.fKind) {
+            case RoomLoader::EntityInfo::Kind::Monster:
+                fLiveMonsters[aRoom] += aSign;
+                fRemainingScore[aRoom] += fHasScored[aId] ? 0 : aSign * kMonsterScore;
+                break;
+            case RoomLoader::EntityInfo::Kind::Item:
+                fUncollectedItems[aRoom] += aSign;
+                fUncollectedValue[aRoom] += aSign * aReading.fValue;
+                fRemainingScore[aRoom] += aSign * aReading.fValue;
+                break;
+            case RoomLoader::EntityInfo::Kind::Clue:
+                fUnexaminedClues[aRoom] += aSign;
+                fRemainingScore[aRoom] += fHasScored[aId] ? 0 : aSign * kClueScore;
+                break;
+        }
+    }
+
+    // Points an entity's first defeat or examination takes off the totals
+    int64_t scoreOnce(size_t aEntityId, int aPoints) {
+        if (fHasScored[aEntityId]) {
+            return 0;
+        }
+        fHasScored[aEntityId] = true;
+        return aPoints;
+    }
+
+    // Apply a change to an entity's room and all of its ancestors
+    template <typename Update>
+    void updatePath(size_t aEntityId, Update aUpdate) {
+        const RoomIndex& index = fDungeon.getIndex();
+        for (const Room* room = fDungeon.getRooms()[fEntityRoom[aEntityId]]; room; room = index.getParent(room)) {
+            aUpdate(room->getId());
+        }
+    }
+
+    // Count every room's own entities, then add up the subtrees
+    void count() {
+        if (RoomLoader* loader = fDungeon.getLoader()) {
+            for (size_t id = 0; id < fEntityRoom.size(); ++id) {
+                fEntityRoom[id] = loader->getEntityInfo(id).fRoom;
+            }
+        } else {
+            for (Room* room : fDungeon.getRooms()) {
+                for (Entity* entity : room->getEntities()) {
+                    fEntityRoom[entity->getId()] = static_cast<uint32_t>(room->getId());
+                }
+            }
+        }
+        if (fState) {
+            for (const auto& [room, entities] : fState->getMovedRooms()) {
+                for (uint32_t id : entities) {
+                    fEntityRoom[id] = room;
+                }
+            }
+        }
+
+        for (size_t id = 0; id < fEntityRoom.size(); ++id) {
+            EntityReading reading = read(id);
+            fHasScored[id] = reading.fKind != RoomLoader::EntityInfo::Kind::Item &&
+                             (!reading.fIsOpen || reading.fIsSpent);
+            add(fEntityRoom[id], id, reading, 1);
+        }
+
+        // Children come after their parents in pre-order, so a reverse sweep
+        // adds every finished subtree to its parent
+        const RoomIndex& index = fDungeon.getIndex();
+        const std::vector<uint32_t>& preorder = index.getPreorder();
+        for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+            const Room* parent = index.getParent(fDungeon.getRooms()[*it]);
+            if (parent) {
+                size_t p = parent->getId();
+                fLiveMonsters[p] += fLiveMonsters[*it];
+                fUncollectedItems[p] += fUncollectedItems[*it];
+                fUncollectedValue[p] += fUncollectedValue[*it];
+                fUnexaminedClues[p] += fUnexaminedClues[*it];
+                fRemainingScore[p] += fRemainingScore[*it];
+            }
+        }
+    }
+
+public:
+    // Totals of the dungeon's entities as they are
+    explicit SubtreeStats(const Dungeon& aDungeon) : SubtreeStats(aDungeon, nullptr) {}
+
+    // Totals as a session sees the dungeon, with its monsters in the rooms
+    // they roamed to; the stats keep reading entities through the session
+    SubtreeStats(const Dungeon& aDungeon, const SessionState* aState)
+        : fDungeon(aDungeon),
+          fState(aState),
+          fEntityRoom(aDungeon.getEntityCount(), 0),
+          fLiveMonsters(aDungeon.getRoomCount(), 0),
+          fUncollectedItems(aDungeon.getRoomCount(), 0),
+          fUncollectedValue(aDungeon.getRoomCount(), 0),
+          fUnexaminedClues(aDungeon.getRoomCount(), 0),
+          fRemainingScore(aDungeon.getRoomCount(), 0),
+          fHasScored(aDungeon.getEntityCount(), false) {
+        count();
+    }
+
+    // Whether every room's totals equal another's, such as a recount
+    bool operator==(const SubtreeStats& aOther) const {
+        return fLiveMonsters == aOther.fLiveMonsters && fUncollectedItems == aOther.fUncollectedItems &&
+               fUncollectedValue == aOther.fUncollectedValue && fUnexaminedClues == aOther.fUnexaminedClues &&
+               fRemainingScore == aOther.fRemainingScore;
+    }
+
+    bool operator!=(const SubtreeStats& aOther) const { return !(*this == aOther); }
+
+    // ActionListener
+    void onMonsterDefeated(const Monster& aMonster) override {
+        int64_t points = scoreOnce(aMonster.getId(), kMonsterScore);
+        updatePath(aMonster.getId(), [this, points](size_t aRoom) {
+            --fLiveMonsters[aRoom];
+            fRemainingScore[aRoom] -= points;
+        });
+    }
+
+    void onItemCollected(const Item& aItem) override {
+        int value = aItem.getValue();
+        updatePath(aItem.getId(), [this, value](size_t aRoom) {
+            --fUncollectedItems[aRoom];
+            fUncollectedValue[aRoom] -= value;
+            fRemainingScore[aRoom] -= value;
+        });
+    }
+
+    void onClueExamined(const Clue& aClue) override {
+        int64_t points = scoreOnce(aClue.getId(), kClueScore);
+        updatePath(aClue.getId(), [this, points](size_t aRoom) {
+            --fUnexaminedClues[aRoom];
+            fRemainingScore[aRoom] -= points;
+        });
+    }
+
+    void onMonsterRespawned(const Monster& aMonster) override {
+        updatePath(aMonster.getId(), [this](size_t aRoom) { ++fLiveMonsters[aRoom]; });
+    }
+
+    void onClueForgotten(const Clue& aClue) override {
+        updatePath(aClue.getId(), [this](size_t aRoom) { ++fUnexaminedClues[aRoom]; });
+    }
+
+    // The entity's counts leave the path of the room it left and join the
+    // path of the room it entered
+    void onEntityMoved(const Entity& aEntity, const Room&, const Room& aTo) override {
+        size_t id = aEntity.getId();
+        EntityReading reading = read(id);
+        updatePath(id, [this, id, &reading](size_t aRoom) { add(aRoom, id, reading, -1); });
+        fEntityRoom[id] = static_cast<uint32_t>(aTo.getId());
+        updatePath(id, [this, id, &reading](size_t aRoom) { add(aRoom, id, reading, 1); });
+    }
+
+    // Totals for a room and everything below it
+    uint32_t getLiveMonsters(const Room* aRoom) const { return fLiveMonsters[aRoom->getId()]; }
+    uint32_t getUncollectedItems(const Room* aRoom) const { return fUncollectedItems[aRoom->getId()]; }
+    int64_t getUncollectedValue(const Room* aRoom) const { return fUncollectedValue[aRoom->getId()]; }
+    uint32_t getUnexaminedClues(const Room* aRoom) const { return fUnexaminedClues[aRoom->getId()]; }
+
+    // Score still available in a subtree if every monster is defeated,
+    // every item collected and every clue examined
+    int64_t getRemainingScore(const Room* aRoom) const { return fRemainingScore[aRoom->getId()]; }
+
+    // Print the totals below a room
+    void display(OutputSink& aOut, const Room* aRoom) const {
+        aOut << "\n=== Remaining below " << aRoom->getName() << " ===\n";
+        aOut << "Live monsters: " << getLiveMonsters(aRoom) << "\n";
+        aOut << "Uncollected items: " << getUncollectedItems(aRoom)
+             << " (" << getUncollectedValue(aRoom) << " points)\n";
+        aOut << "Unexamined clues: " << getUnexaminedClues(aRoom) << "\n";
+        aOut << "Remaining score: " << getRemainingScore(aRoom) << "\n";
+        aOut << "==========================\n";
+    }
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Compact id of an interned string (0 is the empty string)
+using Symbol = uint32_t;
+
+/**
+ * Process-wide table of interned strings
+ *
+ * Names that repeat across rooms, dungeons and players (entity names, door
+ * labels, inventory entries) are stored once and passed around as 4-byte
+ * Symbols; the text is only looked up when it is printed or saved.
+ * Interning is thread-safe: the table is split into shards by hash, each
+ * with its own lock and text storage. Resolving a symbol takes no lock,
+ * as ids index fixed pages that never move once published. Interned text
+ * lives until the program ends.
+ */
+class SymbolTable {
+private:
+    static constexpr unsigned kPageBits = 12;
+    static constexpr size_t kPageSize = size_t(1) << kPageBits;
+    static constexpr size_t kMaxPages = size_t(1) << 16;
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kCacheSize = 256;
+
+    struct alignas(64) Shard {
+        std::mutex fMutex;
+        std::unordered_map<std::string_view, Symbol> fSymbols;
+        std::vector<std::unique_ptr<char[]>> fChunks;  // Text storage
+        char* fFree = nullptr;
+        size_t fFreeSize = 0;
+
+        // Copy text into storage that never moves; long text gets a block of its own
+        std::string_view store(std::string_view aText) {
+            char* target;
+            if (aText.size() > kChunkSize / 4) {
+                fChunks.push_back(std::make_unique<char[]>(aText.size()));
+                target = fChunks.back().get();
+            } else {
+                if (aText.size() > fFreeSize) {
+                    fChunks.push_back(std::make_unique<char[]>(kChunkSize));
+                    fFree = fChunks.back().get();
+                    fFreeSize = kChunkSize;
+                }
+                target = fFree;
+                fFree += aText.size();
+                fFreeSize -= aText.size();
+            }
+            std::memcpy(target, aText.data(), aText.size());
+            return std::string_view(target, aText.size());
+        }
+    };
+
+    // Symbol text, kPageSize per page; left to the zero initialisation of
+    // static storage (the only instance is global()) so untouched entries
+    // cost no memory
+    std::atomic<std::string_view*> fPages[kMaxPages];
+    std::mutex fPageMutex;
+    std::atomic<uint32_t> fNextSymbol;
+    Shard fShards[kShardCount];
+
+    std::string_view* page(size_t aIndex) {
+        std::string_view* existing = fPages[aIndex].load(std::memory_order_acquire);
+        if (existing) {
+            return existing;
+        }
+        std::lock_guard<std::mutex> lock(fPageMutex);
+        existing = fPages[aIndex].load(std::memory_order_relaxed);
+        if (!existing) {
+            existing = new std::string_view[kPageSize];
+            fPages[aIndex].store(existing, std::memory_order_release);
+        }
+        return existing;
+    }
+
+    // Find or add a string under its shard's lock
+    Symbol insert(std::string_view aText) {
+        size_t hash = std::hash<std::string_view>()(aText);
+        Shard& shard = fShards[(hash >> 7) % kShardCount];
+        std::lock_guard<std::mutex> lock(shard.fMutex);
+        auto found = shard.fSymbols.find(aText);
+        if (found != shard.fSymbols.end()) {
+            return found->second;
+        }
+
+        uint32_t symbol = fNextSymbol.fetch_add(1, std::memory_order_relaxed);
+        if (symbol >= kMaxPages * kPageSize) {
+            throw std::runtime_error("SymbolTable: out of symbols");
+        }
+        std::string_view text = shard.store(aText);
+        page(symbol >> kPageBits)[symbol & (kPageSize - 1)] = text;
+        shard.fSymbols.emplace(text, symbol);
+        return symbol;
+    }
+
+    SymbolTable() : fNextSymbol(1) {
+        page(0)[0] = std::string_view();
+    }
+
+public:
+    ~SymbolTable() {
+        for (auto& entry : fPages) {
+            delete[] entry.load(std::memory_order_relaxed);
+        }
+    }
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& global() {
+        static SymbolTable table;
+        return table;
+    }
+
+    // Symbol of a string, adding it on first use
+    Symbol intern(std::string_view aText) {
+        if (aText.empty()) {
+            return 0;
+        }
+
+        // Names are mostly interned again and again from the same static
+        // tables or file text, so each thread remembers recent (address,
+        // length) pairs; a hit is confirmed by comparing the text itself
+        struct CacheEntry {
+            const char* fData;
+            size_t fSize;
+            Symbol fSymbol;
+        };
+        static thread_local CacheEntry cache[kCacheSize];
+        CacheEntry& cached = cache[((reinterpret_cast<uintptr_t>(aText.data()) >> 3) ^ aText.size()) % kCacheSize];
+        if (cached.fData == aText.data() && cached.fSize == aText.size() && resolve(cached.fSymbol) == aText) {
+            return cached.fSymbol;
+        }
+        Symbol symbol = insert(aText);
+        cached = CacheEntry{aText.data(), aText.size(), symbol};
+        return symbol;
+    }
+
+    // Text of a symbol returned by intern(); the view stays valid
+    std::string_view resolve(Symbol aSymbol) const {
+        return fPages[aSymbol >> kPageBits].load(std::memory_order_acquire)[aSymbol & (kPageSize - 1)];
+    }
+
+    // Number of distinct strings interned so far (including the empty string)
+    size_t getSymbolCount() const {
+        return fNextSymbol.load(std::memory_order_relaxed);
+    }
+};
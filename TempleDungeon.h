@@ -0,0 +1,108 @@
+#pragma once
+#include "Dungeon.h"
+#include "FixedDungeon.h"
+
+/**
+ * The built-in "Temple of the Ancients" dungeon
+ * Shared by the interactive game, the batch simulator and other drivers.
+ * Its content is a constexpr table (see FixedDungeon), so the rooms and
+ * entities of every temple point at the same read-only text.
+ */
+
+// Rooms (nodes in the tree)
+enum TempleRoom : uint32_t {
+    kEntrance,
+    kMainHall,
+    kGuardChamber,
+    kTreasureVault,
+    kSecretPassage,
+    kInnerSanctum
+};
+
+constexpr FixedDungeon::Tables<6, 10, 5> kTemple = {
+    {
+        {"Temple Entrance",
+         "A grand stone archway marks the entrance to an ancient temple. "
+         "Torch light flickers on the walls."},
+        {"Main Hall",
+         "A vast hall with tall pillars reaching into darkness above. "
+         "Ancient murals depict forgotten rituals."},
+        {"Guard Chamber",
+         "A chamber that once housed temple guards. "
+         "Old weapons and armor lie scattered about."},
+        {"Treasure Vault",
+         "A small vault with ornate decorations and empty pedestals. "
+         "Something valuable might still remain here."},
+        {"Secret Passage",
+         "A narrow, dusty passage hidden behind a false wall. "
+         "Few have walked this path."},
+        {"Inner Sanctum",
+         "The heart of the temple. A pedestal in the center holds "
+         "the Crystal of Power, glowing with ancient magic!"},
+    },
+    {
+        // Entrance room entities
+        FixedDungeon::clue(kEntrance, "Stone Tablet",
+            "An ancient stone tablet with carved inscriptions.",
+            "The inscription reads: 'Only the brave shall claim the crystal. "
+            "Beware the guardian in the chamber of guards.'"),
+
+        // Main Hall entities
+        FixedDungeon::monster(kMainHall, "Giant Spider",
+            "A massive spider with gleaming red eyes.",
+            40, 15),
+        FixedDungeon::item(kMainHall, "Health Potion",
+            "A shimmering red potion that restores vitality.",
+            30),
+
+        // Guard Chamber entities
+        FixedDungeon::monster(kGuardChamber, "Skeleton Warrior",
+            "An undead warrior wielding a rusty sword.",
+            60, 20),
+        FixedDungeon::clue(kGuardChamber, "Ancient Shield",
+            "A shield bearing the temple's emblem.",
+            "The emblem hints at a secret passage behind the eastern wall of the main hall."),
+
+        // Treasure Vault entities
+        FixedDungeon::item(kTreasureVault, "Golden Amulet",
+            "A beautiful amulet encrusted with gems.",
+            100),
+        FixedDungeon::item(kTreasureVault, "Silver Coins",
+            "A pouch of ancient silver coins.",
+            50),
+
+        // Secret Passage entities
+        FixedDungeon::clue(kSecretPassage, "Dusty Journal",
+            "A journal left by a previous adventurer.",
+            "The final entry: 'I found the way to the sanctum, but I'm too weak to continue. "
+            "The crystal lies ahead...'"),
+        FixedDungeon::monster(kSecretPassage, "Shadow Beast",
+            "A creature made of living darkness.",
+            50, 18),
+
+        // Inner Sanctum entities
+        FixedDungeon::item(kInnerSanctum, "Crystal of Power",
+            "The legendary Crystal of Power, radiating mystical energy!",
+            500),
+    },
+    {
+        // Entrance connects to Main Hall
+        {kEntrance, kMainHall, "North Door - Main Hall", {}},
+
+        // Main Hall connects to three rooms
+        {kMainHall, kGuardChamber, "West Door - Guard Chamber", {}},
+        {kMainHall, kTreasureVault, "East Door - Treasure Vault", {}},
+        {kMainHall, kSecretPassage, "Hidden Door - Secret Passage (requires examination)", {}},
+
+        // Secret Passage connects to Inner Sanctum
+        {kSecretPassage, kInnerSanctum, "Ancient Door - Inner Sanctum", {}},
+    },
+    kEntrance  // Root of the tree
+};
+
+static_assert(FixedDungeon::isValid(kTemple), "temple tables are inconsistent");
+
+// Function to build the dungeon with all rooms and entities
+inline Dungeon buildDungeon() {
+    return FixedDungeon::build(kTemple);
+}
@@ -0,0 +1,231 @@
+#pragma once
+#include "Clue.h"
+#include "GameSession.h"
+#include "Item.h"
+#include "OutputSink.h"
+#include "Player.h"
+#include "Room.h"
+
+/**
+ * Text of the interactive game
+ * Turns the events of a GameSession step into the menus and messages the
+ * terminal game prints, so the terminal is just one client of GameSession.
+ */
+class TerminalView {
+private:
+    OutputSink& fOut;
+
+    static const char* actionVerb(int aAction) {
+        switch (static_cast<ActionType>(aAction)) {
+            case ActionType::Attack: return "attack";
+            case ActionType::Collect: return "collect";
+            case ActionType::Examine: return "examine";
+        }
+        return "";
+    }
+
+    static const char* actionSuggestion(int aAction) {
+        switch (static_cast<ActionType>(aAction)) {
+            case ActionType::Attack: return "attacking";
+            case ActionType::Collect: return "collecting";
+            case ActionType::Examine: return "examining";
+        }
+        return "";
+    }
+
+    void showMainMenu() {
+        fOut << "\n=== Actions ===\n";
+        fOut << "1. Interact with entities\n";
+        fOut << "2. Move to another room\n";
+        fOut << "3. View player status\n";
+        fOut << "4. Quit game\n";
+        fOut << "===============\n";
+        fOut << "Enter choice: ";
+    }
+
+    void showEntityMenu(const GameSession& aSession, const Room& aRoom) {
+        const SessionState& state = aSession.getState();
+        fOut << "\nWhat would you like to interact with?\n";
+        for (size_t i = 0; i < state.getEntityCount(aRoom); ++i) {
+            fOut << "  " << (i + 1) << ". " << state.getEntity(aRoom, i)->getName() << "\n";
+        }
+        fOut << "  0. Cancel\n";
+        fOut << "Enter choice: ";
+    }
+
+    void showActionMenu() {
+        fOut << "\nWhat action do you want to perform?\n";
+        fOut << "  1. Attack\n";
+        fOut << "  2. Collect\n";
+        fOut << "  3. Examine\n";
+        fOut << "  0. Cancel\n";
+        fOut << "Enter choice: ";
+    }
+
+    void showDoorMenu(const GameSession& aSession, const Room& aRoom) {
+        fOut << "\nWhere would you like to go?\n";
+        for (size_t i = 0; i < aRoom.getDoorCount(); ++i) {
+            fOut << "  " << (i + 1) << ". " << aRoom.getDoorName(i);
+            if (aSession.getState().isDoorLocked(i)) {
+                fOut << " (locked)";
+            }
+            fOut << "\n";
+        }
+        fOut << "  0. Stay here\n";
+        fOut << "Enter choice: ";
+    }
+
+    void show(const GameSession& aSession, const GameEvent& aEvent) {
+        const Player& player = aSession.getState().getPlayer();
+        const Entity* entity = aEvent.fEntity;
+        switch (aEvent.fType) {
+            case GameEventType::Welcome:
+                fOut << "\n╔════════════════════════════════════════════════════╗\n";
+                fOut << "║     WELCOME TO THE TEMPLE OF THE ANCIENTS!        ║\n";
+                fOut << "╚════════════════════════════════════════════════════╝\n";
+                fOut << "\nYour quest: Find the legendary Crystal of Power!\n";
+                fOut << "Navigate through rooms, defeat monsters, collect treasures,\n";
+                fOut << "and examine clues to guide your journey.\n";
+                break;
+            case GameEventType::RoomShown:
+                aSession.getState().describeRoom(*aEvent.fRoom, fOut);
+                break;
+            case GameEventType::MainMenu:
+                showMainMenu();
+                break;
+            case GameEventType::NothingToInteract:
+                fOut << "\nThere's nothing to interact with in this room.\n";
+                break;
+            case GameEventType::EntityMenu:
+                showEntityMenu(aSession, *aEvent.fRoom);
+                break;
+            case GameEventType::InvalidSelection:
+                fOut << "Invalid selection.\n";
+                break;
+            case GameEventType::ActionMenu:
+                showActionMenu();
+                break;
+            case GameEventType::NoAction:
+                fOut << "No action performed.\n";
+                break;
+            case GameEventType::NoExits:
+                fOut << "\nThere are no exits from this room!\n";
+                break;
+            case GameEventType::DoorMenu:
+                showDoorMenu(aSession, *aEvent.fRoom);
+                break;
+            case GameEventType::Moved:
+                fOut << "\nYou move through the door...\n";
+                break;
+            case GameEventType::DoorLocked:
+                fOut << "\nThe door is locked. You need the "
+                     << SymbolTable::global().resolve(aEvent.fRoom->getDoorKey(static_cast<size_t>(aEvent.fValue)))
+                     << " to open it.\n";
+                break;
+            case GameEventType::StatusShown:
+                player.displayStatus(fOut);
+                break;
+            case GameEventType::InvalidChoice:
+                fOut << "\nInvalid choice. Try again.\n";
+                break;
+            case GameEventType::WrongTarget:
+                fOut << "You can't " << actionVerb(aEvent.fValue) << " the " << entity->getName() << "! Try "
+                     << actionSuggestion(aEvent.fDetail) << " it instead.\n";
+                break;
+            case GameEventType::MonsterAlreadyDead:
+                fOut << "The " << entity->getName() << " is already dead.\n";
+                break;
+            case GameEventType::MonsterHit:
+                fOut << "\n" << player.getName() << " attacks the " << entity->getName() << "!\n";
+                fOut << "You deal " << aEvent.fValue << " damage!\n";
+                break;
+            case GameEventType::MonsterDefeated:
+                fOut << "The " << entity->getName() << " has been defeated!\n";
+                if (aEvent.fValue > 0) {
+                    fOut << "+" << aEvent.fValue << " points!\n";
+                }
+                break;
+            case GameEventType::MonsterWounded:
+                fOut << "The " << entity->getName() << " has " << aEvent.fValue << " health remaining.\n";
+                break;
+            case GameEventType::MonsterStrikesBack:
+                fOut << "\nThe " << entity->getName() << " strikes back!\n";
+                fOut << "You take " << aEvent.fValue << " damage! Health: " << aEvent.fDetail << "/"
+                     << player.getMaxHealth() << "\n";
+                break;
+            case GameEventType::AlreadyCollected:
+                fOut << "You have already collected the " << entity->getName() << ".\n";
+                break;
+            case GameEventType::ItemCollected:
+                fOut << "\nYou collect the " << entity->getName() << "!\n";
+                fOut << entity->getDescription() << "\n";
+                fOut << "+" << aEvent.fValue << " points!\n";
+                break;
+            case GameEventType::MonsterExamined:
+                fOut << "\nYou examine the " << entity->getName() << ":\n";
+                fOut << entity->getDescription() << "\n";
+                if (aEvent.fValue > 0) {
+                    fOut << "Health: " << aEvent.fValue << "\n";
+                    fOut << "Damage: " << aEvent.fDetail << "\n";
+                    fOut << "Status: Hostile and ready to attack!\n";
+                } else {
+                    fOut << "Status: Defeated\n";
+                }
+                break;
+            case GameEventType::ItemExamined:
+                fOut << "\nYou examine the " << entity->getName() << ":\n";
+                fOut << entity->getDescription() << "\n";
+                fOut << "Value: " << aEvent.fValue << " points\n";
+                fOut << (aEvent.fDetail ? "Status: Already collected\n" : "Status: Available to collect\n");
+                break;
+            case GameEventType::ClueRevealed:
+                fOut << "\nYou examine the " << entity->getName() << ":\n";
+                fOut << entity->getDescription() << "\n";
+                fOut << "\n*** Hidden Information Revealed: ***\n";
+                fOut << static_cast<const Clue*>(entity)->getHiddenInfo() << "\n";
+                if (aEvent.fValue > 0) {
+                    fOut << "+" << aEvent.fValue << " points for discovering a clue!\n";
+                }
+                break;
+            case GameEventType::ClueRecalled:
+                fOut << "\nYou examine the " << entity->getName() << ":\n";
+                fOut << entity->getDescription() << "\n";
+                fOut << "\nPreviously discovered: " << static_cast<const Clue*>(entity)->getHiddenInfo() << "\n";
+                break;
+            case GameEventType::MonsterArrived:
+                fOut << "\nA " << entity->getName() << " wanders in.\n";
+                break;
+            case GameEventType::MonsterLeft:
+                fOut << "\nThe " << entity->getName() << " wanders off.\n";
+                break;
+            case GameEventType::MonsterRespawned:
+                fOut << "\nThe " << entity->getName() << " rises again!\n";
+                break;
+            case GameEventType::ClueForgotten:
+                fOut << "\nYou can no longer recall what the " << entity->getName() << " revealed.\n";
+                break;
+            case GameEventType::Quit:
+                fOut << "\nThanks for playing!\n";
+                break;
+            case GameEventType::PlayerDefeated:
+                fOut << "\n╔════════════════════════════════════════╗\n";
+                fOut << "║          GAME OVER                     ║\n";
+                fOut << "║   You have been defeated...            ║\n";
+                fOut << "╚════════════════════════════════════════╝\n";
+                break;
+            case GameEventType::FinalScore:
+                fOut << "\nFinal Score: " << aEvent.fValue << "\n";
+                break;
+        }
+    }
+
+public:
+    explicit TerminalView(OutputSink& aOut) : fOut(aOut) {}
+
+    // Print the events of one step
+    void show(const GameSession& aSession, const GameSession::Events& aEvents) {
+        for (const GameEvent& event : aEvents) {
+            show(aSession, event);
+        }
+    }
+};
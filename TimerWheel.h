@@ -0,0 +1,186 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Hierarchical timing wheel: timers that fire a given number of ticks from
+ * now, in O(1) amortized time per timer
+ *
+ * Level L has 64 slots of 64^L ticks each. A timer goes to the lowest level
+ * at which its due tick and the current tick fall into the same 64^(L+1)
+ * window (the highest 6-bit group in which they differ), in the slot of its
+ * due tick there. Each time the clock enters a new 64^L window, the slot for
+ * that window on level L is emptied into the levels below, so a timer is
+ * moved at most once per level before it fires; timers further away than
+ * the top level wait in an overflow list that is re-sorted each time the
+ * top level wraps. While no timer is pending the clock jumps ahead at once.
+ * Timers due on the same tick fire in the order they were scheduled.
+ * Cancelling only marks a timer; it is dropped when its slot is next
+ * emptied. Handles carry a generation, so a stale handle cancels nothing.
+ * Not thread-safe: one wheel belongs to one simulation.
+ */
+template <typename Payload>
+class TimerWheel {
+public:
+    using Tick = uint64_t;
+    using Handle = uint64_t;  // Generation in the high half, timer index in the low half
+
+    static constexpr Handle kNoTimer = UINT64_MAX;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr unsigned kLevels = 4;  // 2^24 ticks before timers overflow
+
+private:
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;
+
+    struct Timer {
+        Tick fDue;
+        Payload fPayload;
+        uint32_t fGeneration;
+        bool fIsPending;
+    };
+
+    std::vector<Timer> fTimers;
+    std::vector<uint32_t> fFree;  // Indices of unused timers
+    std::array<std::vector<uint32_t>, kSlots * kLevels> fSlots;  // Timer indices, by level then slot
+    std::vector<uint32_t> fOverflow;  // Timers beyond the top level
+    Tick fNow;
+    size_t fPendingCount;
+
+    static unsigned levelOf(Tick aDue, Tick aNow) {
+        Tick differ = aDue ^ aNow;
+        unsigned level = 0;
+        while (level < kLevels && (differ >> (kSlotBits * (level + 1))) != 0) {
+            ++level;
+        }
+        return level;
+    }
+
+    void place(uint32_t aIndex) {
+        Tick due = fTimers[aIndex].fDue;
+        unsigned level = levelOf(due, fNow);
+        if (level == kLevels) {
+            fOverflow.push_back(aIndex);
+            return;
+        }
+        size_t slot = (due >> (kSlotBits * level)) & (kSlots - 1);
+        fSlots[level * kSlots + slot].push_back(aIndex);
+    }
+
+    void release(uint32_t aIndex) {
+        ++fTimers[aIndex].fGeneration;
+        fFree.push_back(aIndex);
+    }
+
+    // Move the timers of one slot (or the overflow list) down to where they
+    // belong now
+    void cascade(std::vector<uint32_t>& aTimers) {
+        std::vector<uint32_t> timers;
+        timers.swap(aTimers);
+        for (uint32_t index : timers) {
+            if (fTimers[index].fIsPending) {
+                place(index);
+            } else {
+                release(index);
+            }
+        }
+    }
+
+    // Enter tick fNow: bring down the slots whose window starts here, then
+    // fire the timers due now
+    template <typename Fire>
+    void runTick(Fire& aFire) {
+        for (unsigned level = kLevels; level >= 1; --level) {
+            Tick window = Tick(1) << (kSlotBits * level);
+            if ((fNow & (window - 1)) != 0) {
+                continue;
+            }
+            if (level == kLevels) {
+                cascade(fOverflow);
+            } else {
+                cascade(fSlots[level * kSlots + ((fNow >> (kSlotBits * level)) & (kSlots - 1))]);
+            }
+        }
+
+        std::vector<uint32_t> due;
+        due.swap(fSlots[fNow & (kSlots - 1)]);
+        for (uint32_t index : due) {
+            Timer& timer = fTimers[index];
+            if (!timer.fIsPending) {
+                release(index);
+                continue;
+            }
+            timer.fIsPending = false;
+            --fPendingCount;
+            Payload payload = std::move(timer.fPayload);
+            release(index);
+            aFire(payload);  // May schedule more timers, which can move fTimers
+        }
+    }
+
+public:
+    TimerWheel() : fNow(0), fPendingCount(0) {}
+
+    Tick getNow() const { return fNow; }
+    size_t getPendingCount() const { return fPendingCount; }
+    bool empty() const { return fPendingCount == 0; }
+
+    // Fire aPayload aDelay ticks from now (at least one)
+    Handle schedule(Tick aDelay, Payload aPayload) {
+        uint32_t index;
+        if (!fFree.empty()) {
+            index = fFree.back();
+            fFree.pop_back();
+        } else {
+            index = static_cast<uint32_t>(fTimers.size());
+            fTimers.push_back(Timer{0, Payload(), 0, false});
+        }
+        Timer& timer = fTimers[index];
+        timer.fDue = fNow + (aDelay > 0 ? aDelay : 1);
+        timer.fPayload = std::move(aPayload);
+        timer.fIsPending = true;
+        ++fPendingCount;
+        place(index);
+        return (Handle(timer.fGeneration) << 32) | index;
+    }
+
+    // Returns false if the timer already fired or was cancelled
+    bool cancel(Handle aHandle) {
+        uint32_t index = static_cast<uint32_t>(aHandle);
+        if (aHandle == kNoTimer || index >= fTimers.size()) {
+            return false;
+        }
+        Timer& timer = fTimers[index];
+        if (timer.fGeneration != static_cast<uint32_t>(aHandle >> 32) || !timer.fIsPending) {
+            return false;
+        }
+        timer.fIsPending = false;
+        --fPendingCount;
+        return true;
+    }
+
+    // Move the clock aTicks forward, calling aFire(payload) for every timer
+    // that comes due, in due order
+    template <typename Fire>
+    void advance(Tick aTicks, Fire aFire) {
+        Tick end = fNow + aTicks;
+        while (fNow < end) {
+            if (fPendingCount == 0) {
+                // Nothing can fire; drop the cancelled timers still waiting,
+                // as their slots are not visited
+                fNow = end;
+                if (fFree.size() != fTimers.size()) {
+                    for (std::vector<uint32_t>& slot : fSlots) {
+                        cascade(slot);
+                    }
+                    cascade(fOverflow);
+                }
+                return;
+            }
+            ++fNow;
+            runTick(aFire);
+        }
+    }
+};
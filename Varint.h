@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+/**
+ * LEB128 variable-length integers for compact binary blobs
+ * Seven bits per byte, low bits first, with the high bit set on every byte
+ * except the last. Signed values are zig-zag mapped first so small negative
+ * numbers stay short. Readers throw std::runtime_error on truncated input.
+ */
+namespace Varint {
+
+inline void append(std::vector<uint8_t>& aOut, uint64_t aValue) {
+    while (aValue >= 0x80) {
+        aOut.push_back(static_cast<uint8_t>(aValue | 0x80));
+        aValue >>= 7;
+    }
+    aOut.push_back(static_cast<uint8_t>(aValue));
+}
+
+inline void appendSigned(std::vector<uint8_t>& aOut, int64_t aValue) {
+    append(aOut, (static_cast<uint64_t>(aValue) << 1) ^ static_cast<uint64_t>(aValue >> 63));
+}
+
+// Length followed by the raw bytes
+inline void appendText(std::vector<uint8_t>& aOut, std::string_view aText) {
+    append(aOut, aText.size());
+    aOut.insert(aOut.end(), aText.begin(), aText.end());
+}
+
+class Reader {
+private:
+    const uint8_t* fNext;
+    const uint8_t* fEnd;
+
+public:
+    Reader(const uint8_t* aData, size_t aSize) : fNext(aData), fEnd(aData + aSize) {}
+
+    bool atEnd() const { return fNext == fEnd; }
+
+    uint64_t read() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (fNext == fEnd) {
+                throw std::runtime_error("Truncated varint");
+            }
+            uint8_t byte = *fNext++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Varint too long");
+    }
+
+    int64_t readSigned() {
+        uint64_t value = read();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    // Text written by appendText; the view points into the input
+    std::string_view readText() {
+        uint64_t length = read();
+        if (length > static_cast<uint64_t>(fEnd - fNext)) {
+            throw std::runtime_error("Truncated text");
+        }
+        std::string_view text(reinterpret_cast<const char*>(fNext), static_cast<size_t>(length));
+        fNext += length;
+        return text;
+    }
+};
+
+} // namespace Varint
@@ -0,0 +1,158 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size thread pool with one task deque per worker
+ * A worker takes new tasks from the back of its own deque and, when that is
+ * empty, steals from the front of the other workers' deques, so uneven task
+ * lengths still keep every core busy.
+ */
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        std::mutex fMutex;
+        std::deque<std::function<void()>> fTasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> fQueues;
+    std::vector<std::thread> fThreads;
+    std::atomic<size_t> fNextQueue;
+    std::atomic<size_t> fPending;  // Submitted but not yet finished
+    std::mutex fWaitMutex;
+    std::condition_variable fWorkAvailable;
+    std::condition_variable fAllDone;
+    bool fStopping;
+
+    // Identifies the pool and deque owned by the calling thread, if it is a worker
+    struct WorkerIdentity {
+        const WorkStealingPool* fPool;
+        size_t fIndex;
+    };
+
+    static WorkerIdentity& currentWorker() {
+        static thread_local WorkerIdentity identity{nullptr, 0};
+        return identity;
+    }
+
+    bool popLocal(size_t aWorker, std::function<void()>& aTask) {
+        WorkerQueue& queue = *fQueues[aWorker];
+        std::lock_guard<std::mutex> lock(queue.fMutex);
+        if (queue.fTasks.empty()) {
+            return false;
+        }
+        aTask = std::move(queue.fTasks.back());
+        queue.fTasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t aWorker, std::function<void()>& aTask) {
+        for (size_t i = 1; i < fQueues.size(); ++i) {
+            WorkerQueue& victim = *fQueues[(aWorker + i) % fQueues.size()];
+            std::lock_guard<std::mutex> lock(victim.fMutex);
+            if (!victim.fTasks.empty()) {
+                aTask = std::move(victim.fTasks.front());
+                victim.fTasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t aWorker) {
+        currentWorker() = WorkerIdentity{this, aWorker};
+        std::function<void()> task;
+        for (;;) {
+            if (popLocal(aWorker, task) || steal(aWorker, task)) {
+                task();
+                task = nullptr;
+                if (fPending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(fWaitMutex);
+                    fAllDone.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(fWaitMutex);
+            if (fStopping) {
+                return;
+            }
+            // Sleep until something is queued anywhere or the pool shuts down
+            fWorkAvailable.wait(lock, [this] { return fStopping || hasQueuedTasks(); });
+        }
+    }
+
+    bool hasQueuedTasks() {
+        for (auto& queue : fQueues) {
+            std::lock_guard<std::mutex> lock(queue->fMutex);
+            if (!queue->fTasks.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(size_t aThreadCount = std::thread::hardware_concurrency())
+        : fNextQueue(0), fPending(0), fStopping(false) {
+        if (aThreadCount == 0) aThreadCount = 1;
+        for (size_t i = 0; i < aThreadCount; ++i) {
+            fQueues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < aThreadCount; ++i) {
+            fThreads.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(fWaitMutex);
+            fStopping = true;
+        }
+        fWorkAvailable.notify_all();
+        for (auto& thread : fThreads) {
+            thread.join();
+        }
+    }
+
+    size_t getThreadCount() const {
+        return fThreads.size();
+    }
+
+    // Index of the calling worker, or getThreadCount() if the caller is not
+    // one of this pool's workers
+    size_t getWorkerIndex() const {
+        const WorkerIdentity& self = currentWorker();
+        return self.fPool == this ? self.fIndex : fThreads.size();
+    }
+
+    // Queue a task; tasks submitted by a worker go to its own deque, all
+    // others are spread round-robin over the worker deques
+    void submit(std::function<void()> aTask) {
+        fPending.fetch_add(1);
+        const WorkerIdentity& self = currentWorker();
+        size_t target = self.fPool == this ? self.fIndex : fNextQueue.fetch_add(1) % fQueues.size();
+        WorkerQueue& queue = *fQueues[target];
+        {
+            std::lock_guard<std::mutex> lock(queue.fMutex);
+            queue.fTasks.push_back(std::move(aTask));
+        }
+        std::lock_guard<std::mutex> lock(fWaitMutex);
+        fWorkAvailable.notify_one();
+    }
+
+    // Block until every submitted task has finished (not to be called from a task)
+    void wait() {
+        std::unique_lock<std::mutex> lock(fWaitMutex);
+        fAllDone.wait(lock, [this] { return fPending.load() == 0; });
+    }
+};
@@ -0,0 +1,302 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "ActionListener.h"
+#include "EntityVisitor.h"
+#include "Monster.h"
+#include "Item.h"
+#include "Clue.h"
+#include "Room.h"
+#include "SessionState.h"
+#include "TimerWheel.h"
+
+/**
+ * Rules of a living world, in turns; a period or delay of 0 turns a rule off
+ */
+struct WorldRules {
+    uint32_t fRegenPeriod = 0;   // Turns between health regained by a wounded monster
+    int fRegenAmount = 5;
+    uint32_t fRespawnDelay = 0;  // Turns until a defeated monster is back at full health
+    uint32_t fRoamPeriod = 0;    // Turns between the moves of a roaming monster
+    uint32_t fClueMemory = 0;    // Turns until an examined clue is forgotten (and can be examined again)
+    uint64_t fSeed = 1;          // Chooses the doors roaming monsters take
+
+    // The rules of `dungeon_crawler --world`
+    static WorldRules living(uint64_t aSeed = 1) {
+        WorldRules rules;
+        rules.fRegenPeriod = 2;
+        rules.fRespawnDelay = 25;
+        rules.fRoamPeriod = 4;
+        rules.fClueMemory = 40;
+        rules.fSeed = aSeed;
+        return rules;
+    }
+};
+
+/**
+ * Something the world changed by itself
+ */
+struct WorldEvent {
+    enum class Type : uint8_t {
+        MonsterRegenerated,
+        MonsterRespawned,
+        MonsterMoved,
+        ClueForgotten
+    };
+
+    Type fType;
+    uint32_t fEntity;    // Entity id
+    uint32_t fRoom;      // Room the entity is in afterwards
+    uint32_t fFromRoom;  // Moves only: the room it left
+};
+
+/**
+ * Runs a session's world between player actions: monsters regenerate,
+ * respawn and roam, and clues are forgotten again
+ *
+ * The world moves on one turn at a time with advance(). Only entities with
+ * something due are on its TimerWheel: a wounded monster until it is whole
+ * again, a defeated one until it respawns, an examined clue until it is
+ * forgotten, and the monsters of every room the player has entered, which
+ * wake up and from then on wander through unlocked doors to a random
+ * neighbouring room. A turn therefore costs O(1) amortized per event due,
+ * however large the dungeon is.
+ * The scheduler hears what the player does as the session's ActionListener.
+ * It passes every notification on to the listener it replaced and puts that
+ * listener back when destroyed; respawns and forgotten clues are reported
+ * to the session's listener as they happen. A monster or clue brought back
+ * scores only once (see SessionState::isSpent), so the best score of a
+ * living world is still bounded. Its changes go to the SessionState, so the
+ * Dungeon stays shared and read-only and any driver of a session
+ * (GameSession, MenuScript, ...) can give it a world of its own. World
+ * timers are not part of snapshots or journals.
+ */
+class WorldScheduler : public ActionListener {
+private:
+    enum Job : uint8_t {
+        kRegenerate = 1,
+        kRespawn = 2,
+        kRoam = 4,
+        kForget = 8
+    };
+
+    struct Timer {
+        Job fJob;
+        uint32_t fEntity;
+        uint32_t fRoom;  // Room the entity is in (where it was wounded, for regeneration)
+    };
+
+    SessionState& fState;
+    WorldRules fRules;
+    ActionListener* fNext;  // The session's listener before this one
+    TimerWheel<Timer> fWheel;
+    std::unordered_map<uint32_t, uint8_t> fScheduled;  // Jobs pending, by entity id
+    std::unordered_map<uint32_t, uint32_t> fMovedTo;  // Room of each monster that roamed, by entity id
+    uint64_t fRandom;
+    std::vector<WorldEvent> fEvents;  // Of the last advance()
+
+    // Wakes the live monsters of a room
+    class Waker : public EntityVisitor {
+    private:
+        WorldScheduler& fWorld;
+        uint32_t fRoom;
+
+    public:
+        Waker(WorldScheduler& aWorld, uint32_t aRoom) : fWorld(aWorld), fRoom(aRoom) {}
+
+        void visitMonster(Monster& aMonster) override {
+            if (fWorld.fState.isMonsterAlive(aMonster)) {
+                fWorld.schedule(kRoam, aMonster, fRoom, fWorld.fRules.fRoamPeriod);
+            }
+        }
+
+        void visitItem(Item&) override {}
+        void visitClue(Clue&) override {}
+    };
+
+    uint32_t currentRoom() const {
+        return static_cast<uint32_t>(fState.getCurrentRoom()->getId());
+    }
+
+    // Uniform in [0, aCount)
+    size_t random(size_t aCount) {
+        uint64_t value = fRandom += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<size_t>((value ^ (value >> 31)) % aCount);
+    }
+
+    // An entity has each job at most once on the wheel
+    void schedule(Job aJob, const Entity& aEntity, uint32_t aRoom, uint32_t aDelay) {
+        if (aDelay == 0) {
+            return;
+        }
+        uint32_t id = static_cast<uint32_t>(aEntity.getId());
+        uint8_t& jobs = fScheduled[id];
+        if (jobs & aJob) {
+            return;
+        }
+        jobs |= aJob;
+        fWheel.schedule(aDelay, Timer{aJob, id, aRoom});
+    }
+
+    void finish(const Timer& aTimer) {
+        auto found = fScheduled.find(aTimer.fEntity);
+        found->second &= static_cast<uint8_t>(~aTimer.fJob);
+        if (found->second == 0) {
+            fScheduled.erase(found);
+        }
+    }
+
+    void wakeRoom(const Room& aRoom) {
+        Waker waker(*this, static_cast<uint32_t>(aRoom.getId()));
+        for (size_t i = 0; i < fState.getEntityCount(aRoom); ++i) {
+            fState.getEntity(aRoom, i)->accept(waker);
+        }
+    }
+
+    // A roaming monster takes a random unlocked door, if there is one
+    void roam(Monster& aMonster, uint32_t aRoom) {
+        const Room& room = *fState.getDungeon().getRooms()[aRoom];
+        RoomView doors = room.getConnectedRooms();
+        size_t open = 0;
+        for (size_t i = 0; i < doors.size(); ++i) {
+            if (doors.getKey(i) == 0) ++open;
+        }
+        uint32_t next = aRoom;
+        if (open > 0) {
+            size_t choice = random(open);
+            for (size_t i = 0; i < doors.size(); ++i) {
+                if (doors.getKey(i) == 0 && choice-- == 0) {
+                    next = doors.getRoomId(i);
+                    break;
+                }
+            }
+        }
+        if (next != aRoom) {
+            // A monster that is no longer where it was seen (the session was
+            // reset) stops, until the player enters its room again
+            if (!fState.moveEntity(aMonster.getId(), room, *fState.getDungeon().getRooms()[next])) {
+                return;
+            }
+            fMovedTo[static_cast<uint32_t>(aMonster.getId())] = next;
+            fEvents.push_back(WorldEvent{WorldEvent::Type::MonsterMoved, static_cast<uint32_t>(aMonster.getId()),
+                                         next, aRoom});
+        }
+        schedule(kRoam, aMonster, next, fRules.fRoamPeriod);
+    }
+
+    void fire(const Timer& aTimer) {
+        finish(aTimer);
+        Entity* entity = fState.getDungeon().getEntity(aTimer.fEntity);
+        switch (aTimer.fJob) {
+            case kRegenerate: {
+                Monster& monster = *static_cast<Monster*>(entity);
+                int health = fState.getMonsterHealth(monster);
+                fState.healMonster(monster, fRules.fRegenAmount);
+                if (fState.getMonsterHealth(monster) > health) {
+                    auto moved = fMovedTo.find(aTimer.fEntity);
+                    uint32_t room = moved != fMovedTo.end() ? moved->second : aTimer.fRoom;
+                    fEvents.push_back(WorldEvent{WorldEvent::Type::MonsterRegenerated, aTimer.fEntity, room, room});
+                    if (fState.getMonsterHealth(monster) < fState.getInitialState(aTimer.fEntity).fHealth) {
+                        schedule(kRegenerate, monster, aTimer.fRoom, fRules.fRegenPeriod);
+                    }
+                }
+                break;
+            }
+            case kRespawn:
+                fState.reviveMonster(*static_cast<Monster*>(entity));
+                fEvents.push_back(WorldEvent{WorldEvent::Type::MonsterRespawned, aTimer.fEntity, aTimer.fRoom,
+                                             aTimer.fRoom});
+                if (ActionListener* listener = fState.getListener()) {
+                    listener->onMonsterRespawned(*static_cast<Monster*>(entity));
+                }
+                break;
+            case kRoam:
+                // Dead monsters stop; they wake again when the player next enters their room
+                if (fState.isMonsterAlive(*static_cast<Monster*>(entity))) {
+                    roam(*static_cast<Monster*>(entity), aTimer.fRoom);
+                }
+                break;
+            case kForget:
+                fState.forgetClue(*static_cast<Clue*>(entity));
+                fEvents.push_back(WorldEvent{WorldEvent::Type::ClueForgotten, aTimer.fEntity, aTimer.fRoom,
+                                             aTimer.fRoom});
+                if (ActionListener* listener = fState.getListener()) {
+                    listener->onClueForgotten(*static_cast<Clue*>(entity));
+                }
+                break;
+        }
+    }
+
+public:
+    WorldScheduler(SessionState& aState, const WorldRules& aRules)
+        : fState(aState), fRules(aRules), fNext(aState.getListener()), fRandom(aRules.fSeed) {
+        fState.setListener(this);
+        if (fRules.fRoamPeriod > 0 && fState.getCurrentRoom()) {
+            wakeRoom(*fState.getCurrentRoom());
+        }
+    }
+
+    WorldScheduler(const WorldScheduler&) = delete;
+    WorldScheduler& operator=(const WorldScheduler&) = delete;
+
+    ~WorldScheduler() override {
+        if (fState.getListener() == this) {
+            fState.setListener(fNext);
+        }
+    }
+
+    // Let aTurns turns pass
+    void advance(uint64_t aTurns = 1) {
+        fEvents.clear();
+        fWheel.advance(aTurns, [this](const Timer& aTimer) { fire(aTimer); });
+    }
+
+    // What the last advance() changed, in order
+    const std::vector<WorldEvent>& getEvents() const { return fEvents; }
+    uint64_t getTurn() const { return fWheel.getNow(); }
+    size_t getPendingCount() const { return fWheel.getPendingCount(); }
+    const WorldRules& getRules() const { return fRules; }
+
+    // ActionListener
+    void onMonsterDefeated(const Monster& aMonster) override {
+        schedule(kRespawn, aMonster, currentRoom(), fRules.fRespawnDelay);
+        if (fNext) fNext->onMonsterDefeated(aMonster);
+    }
+
+    void onItemCollected(const Item& aItem) override {
+        if (fNext) fNext->onItemCollected(aItem);
+    }
+
+    void onClueExamined(const Clue& aClue) override {
+        schedule(kForget, aClue, currentRoom(), fRules.fClueMemory);
+        if (fNext) fNext->onClueExamined(aClue);
+    }
+
+    void onMonsterWounded(const Monster& aMonster) override {
+        schedule(kRegenerate, aMonster, currentRoom(), fRules.fRegenPeriod);
+        if (fNext) fNext->onMonsterWounded(aMonster);
+    }
+
+    void onRoomEntered(const Room& aRoom) override {
+        if (fRules.fRoamPeriod > 0) {
+            wakeRoom(aRoom);
+        }
+        if (fNext) fNext->onRoomEntered(aRoom);
+    }
+
+    void onMonsterRespawned(const Monster& aMonster) override {
+        if (fNext) fNext->onMonsterRespawned(aMonster);
+    }
+
+    void onClueForgotten(const Clue& aClue) override {
+        if (fNext) fNext->onClueForgotten(aClue);
+    }
+
+    void onEntityMoved(const Entity& aEntity, const Room& aFrom, const Room& aTo) override {
+        if (fNext) fNext->onEntityMoved(aEntity, aFrom, aTo);
+    }
+};
@@ -0,0 +1,99 @@
+/**
+ * Combat benchmark: whole fights resolved by repeated AttackAction calls, by
+ * the exchange-by-exchange reference and by the closed-form batch kernel,
+ * over a random grid of player and monster parameters. Every kernel result
+ * is checked against the reference and the first fights also against
+ * AttackAction itself. Usage: bench_combat [fight count] [AttackAction fights]
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "CombatKernel.h"
+#include "Monster.h"
+#include "OutputSink.h"
+#include "Player.h"
+#include "PlayerActions.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPerFight(Clock::time_point aStart, size_t aCount) {
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - aStart;
+    return elapsed.count() / static_cast<double>(aCount);
+}
+
+static bool sameOutcome(const CombatKernel::FightOutcome& aFirst, const CombatKernel::FightOutcome& aSecond) {
+    return aFirst.fAttacks == aSecond.fAttacks && aFirst.fDamageTaken == aSecond.fDamageTaken &&
+           aFirst.fPlayerHealth == aSecond.fPlayerHealth && aFirst.fMonsterHealth == aSecond.fMonsterHealth &&
+           aFirst.fPlayerWon == aSecond.fPlayerWon;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    size_t actionCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+    actionCount = std::min(actionCount, count);
+
+    std::vector<int> playerHealth(count), attack(count), monsterHealth(count), damage(count);
+    std::mt19937 random(12345);
+    for (size_t i = 0; i < count; ++i) {
+        playerHealth[i] = 1 + static_cast<int>(random() % 200);
+        attack[i] = 1 + static_cast<int>(random() % 60);
+        monsterHealth[i] = static_cast<int>(random() % 301);  // 0: already defeated
+        damage[i] = static_cast<int>(random() % 41);
+    }
+
+    // Closed-form kernel
+    std::vector<int> attacks(count), taken(count), playerAfter(count), monsterAfter(count);
+    std::vector<uint8_t> won(count);
+    CombatKernel::FightInputs inputs{playerHealth.data(), attack.data(), monsterHealth.data(), damage.data()};
+    CombatKernel::FightOutputs outputs{attacks.data(), taken.data(), playerAfter.data(), monsterAfter.data(), won.data()};
+    auto start = Clock::now();
+    CombatKernel::resolveFights(count, inputs, outputs);
+    double kernelNs = nsPerFight(start, count);
+
+    // Exchange-by-exchange reference on Player and Monster objects
+    std::vector<CombatKernel::FightOutcome> reference(count);
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        Player player("Bench", playerHealth[i], attack[i]);
+        Monster monster("Bench", "", monsterHealth[i], damage[i]);
+        reference[i] = CombatKernel::simulateFight(player, monster);
+    }
+    double referenceNs = nsPerFight(start, count);
+
+    // AttackAction itself, one call per exchange (messages go to a NullSink)
+    size_t mismatches = 0;
+    NullSink sink;
+    start = Clock::now();
+    for (size_t i = 0; i < actionCount; ++i) {
+        Player player("Bench", playerHealth[i], attack[i]);
+        Monster monster("Bench", "", monsterHealth[i], damage[i]);
+        AttackAction action(player, sink);
+        int exchanges = 0;
+        while (monster.isAlive() && player.isAlive()) {
+            monster.accept(action);
+            ++exchanges;
+        }
+        CombatKernel::FightOutcome outcome{exchanges, playerHealth[i] - player.getHealth(), player.getHealth(),
+                                           monster.getHealth(), !monster.isAlive() && player.isAlive()};
+        if (!sameOutcome(outcome, reference[i])) ++mismatches;
+    }
+    double actionNs = nsPerFight(start, actionCount);
+
+    for (size_t i = 0; i < count; ++i) {
+        CombatKernel::FightOutcome outcome{attacks[i], taken[i], playerAfter[i], monsterAfter[i], won[i] != 0};
+        if (!sameOutcome(outcome, reference[i]) ||
+            !sameOutcome(CombatKernel::resolveFight(playerHealth[i], attack[i], monsterHealth[i], damage[i]),
+                         reference[i])) {
+            ++mismatches;
+        }
+    }
+
+    std::cout << "Fights: " << count << " (AttackAction: " << actionCount << ")\n";
+    std::cout << "AttackAction (NullSink):   " << actionNs << " ns/fight\n";
+    std::cout << "Reference simulation:      " << referenceNs << " ns/fight\n";
+    std::cout << "Closed-form kernel:        " << kernelNs << " ns/fight\n";
+    std::cout << "Mismatches: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
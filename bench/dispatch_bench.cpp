@@ -0,0 +1,147 @@
+/**
+ * Dispatch benchmark: classic Entity::accept/EntityVisitor double dispatch on
+ * one heap object per entity versus std::visit over the struct-of-arrays
+ * EntityStore. Usage: bench_dispatch [entity count] [passes]
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "Dungeon.h"
+#include "EntityStore.h"
+#include "OutputSink.h"
+#include "Player.h"
+#include "PlayerActions.h"
+#include "StaticActions.h"
+
+// Same rules as AttackAction/CollectAction/ExamineAction without any output,
+// so the virtual path is measured on dispatch and state access alone
+class SilentAction : public EntityVisitor {
+private:
+    Player& fPlayer;
+    int fAction;
+
+public:
+    SilentAction(Player& aPlayer, int aAction) : fPlayer(aPlayer), fAction(aAction) {}
+
+    void visitMonster(Monster& aMonster) override {
+        if (fAction != 1 || !aMonster.isAlive()) return;
+        aMonster.takeDamage(fPlayer.getAttackPower());
+        if (!aMonster.isAlive()) {
+            fPlayer.addScore(50);
+        } else {
+            fPlayer.takeDamage(aMonster.getDamage());
+        }
+    }
+
+    void visitItem(Item& aItem) override {
+        if (fAction != 2 || aItem.isCollected()) return;
+        aItem.collect();
+        fPlayer.addScore(aItem.getValue());
+    }
+
+    void visitClue(Clue& aClue) override {
+        if (fAction != 3 || aClue.isExamined()) return;
+        aClue.examine();
+        fPlayer.addScore(25);
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPerEntity(Clock::time_point aStart, size_t aCount) {
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - aStart;
+    return elapsed.count() / static_cast<double>(aCount);
+}
+
+// Fills a dungeon with a repeating monster/item/clue pattern (not placed in rooms)
+static std::vector<Entity*> makeEntities(Dungeon& aDungeon, size_t aCount) {
+    std::vector<Entity*> entities;
+    entities.reserve(aCount);
+    for (size_t i = 0; i < aCount; ++i) {
+        switch (i % 3) {
+            case 0: entities.push_back(aDungeon.createEntity<Monster>("Spider", "", 40 + int(i % 50), 15)); break;
+            case 1: entities.push_back(aDungeon.createEntity<Item>("Coins", "", 10 + int(i % 90))); break;
+            default: entities.push_back(aDungeon.createEntity<Clue>("Tablet", "", "")); break;
+        }
+    }
+    return entities;
+}
+
+static EntityStore makeStore(size_t aCount) {
+    EntityStore store;
+    store.reserve(aCount / 3 + 1, aCount / 3 + 1, aCount / 3 + 1);
+    for (size_t i = 0; i < aCount; ++i) {
+        switch (i % 3) {
+            case 0: store.addMonster(40 + int(i % 50), 15); break;
+            case 1: store.addItem(10 + int(i % 90)); break;
+            default: store.addClue(); break;
+        }
+    }
+    return store;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3000000;
+    int passes = argc > 2 ? std::atoi(argv[2]) : 3;
+    const int kHugeHealth = 1 << 30;
+
+    // Classic visitors (with their messages going to a NullSink)
+    Dungeon classicDungeon;
+    std::vector<Entity*> classic = makeEntities(classicDungeon, count);
+    Player classicPlayer("Bench", kHugeHealth, 25);
+    NullSink sink;
+    AttackAction attack(classicPlayer, sink);
+    CollectAction collect(classicPlayer, sink);
+    ExamineAction examine(classicPlayer, sink);
+    EntityVisitor* classicActions[] = {&attack, &collect, &examine};
+
+    auto start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (EntityVisitor* action : classicActions) {
+            for (Entity* entity : classic) entity->accept(*action);
+        }
+    }
+    double classicNs = nsPerEntity(start, count * 3 * passes);
+
+    // Silent virtual visitors
+    Dungeon silentDungeon;
+    std::vector<Entity*> silent = makeEntities(silentDungeon, count);
+    Player silentPlayer("Bench", kHugeHealth, 25);
+    SilentAction silentActions[] = {{silentPlayer, 1}, {silentPlayer, 2}, {silentPlayer, 3}};
+
+    start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (SilentAction& action : silentActions) {
+            for (Entity* entity : silent) entity->accept(action);
+        }
+    }
+    double silentNs = nsPerEntity(start, count * 3 * passes);
+
+    // Static dispatch over the struct-of-arrays store
+    EntityStore store = makeStore(count);
+    Player staticPlayer("Bench", kHugeHealth, 25);
+    StaticAttackAction staticAttack(store, staticPlayer);
+    StaticCollectAction staticCollect(store, staticPlayer);
+    StaticExamineAction staticExamine(store, staticPlayer);
+
+    start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const EntityHandle& handle : store.getHandles()) dispatchAction(staticAttack, handle);
+        for (const EntityHandle& handle : store.getHandles()) dispatchAction(staticCollect, handle);
+        for (const EntityHandle& handle : store.getHandles()) dispatchAction(staticExamine, handle);
+    }
+    double staticNs = nsPerEntity(start, count * 3 * passes);
+
+    std::cout << "Entities: " << count << ", passes: " << passes << "\n";
+    std::cout << "EntityVisitor (PlayerActions, NullSink): " << classicNs << " ns/entity-action\n";
+    std::cout << "EntityVisitor (silent):                  " << silentNs << " ns/entity-action\n";
+    std::cout << "std::visit over EntityStore:             " << staticNs << " ns/entity-action\n";
+
+    bool consistent = classicPlayer.getScore() == staticPlayer.getScore() &&
+                      silentPlayer.getScore() == staticPlayer.getScore() &&
+                      classicPlayer.getHealth() == staticPlayer.getHealth();
+    std::cout << "Scores: " << classicPlayer.getScore() << " / " << silentPlayer.getScore() << " / "
+              << staticPlayer.getScore() << (consistent ? " (consistent)" : " (MISMATCH)") << std::endl;
+    return consistent ? 0 : 1;
+}
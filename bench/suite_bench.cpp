@@ -0,0 +1,306 @@
+/**
+ * Benchmark suite for the game's hot paths, reported as JSON on stdout so runs
+ * of different versions can be compared by a script. Each benchmark is run in
+ * growing batches until a batch takes at least the minimum time; the last
+ * batch is reported as ns/op, ops/s, heap allocations and bytes per op and,
+ * where an op covers several units (rooms, items, steps), units/s.
+ * Usage: bench_suite [name filter] [min time in ms] [script]
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "Dungeon.h"
+#include "DungeonGenerator.h"
+#include "GameSession.h"
+#include "MenuScript.h"
+#include "OutputSink.h"
+#include "Player.h"
+#include "PlayerActions.h"
+#include "TempleDungeon.h"
+#include "TerminalView.h"
+
+// Every heap allocation of the process is counted, so a benchmark can report
+// how many an op makes
+static std::atomic<size_t> gAllocations{0};
+static std::atomic<size_t> gAllocatedBytes{0};
+
+// Out of line so GCC does not pair the free() with an inlined operator new
+__attribute__((noinline)) static void release(void* aMemory) {
+    std::free(aMemory);
+}
+
+void* operator new(size_t aSize) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(aSize, std::memory_order_relaxed);
+    if (void* memory = std::malloc(aSize ? aSize : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t aSize) {
+    return operator new(aSize);
+}
+
+void operator delete(void* aMemory) noexcept {
+    release(aMemory);
+}
+
+void operator delete[](void* aMemory) noexcept {
+    release(aMemory);
+}
+
+void operator delete(void* aMemory, size_t) noexcept {
+    release(aMemory);
+}
+
+void operator delete[](void* aMemory, size_t) noexcept {
+    release(aMemory);
+}
+
+// Keeps a result alive so the optimiser cannot drop the work producing it
+template <typename T>
+static void keep(const T& aValue) {
+    asm volatile("" : : "g"(&aValue) : "memory");
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Measurement {
+    std::string fName;
+    size_t fOps;
+    double fNsPerOp;
+    double fAllocationsPerOp;
+    double fBytesPerOp;
+    double fUnitsPerOp;  // Rooms, items or steps handled by one op (0 if not meaningful)
+    const char* fUnit;
+};
+
+class Suite {
+private:
+    std::string fFilter;
+    double fMinNs;
+    std::vector<Measurement> fResults;
+
+public:
+    Suite(std::string aFilter, double aMinMs) : fFilter(std::move(aFilter)), fMinNs(aMinMs * 1e6) {}
+
+    // aBatch(n) runs n ops; it is called with growing n until a batch is long
+    // enough to time
+    void run(const std::string& aName, double aUnitsPerOp, const char* aUnit,
+             const std::function<void(size_t)>& aBatch) {
+        if (aName.find(fFilter) == std::string::npos) {
+            return;
+        }
+        aBatch(1);  // Warm up
+        for (size_t ops = 1;; ops *= 4) {
+            size_t allocations = gAllocations.load();
+            size_t bytes = gAllocatedBytes.load();
+            auto start = Clock::now();
+            aBatch(ops);
+            std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            if (elapsed.count() >= fMinNs || ops >= (size_t(1) << 40)) {
+                double count = static_cast<double>(ops);
+                fResults.push_back(Measurement{aName, ops, elapsed.count() / count,
+                                               (gAllocations.load() - allocations) / count,
+                                               (gAllocatedBytes.load() - bytes) / count, aUnitsPerOp, aUnit});
+                std::cerr << aName << ": " << elapsed.count() / count << " ns/op" << std::endl;
+                return;
+            }
+        }
+    }
+
+    void writeJson(std::ostream& aOut) const {
+        aOut << "{\n  \"suite\": \"dungeon_crawler\",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < fResults.size(); ++i) {
+            const Measurement& result = fResults[i];
+            aOut << (i ? ",\n" : "\n") << "    {\"name\": \"" << result.fName << "\", \"ops\": " << result.fOps
+                 << ", \"ns_per_op\": " << result.fNsPerOp << ", \"ops_per_sec\": " << 1e9 / result.fNsPerOp
+                 << ", \"allocs_per_op\": " << result.fAllocationsPerOp
+                 << ", \"bytes_per_op\": " << result.fBytesPerOp;
+            if (result.fUnitsPerOp > 0) {
+                aOut << ", \"unit\": \"" << result.fUnit << "\", \"units_per_op\": " << result.fUnitsPerOp
+                     << ", \"units_per_sec\": " << 1e9 * result.fUnitsPerOp / result.fNsPerOp;
+            }
+            aOut << "}";
+        }
+        aOut << "\n  ]\n}\n";
+    }
+};
+
+// One entity of each kind per step of three, none placed in a room; monsters
+// cannot be killed and do not hurt, so attacks stay on the fighting path
+static std::vector<Entity*> makeEntities(Dungeon& aDungeon, size_t aCount) {
+    std::vector<Entity*> entities;
+    for (size_t i = 0; i < aCount; ++i) {
+        switch (i % 3) {
+            case 0: entities.push_back(aDungeon.createEntity<Monster>("Spider", "", 1 << 30, 0)); break;
+            case 1: entities.push_back(aDungeon.createEntity<Item>("Coins", "", 10)); break;
+            default: entities.push_back(aDungeon.createEntity<Clue>("Tablet", "", "")); break;
+        }
+    }
+    return entities;
+}
+
+// Visitor dispatch of one action over a mixed entity list (text to a NullSink);
+// after the first pass collect and examine take their repeat paths
+static void benchDispatch(Suite& aSuite) {
+    const size_t kEntities = 3 * 1024;
+    Dungeon dungeon;
+    std::vector<Entity*> entities = makeEntities(dungeon, kEntities);
+    Player player("Bench", 1 << 30, 25);
+    NullSink sink;
+    AttackAction attack(player, sink);
+    CollectAction collect(player, sink);
+    ExamineAction examine(player, sink);
+    std::pair<const char*, EntityVisitor*> actions[] = {
+        {"dispatch/attack", &attack}, {"dispatch/collect", &collect}, {"dispatch/examine", &examine}};
+
+    for (auto& [name, action] : actions) {
+        EntityVisitor* visitor = action;
+        aSuite.run(name, 0, "", [&](size_t aOps) {
+            for (size_t i = 0; i < aOps; ++i) {
+                entities[i % kEntities]->accept(*visitor);
+            }
+            keep(player);
+        });
+    }
+}
+
+// Room::describe of every temple room in turn into a reused buffer
+static void benchDescribe(Suite& aSuite) {
+    Dungeon dungeon = buildDungeon();
+    const std::vector<Room*>& rooms = dungeon.getRooms();
+    BufferSink sink;
+    aSuite.run("describe/temple_room", 0, "", [&](size_t aOps) {
+        for (size_t i = 0; i < aOps; ++i) {
+            sink.clear();
+            rooms[i % rooms.size()]->describe(sink);
+        }
+        keep(sink);
+    });
+}
+
+// Whole dungeons: the temple and generated dungeons of growing depth
+static void benchConstruction(Suite& aSuite) {
+    aSuite.run("build/temple", buildDungeon().getRoomCount(), "rooms", [](size_t aOps) {
+        for (size_t i = 0; i < aOps; ++i) {
+            Dungeon dungeon = buildDungeon();
+            keep(dungeon);
+        }
+    });
+
+    for (unsigned depth : {3u, 5u, 7u}) {
+        GeneratorConfig config;
+        config.fMinBranching = config.fMaxBranching = 3;
+        config.fDepth = depth;
+        DungeonGenerator generator(config);
+        aSuite.run("build/generated_depth" + std::to_string(depth), generator.generate().getRoomCount(), "rooms",
+                   [&](size_t aOps) {
+                       for (size_t i = 0; i < aOps; ++i) {
+                           Dungeon dungeon = generator.generate();
+                           keep(dungeon);
+                       }
+                   });
+    }
+}
+
+// Filling an empty inventory with 64 distinct items, short and long names
+// alternating and interned beforehand, then looking items up in a large one
+static void benchInventory(Suite& aSuite) {
+    const size_t kItems = 64;
+    std::vector<Symbol> fill;
+    for (size_t item = 0; item < kItems; ++item) {
+        std::string name = item % 2 ? "Coins " : "A pouch of ancient silver coins from the vault, number ";
+        fill.push_back(SymbolTable::global().intern(name + std::to_string(item)));
+    }
+    aSuite.run("inventory/fill64", kItems, "items", [&](size_t aOps) {
+        for (size_t i = 0; i < aOps; ++i) {
+            Player player("Bench", 100, 25);
+            for (Symbol item : fill) {
+                player.addToInventory(item, 10);
+            }
+            keep(player);
+        }
+    });
+
+    // Membership and count queries against an inventory of 4096 distinct items
+    const size_t kHeld = 4096;
+    Player player("Bench", 100, 25);
+    std::vector<Symbol> names;
+    for (size_t item = 0; item < 2 * kHeld; ++item) {
+        names.push_back(SymbolTable::global().intern("Relic " + std::to_string(item)));
+    }
+    for (size_t item = 0; item < kHeld; ++item) {
+        player.addToInventory(names[item * 2], 10);
+    }
+    aSuite.run("inventory/lookup4096", 0, "", [&](size_t aOps) {
+        size_t found = 0;
+        for (size_t i = 0; i < aOps; ++i) {
+            found += player.getInventory().count(names[i % names.size()]);
+        }
+        keep(found);
+    });
+}
+
+// End-to-end replay of a menu script as the terminal game plays it (fresh
+// temple, dungeon info, every step rendered), with and without the text
+static void benchReplay(Suite& aSuite, const MenuScript& aScript) {
+    auto replay = [&](OutputSink& aSink) {
+        Dungeon dungeon = buildDungeon();
+        Player player("Adventurer", 100, 25);
+        dungeon.displayInfo(aSink);
+        GameSession session(dungeon, player);
+        TerminalView view(aSink);
+        view.show(session, session.start());
+        for (int input : aScript.getInputs()) {
+            if (session.isOver()) break;
+            view.show(session, session.step(input));
+        }
+        keep(session);
+    };
+
+    double steps = static_cast<double>(aScript.getInputs().size());
+    aSuite.run("replay/script_text", steps, "steps", [&](size_t aOps) {
+        BufferSink sink;
+        for (size_t i = 0; i < aOps; ++i) {
+            sink.clear();
+            replay(sink);
+        }
+        keep(sink);
+    });
+    aSuite.run("replay/script_null", steps, "steps", [&](size_t aOps) {
+        NullSink sink;
+        for (size_t i = 0; i < aOps; ++i) {
+            replay(sink);
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    double minMs = argc > 2 ? std::atof(argv[2]) : 200;
+    std::string scriptPath = argc > 3 ? argv[3] : "test_input.txt";
+
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    MenuScript script = MenuScript::load(scriptFile);
+
+    Suite suite(filter, minMs);
+    benchDispatch(suite);
+    benchDescribe(suite);
+    benchConstruction(suite);
+    benchInventory(suite);
+    benchReplay(suite, script);
+    suite.writeJson(std::cout);
+    return 0;
+}
@@ -1,13 +1,39 @@
+#include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <memory>
 #include <limits>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <thread>
+#include <csignal>
+#include <unistd.h>
 #include "Player.h"
 #include "Monster.h"
 #include "Item.h"
 #include "Clue.h"
 #include "Room.h"
 #include "Dungeon.h"
-#include "PlayerActions.h"
+#include "OutputSink.h"
+#include "TempleDungeon.h"
+#include "MenuScript.h"
+#include "BatchSimulator.h"
+#include "DungeonGenerator.h"
+#include "DungeonFile.h"
+#include "RoomPager.h"
+#include "SubtreeStats.h"
+#include "GameSnapshot.h"
+#include "ActionJournal.h"
+#include "DungeonSolver.h"
+#include "DungeonAudit.h"
+#include "GameServer.h"
+#include "GameSession.h"
+#include "TerminalView.h"
 
 /**
  * COS30008 Problem Set 3 - Dungeon Crawler Game
@@ -23,263 +49,674 @@
  * and examine clues to progress through interconnected rooms organized as a tree.
  */
 
-// Function to build the dungeon with all rooms and entities
-Dungeon buildDungeon() {
-    Dungeon dungeon;
+// Main game loop: a terminal client of GameSession that reads menu choices
+// from std::cin until the game ends or input runs out
+void gameLoop(GameSession& session, OutputSink& out) {
+    TerminalView view(out);
+
+    view.show(session, session.start());
+    while (!session.isOver()) {
+        bool mainMenu = session.getPhase() == GameSession::Phase::MainMenu;
+        int choice = 0;
+        {
+            INSTRUMENT_SCOPE(Instrumentation::Metric::ParseInput);
+            if (!(std::cin >> choice) && std::cin.eof()) {
+                break;  // No more input
+            }
+
+            // Clear input buffer after main menu choices
+            if (mainMenu) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+        }
+
+        view.show(session, session.step(choice));
+    }
+    out.flush();
+}
 
-    // Create rooms (nodes in the tree)
-    Room* entrance = dungeon.createRoom("Temple Entrance",
-        "A grand stone archway marks the entrance to an ancient temple. "
-        "Torch light flickers on the walls.");
-
-    Room* mainHall = dungeon.createRoom("Main Hall",
-        "A vast hall with tall pillars reaching into darkness above. "
-        "Ancient murals depict forgotten rituals.");
-
-    Room* leftChamber = dungeon.createRoom("Guard Chamber",
-        "A chamber that once housed temple guards. "
-        "Old weapons and armor lie scattered about.");
-
-    Room* rightChamber = dungeon.createRoom("Treasure Vault",
-        "A small vault with ornate decorations and empty pedestals. "
-        "Something valuable might still remain here.");
-
-    Room* secretPassage = dungeon.createRoom("Secret Passage",
-        "A narrow, dusty passage hidden behind a false wall. "
-        "Few have walked this path.");
-
-    Room* innerSanctum = dungeon.createRoom("Inner Sanctum",
-        "The heart of the temple. A pedestal in the center holds "
-        "the Crystal of Power, glowing with ancient magic!");
-
-    // Add entities to rooms
-
-    // Entrance room entities
-    entrance->addEntity(std::make_shared<Clue>("Stone Tablet",
-        "An ancient stone tablet with carved inscriptions.",
-        "The inscription reads: 'Only the brave shall claim the crystal. "
-        "Beware the guardian in the chamber of guards.'"));
-
-    // Main Hall entities
-    mainHall->addEntity(std::make_shared<Monster>("Giant Spider",
-        "A massive spider with gleaming red eyes.",
-        40, 15));
-
-    mainHall->addEntity(std::make_shared<Item>("Health Potion",
-        "A shimmering red potion that restores vitality.",
-        30));
-
-    // Left Chamber (Guard Chamber) entities
-    leftChamber->addEntity(std::make_shared<Monster>("Skeleton Warrior",
-        "An undead warrior wielding a rusty sword.",
-        60, 20));
-
-    leftChamber->addEntity(std::make_shared<Clue>("Ancient Shield",
-        "A shield bearing the temple's emblem.",
-        "The emblem hints at a secret passage behind the eastern wall of the main hall."));
-
-    // Right Chamber (Treasure Vault) entities
-    rightChamber->addEntity(std::make_shared<Item>("Golden Amulet",
-        "A beautiful amulet encrusted with gems.",
-        100));
-
-    rightChamber->addEntity(std::make_shared<Item>("Silver Coins",
-        "A pouch of ancient silver coins.",
-        50));
-
-    // Secret Passage entities
-    secretPassage->addEntity(std::make_shared<Clue>("Dusty Journal",
-        "A journal left by a previous adventurer.",
-        "The final entry: 'I found the way to the sanctum, but I'm too weak to continue. "
-        "The crystal lies ahead...'"));
-
-    secretPassage->addEntity(std::make_shared<Monster>("Shadow Beast",
-        "A creature made of living darkness.",
-        50, 18));
-
-    // Inner Sanctum entities
-    innerSanctum->addEntity(std::make_shared<Item>("Crystal of Power",
-        "The legendary Crystal of Power, radiating mystical energy!",
-        500));
-
-    // Build the tree structure by connecting rooms
-    // Entrance connects to Main Hall
-    entrance->connectRoom(mainHall, "North Door - Main Hall");
-
-    // Main Hall connects to three rooms
-    mainHall->connectRoom(leftChamber, "West Door - Guard Chamber");
-    mainHall->connectRoom(rightChamber, "East Door - Treasure Vault");
-    mainHall->connectRoom(secretPassage, "Hidden Door - Secret Passage (requires examination)");
-
-    // Secret Passage connects to Inner Sanctum
-    secretPassage->connectRoom(innerSanctum, "Ancient Door - Inner Sanctum");
-
-    // Set entrance as root of the tree
-    dungeon.setEntrance(entrance);
-
-    return dungeon;
+// A new session's game loop; the optional listener is told about defeated
+// monsters, collected items and examined clues
+void gameLoop(const Dungeon& dungeon, const Player& player, OutputSink& out, ActionListener* listener = nullptr) {
+    GameSession session(dungeon, player);
+    session.getState().setListener(listener);
+    gameLoop(session, out);
 }
 
-// Function to handle player interaction with entities in current room
-void interactWithRoom(Room* currentRoom, Player& player) {
-    const auto& entities = currentRoom->getEntities();
+// Living-world mode: play the temple while monsters regenerate, respawn and
+// roam, then show what is left; the totals are kept up to date as things
+// happen and checked against a recount of the session
+int runWorld(uint64_t seed) {
+    Dungeon dungeon = buildDungeon();
+    StreamSink out(std::cout);
+    dungeon.displayInfo(out);
+
+    GameSession session(dungeon, Player("Adventurer", 100, 25));
+    SubtreeStats stats(dungeon, &session.getState());
+    session.getState().setListener(&stats);
+    session.enableWorld(WorldRules::living(seed));
+    gameLoop(session, out);
+
+    stats.display(out, dungeon.getEntrance());
+    out.flush();
+    if (stats != SubtreeStats(dungeon, &session.getState())) {
+        std::cerr << "Subtree totals differ from a recount" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Headless mode: replay a menu script in many parallel sessions over one
+// dungeon, each in a living world of its own if world rules are given
+int runBatch(size_t sessions, size_t threads, const std::string& scriptPath, const WorldRules* world = nullptr) {
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    MenuScript script = MenuScript::load(scriptFile);
+
+    Dungeon dungeon = buildDungeon();
+    Player prototype("Adventurer", 100, 25);
+    BatchSimulator simulator(dungeon, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    BatchResult result = simulator.run(sessions, prototype,
+        [&script, world](SessionState& state, size_t index) {
+            if (!world) {
+                script.play(state);
+                return;
+            }
+            WorldRules rules = *world;
+            rules.fSeed += index;
+            WorldScheduler scheduler(state, rules);
+            script.play(state, nullptr, &scheduler);
+        });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Sessions: " << result.fSessions << std::endl;
+    std::cout << "Threads: " << simulator.getThreadCount() << std::endl;
+    std::cout << "Survivors: " << result.fSurvivors << std::endl;
+    std::cout << "Score (min/avg/max): " << result.getMinScore() << "/" << result.getAverageScore()
+              << "/" << result.getMaxScore() << std::endl;
+    std::cout << "Elapsed: " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? result.fSessions / elapsed.count() : 0.0)
+              << " sessions/s)" << std::endl;
+    return 0;
+}
 
-    if (entities.empty()) {
-        std::cout << "\nThere's nothing to interact with in this room." << std::endl;
-        return;
+// Replay mode: run the interactive game loop on a menu script repeatedly,
+// reading the script instead of the terminal, and report the time per replay
+int runReplay(const std::string& scriptPath, size_t iterations, const std::string& sinkName) {
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    std::string script((std::istreambuf_iterator<char>(scriptFile)), std::istreambuf_iterator<char>());
+
+    std::unique_ptr<OutputSink> sink;
+    if (sinkName == "null") {
+        sink = std::make_unique<NullSink>();
+    } else if (sinkName == "buffer") {
+        sink = std::make_unique<BufferSink>();
+    } else if (sinkName == "ring") {
+        sink = std::make_unique<RingBufferSink>(64 * 1024);
+    } else {
+        sink = std::make_unique<StreamSink>(std::cout);
     }
 
-    std::cout << "\nWhat would you like to interact with?" << std::endl;
-    for (size_t i = 0; i < entities.size(); ++i) {
-        std::cout << "  " << (i + 1) << ". " << entities[i]->getName() << std::endl;
+    std::streambuf* terminal = std::cin.rdbuf();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        std::istringstream input(script);
+        std::cin.rdbuf(input.rdbuf());
+        Dungeon dungeon = buildDungeon();
+        Player player("Adventurer", 100, 25);
+        dungeon.displayInfo(*sink);
+        gameLoop(dungeon, player, *sink);
+        if (auto* buffer = dynamic_cast<BufferSink*>(sink.get())) {
+            buffer->clear();
+        }
     }
-    std::cout << "  0. Cancel" << std::endl;
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::cin.rdbuf(terminal);
+    INSTRUMENT_DUMP(std::cerr);
+
+    std::cerr << "Replays: " << iterations << ", sink: " << sinkName << ", "
+              << (iterations ? elapsed.count() / iterations : 0.0) << " us/replay" << std::endl;
+    return 0;
+}
 
-    int choice;
-    std::cout << "Enter choice: ";
-    std::cin >> choice;
+// Generator mode: build a procedural dungeon and report its size and build time
+int runGenerate(const GeneratorConfig& config) {
+    auto start = std::chrono::steady_clock::now();
+    Dungeon dungeon = DungeonGenerator(config).generate();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    StreamSink out(std::cout);
+    dungeon.displayInfo(out);
+    out << "Entities: " << dungeon.getEntityCount() << "\n";
+    out << "Fingerprint: " << dungeonFingerprint(dungeon) << "\n";
+    SubtreeStats(dungeon).display(out, dungeon.getEntrance());
+    out.flush();
+    std::cout << "Generated in " << elapsed.count() << " ms on " << config.fThreads << " thread(s)" << std::endl;
+    return 0;
+}
 
-    if (choice == 0 || choice > static_cast<int>(entities.size())) {
-        return;
+// Save mode: write the temple (or a generated dungeon) to a binary dungeon file
+int runSave(const std::string& path, const GeneratorConfig* config) {
+    Dungeon dungeon = config ? DungeonGenerator(*config).generate() : buildDungeon();
+    try {
+        saveDungeon(dungeon, path);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
     }
+    std::cout << "Saved " << dungeon.getRoomCount() << " rooms and " << dungeon.getEntityCount()
+              << " entities to " << path << std::endl;
+    return 0;
+}
 
-    auto entity = currentRoom->getEntity(choice - 1);
-    if (!entity) {
-        std::cout << "Invalid selection." << std::endl;
-        return;
+// Compress mode: rewrite a dungeon file with its descriptions and hidden info
+// dictionary-compressed
+int runCompress(const std::string& inPath, const std::string& outPath) {
+    try {
+        Dungeon dungeon = loadDungeon(inPath);
+        saveDungeon(dungeon, outPath, true);
+        DungeonFile::Loader saved(outPath);
+        const DungeonFile::Header& header = saved.getHeader();
+        std::cout << "Saved " << dungeon.getRoomCount() << " rooms to " << outPath << ": " << header.fTextSize
+                  << " bytes of text, " << header.fColdSize << " bytes of compressed text, "
+                  << header.fDictionarySize << " bytes of dictionary" << std::endl;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
     }
+    return 0;
+}
 
-    // Choose action
-    std::cout << "\nWhat action do you want to perform?" << std::endl;
-    std::cout << "  1. Attack" << std::endl;
-    std::cout << "  2. Collect" << std::endl;
-    std::cout << "  3. Examine" << std::endl;
-    std::cout << "  0. Cancel" << std::endl;
+// Resident memory of this process
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
 
-    int action;
-    std::cout << "Enter choice: ";
-    std::cin >> action;
+// Footprint mode: load a dungeon file, read all of its descriptions and
+// hidden info and report the memory used per room before and after, and
+// their size plain and compressed side by side
+int runFootprint(const std::string& path) {
+    class TextReader : public EntityVisitor {
+    public:
+        size_t fBytes = 0;
+        std::unordered_set<std::string>* fDistinct = nullptr;  // Collects the texts, if set
+
+        void read(std::string_view aText) {
+            fBytes += aText.size();
+            if (fDistinct && !aText.empty()) fDistinct->emplace(aText);
+        }
 
-    // Apply visitor pattern based on action
-    switch (action) {
-        case 1: {
-            AttackAction attack(player);
-            entity->accept(attack);
-            break;
+        void visitMonster(Monster& aMonster) override { read(aMonster.getDescription()); }
+        void visitItem(Item& aItem) override { read(aItem.getDescription()); }
+        void visitClue(Clue& aClue) override {
+            read(aClue.getDescription());
+            read(aClue.getHiddenInfo());
         }
-        case 2: {
-            CollectAction collect(player);
-            entity->accept(collect);
-            break;
+    };
+
+    size_t before = residentBytes();
+    Dungeon dungeon;
+    std::unique_ptr<DungeonFile::Loader> loader;
+    try {
+        loader = std::make_unique<DungeonFile::Loader>(path);
+        dungeon = loader->load();
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    size_t loaded = residentBytes();
+    TextReader reader;
+    for (const Room* room : dungeon.getRooms()) {
+        reader.fBytes += room->getDescription().size();
+        for (Entity* entity : room->getEntities()) {
+            entity->accept(reader);
         }
-        case 3: {
-            ExamineAction examine(player);
-            entity->accept(examine);
-            break;
+    }
+    size_t read = residentBytes();
+
+    // The distinct texts as saveDungeon() would store them either way
+    std::unordered_set<std::string> distinct;
+    TextReader collector;
+    collector.fDistinct = &distinct;
+    for (const Room* room : dungeon.getRooms()) {
+        collector.read(room->getDescription());
+        for (Entity* entity : room->getEntities()) {
+            entity->accept(collector);
         }
-        default:
-            std::cout << "No action performed." << std::endl;
     }
+    std::vector<std::string_view> texts(distinct.begin(), distinct.end());
+    TextDictionary dictionary = TextDictionary::train(texts);
+    size_t plainSize = 0;
+    std::string encoded;
+    for (std::string_view text : texts) {
+        plainSize += text.size();
+        dictionary.encode(text, encoded);
+    }
+    size_t compressedSize = encoded.size() + dictionary.serialize().size();
+
+    const DungeonFile::Header& header = loader->getHeader();
+    size_t rooms = std::max<size_t>(dungeon.getRoomCount(), 1);
+    std::cout << "Rooms: " << dungeon.getRoomCount() << ", entities: " << dungeon.getEntityCount() << "\n"
+              << "File text: " << header.fTextSize << " bytes plain, " << header.fColdSize << " bytes compressed, "
+              << header.fDictionarySize << " bytes of dictionary\n"
+              << "Distinct descriptions and hidden info: " << plainSize << " bytes plain vs " << encoded.size()
+              << " + " << compressedSize - encoded.size() << " bytes of dictionary = " << compressedSize
+              << " bytes compressed (" << 100 * compressedSize / std::max<size_t>(plainSize, 1) << "%), saved "
+              << (compressedSize < plainSize ? "compressed" : "plain") << " by --compress\n"
+              << "Descriptions and hidden info read: " << reader.fBytes << " bytes\n"
+              << "Resident after loading: " << (loaded - before) / rooms << " bytes per room\n"
+              << "Resident after reading all text: " << (read - before) / rooms << " bytes per room" << std::endl;
+    return 0;
 }
 
-// Main game loop
-void gameLoop(Dungeon& dungeon, Player& player) {
-    Room* currentRoom = dungeon.getEntrance();
-    bool gameRunning = true;
-
-    std::cout << "\n╔════════════════════════════════════════════════════╗" << std::endl;
-    std::cout << "║     WELCOME TO THE TEMPLE OF THE ANCIENTS!        ║" << std::endl;
-    std::cout << "╚════════════════════════════════════════════════════╝" << std::endl;
-    std::cout << "\nYour quest: Find the legendary Crystal of Power!" << std::endl;
-    std::cout << "Navigate through rooms, defeat monsters, collect treasures," << std::endl;
-    std::cout << "and examine clues to guide your journey." << std::endl;
-
-    while (gameRunning && player.isAlive()) {
-        // Display current room
-        currentRoom->describe();
-
-        // Show menu
-        std::cout << "\n=== Actions ===" << std::endl;
-        std::cout << "1. Interact with entities" << std::endl;
-        std::cout << "2. Move to another room" << std::endl;
-        std::cout << "3. View player status" << std::endl;
-        std::cout << "4. Quit game" << std::endl;
-        std::cout << "===============" << std::endl;
-
-        int choice;
-        std::cout << "Enter choice: ";
-        std::cin >> choice;
-
-        // Clear input buffer
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-        switch (choice) {
-            case 1:
-                interactWithRoom(currentRoom, player);
-                break;
-
-            case 2: {
-                const auto& connectedRooms = currentRoom->getConnectedRooms();
-                if (connectedRooms.empty()) {
-                    std::cout << "\nThere are no exits from this room!" << std::endl;
-                    break;
-                }
-
-                std::cout << "\nWhere would you like to go?" << std::endl;
-                const auto& doorNames = currentRoom->getDoorNames();
-                for (size_t i = 0; i < doorNames.size(); ++i) {
-                    std::cout << "  " << (i + 1) << ". " << doorNames[i] << std::endl;
-                }
-                std::cout << "  0. Stay here" << std::endl;
-
-                int roomChoice;
-                std::cout << "Enter choice: ";
-                std::cin >> roomChoice;
-
-                if (roomChoice > 0 && roomChoice <= static_cast<int>(connectedRooms.size())) {
-                    currentRoom = currentRoom->getConnectedRoom(roomChoice - 1);
-                    std::cout << "\nYou move through the door..." << std::endl;
-                }
-                break;
-            }
+// Load mode: map a binary dungeon file and play it
+int runLoad(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    Dungeon dungeon;
+    try {
+        dungeon = loadDungeon(path);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "Loaded " << path << " in " << elapsed.count() << " ms" << std::endl;
 
-            case 3:
-                player.displayStatus();
-                break;
+    Player player("Adventurer", 100, 25);
+    StreamSink out(std::cout);
+    dungeon.displayInfo(out);
+    gameLoop(dungeon, player, out);
+    INSTRUMENT_DUMP(std::cerr);
+    return 0;
+}
 
-            case 4:
-                std::cout << "\nThanks for playing!" << std::endl;
-                gameRunning = false;
-                break;
+// Paged mode: play a binary dungeon file with room content loaded on demand
+// and kept within a memory budget, then report how the pager did
+int runPaged(const std::string& path, size_t budget) {
+    Dungeon dungeon;
+    try {
+        dungeon = loadPagedDungeon(path, budget);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
 
-            default:
-                std::cout << "\nInvalid choice. Try again." << std::endl;
-        }
+    // Content is read from the file as rooms are paged in during play
+    Player player("Adventurer", 100, 25);
+    StreamSink out(std::cout);
+    try {
+        dungeon.displayInfo(out);
+        gameLoop(dungeon, player, out);
+    } catch (const std::exception& error) {
+        out.flush();
+        std::cerr << error.what() << std::endl;
+        return 1;
     }
+    INSTRUMENT_DUMP(std::cerr);
 
-    if (!player.isAlive()) {
-        std::cout << "\n╔════════════════════════════════════════╗" << std::endl;
-        std::cout << "║          GAME OVER                     ║" << std::endl;
-        std::cout << "║   You have been defeated...            ║" << std::endl;
-        std::cout << "╚════════════════════════════════════════╝" << std::endl;
+    const RoomPager& pager = static_cast<const RoomPager&>(*dungeon.getLoader());
+    std::cerr << "Paged " << dungeon.getRoomCount() << " rooms: " << pager.getLoadCount() << " loads, "
+              << pager.getEvictionCount() << " evictions, " << pager.getResidentRooms() << " resident ("
+              << pager.getResidentBytes() << " bytes), peak " << pager.getPeakBytes() << " of "
+              << pager.getBudget() << " bytes" << std::endl;
+    return 0;
+}
+
+// Route mode: show the shortest way to a room of the temple from the entrance
+int runRoute(const std::string& roomName) {
+    Dungeon dungeon = buildDungeon();
+    Room* target = dungeon.findRoom(roomName);
+    std::vector<uint32_t> doors;
+    uint32_t entranceId = static_cast<uint32_t>(dungeon.getEntrance()->getId());
+    if (!target || !dungeon.getGraph().findPath(entranceId, static_cast<uint32_t>(target->getId()), doors)) {
+        std::cerr << "No route to " << roomName << std::endl;
+        return 1;
     }
 
-    std::cout << "\nFinal Score: " << player.getScore() << std::endl;
+    StreamSink out(std::cout);
+    Room* room = dungeon.getEntrance();
+    out << room->getName() << "\n";
+    for (uint32_t door : doors) {
+        out << "  -> " << room->getDoorName(door) << " (door " << door + 1 << ")\n";
+        room = room->getConnectedRoom(door);
+    }
+    out << "Depth: " << dungeon.getIndex().getDepth(target) << "\n";
+    SubtreeStats(dungeon).display(out, target);
+    out.flush();
+    return 0;
+}
+
+// Snapshot mode: play a menu script in a session, then time capturing its
+// state and restoring it into a fresh session
+int runSnapshot(const std::string& scriptPath, size_t iterations, const GeneratorConfig* config) {
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    MenuScript script = MenuScript::load(scriptFile);
+
+    Dungeon dungeon = config ? DungeonGenerator(*config).generate() : buildDungeon();
+    Player prototype("Adventurer", 100, 25);
+    SessionState played(dungeon, prototype);
+    script.play(played);
+    SessionState resumed(dungeon, prototype);
+
+    std::vector<uint8_t> snapshot;
+    std::vector<uint8_t> check;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        GameSnapshot::capture(played, snapshot);
+        GameSnapshot::restore(resumed, snapshot);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    GameSnapshot::capture(resumed, check);
+
+    std::vector<uint8_t> full;
+    GameSnapshot::capture(dungeon, played.getPlayer(), played.getCurrentRoom(), full);
+
+    std::cout << "Rooms: " << dungeon.getRoomCount() << ", entities: " << dungeon.getEntityCount() << std::endl;
+    std::cout << "Changed entities: " << played.getChangedEntities().size() << std::endl;
+    std::cout << "Delta snapshot: " << snapshot.size() << " bytes (full: " << full.size() << " bytes)" << std::endl;
+    std::cout << "Round trip: " << (check == snapshot ? "identical" : "MISMATCH") << std::endl;
+    std::cout << "Capture + restore: " << (iterations ? elapsed.count() / iterations : 0.0) << " us" << std::endl;
+    return check == snapshot ? 0 : 1;
 }
 
-int main() {
+// Record mode: play a menu script headlessly and save its moves and actions as a journal
+int runRecord(const std::string& scriptPath, const std::string& journalPath) {
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    MenuScript script = MenuScript::load(scriptFile);
+
+    Dungeon dungeon = buildDungeon();
+    SessionState state(dungeon, Player("Adventurer", 100, 25));
+    ActionJournal journal;
+    script.play(state, &journal);
+    try {
+        journal.save(journalPath);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Recorded " << journal.getEntryCount() << " entries (" << journal.getEntries().size()
+              << " bytes) to " << journalPath << ", final score " << state.getPlayer().getScore() << std::endl;
+    return 0;
+}
+
+// Playback mode: replay a journal in many parallel sessions; every session
+// must end in the same state, so differing scores indicate a regression
+int runPlayback(const std::string& journalPath, size_t sessions, size_t threads) {
+    Dungeon dungeon = buildDungeon();
+    Player prototype("Adventurer", 100, 25);
+    ActionJournal journal;
+    try {
+        journal = ActionJournal::load(journalPath, dungeon, prototype);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    BatchSimulator simulator(dungeon, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    BatchResult result = simulator.run(sessions, prototype,
+        [&journal](SessionState& state, size_t) { journal.replay(state); });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Sessions: " << result.fSessions << std::endl;
+    std::cout << "Survivors: " << result.fSurvivors << std::endl;
+    std::cout << "Score (min/max): " << result.getMinScore() << "/" << result.getMaxScore() << std::endl;
+    std::cout << "Elapsed: " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? result.fSessions / elapsed.count() : 0.0)
+              << " sessions/s)" << std::endl;
+    return result.getMinScore() == result.getMaxScore() ? 0 : 1;
+}
+
+// Solve mode: find the best score reachable without dying in the temple (or a
+// dungeon file), print the route and check it by replaying its actions
+int runSolve(size_t threads, const std::string& path) {
+    Dungeon dungeon;
+    DungeonSolver::Result result;
+    Player player("Adventurer", 100, 25);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        dungeon = path.empty() ? buildDungeon() : loadDungeon(path);
+        start = std::chrono::steady_clock::now();
+        result = DungeonSolver(dungeon, player).solve(threads);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    SessionState state(dungeon, player);
+    result.fJournal.replay(state);
+    bool verified = state.getPlayer().isAlive() && state.getPlayer().getScore() == result.fScore &&
+                    state.getPlayer().getHealth() == result.fHealth;
+
+    StreamSink out(std::cout);
+    out << "Best score: " << result.fScore << " (health left " << result.fHealth << ")"
+        << (result.fIsExact ? "" : ", a lower bound: doors leading back were not used") << "\n";
+    out << "Route:";
+    for (Room* room : result.fRoute) {
+        out << (room == result.fRoute.front() ? " " : " -> ") << room->getName();
+    }
+    out << "\n";
+    out << "Actions: " << result.fJournal.getEntryCount() << ", replay " << (verified ? "matches" : "MISMATCH") << "\n";
+    out << "States: " << result.fStates << "\n";
+    out.flush();
+    std::cout << "Solved in " << elapsed.count() << " ms on " << threads << " thread(s)" << std::endl;
+    return verified ? 0 : 1;
+}
+
+// Audit mode: monster difficulty by depth and unreachable entities of the
+// temple (or a dungeon file), gathered with a visitor per thread
+int runAudit(size_t threads, const std::string& path) {
+    Dungeon dungeon;
+    try {
+        dungeon = path.empty() ? buildDungeon() : loadDungeon(path);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DungeonAudit audit = DungeonTraversal(dungeon).reduce(
+        nullptr, threads, [&dungeon] { return std::make_unique<DungeonAudit>(dungeon); }, DungeonAudit(dungeon),
+        [](DungeonAudit& aTotal, const DungeonAudit& aPart) { aTotal.merge(aPart); });
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    StreamSink out(std::cout);
+    audit.display(out);
+    out.flush();
+    std::cout << "Audited in " << elapsed.count() << " ms on " << threads << " thread(s)" << std::endl;
+    return 0;
+}
+
+// Serve mode: play the temple with many clients over a Unix socket until
+// SIGINT or SIGTERM
+int runServe(const std::string& socketPath, size_t threads) {
+    Dungeon dungeon = buildDungeon();
+    Player player("Adventurer", 100, 25);
+
+    // Block the stop signals before the shard threads start so only sigwait sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    GameServer server(dungeon, player, threads);
+    try {
+        server.start(socketPath);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << socketPath << " on " << server.getShardCount() << " thread(s)" << std::endl;
+
+    int received = 0;
+    sigwait(&signals, &received);
+    std::cout << "Stopping with " << server.getSessionCount() << " session(s) open" << std::endl;
+    server.stop();
+    server.wait();
+    INSTRUMENT_DUMP(std::cerr);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // dungeon_crawler --serve <socket path> [threads]
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+        return runServe(argv[2], threads);
+    }
+
+    // dungeon_crawler --solve [threads] [dungeon file]
+    if (argc > 1 && std::string(argv[1]) == "--solve") {
+        size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+        return runSolve(threads, argc > 3 ? argv[3] : "");
+    }
+
+    // dungeon_crawler --audit [threads] [dungeon file]
+    if (argc > 1 && std::string(argv[1]) == "--audit") {
+        size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+        return runAudit(threads, argc > 3 ? argv[3] : "");
+    }
+
+    // dungeon_crawler --record <script> <journal>
+    if (argc > 3 && std::string(argv[1]) == "--record") {
+        return runRecord(argv[2], argv[3]);
+    }
+
+    // dungeon_crawler --playback <journal> [sessions] [threads]
+    if (argc > 2 && std::string(argv[1]) == "--playback") {
+        size_t sessions = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000;
+        size_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+        return runPlayback(argv[2], sessions, threads);
+    }
+
+    // dungeon_crawler --snapshot <script> [iterations] [seed branching depth]
+    if (argc > 2 && std::string(argv[1]) == "--snapshot") {
+        size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100000;
+        if (argc > 6) {
+            GeneratorConfig config;
+            config.fSeed = std::strtoull(argv[4], nullptr, 10);
+            config.fMaxBranching = static_cast<unsigned>(std::strtoul(argv[5], nullptr, 10));
+            config.fMinBranching = config.fMaxBranching;
+            config.fDepth = static_cast<unsigned>(std::strtoul(argv[6], nullptr, 10));
+            config.fThreads = std::thread::hardware_concurrency();
+            return runSnapshot(argv[2], iterations, &config);
+        }
+        return runSnapshot(argv[2], iterations, nullptr);
+    }
+
+    // dungeon_crawler --route <room name>
+    if (argc > 2 && std::string(argv[1]) == "--route") {
+        return runRoute(argv[2]);
+    }
+
+    // dungeon_crawler --save <path> [seed branching depth]
+    if (argc > 2 && std::string(argv[1]) == "--save") {
+        if (argc > 5) {
+            GeneratorConfig config;
+            config.fSeed = std::strtoull(argv[3], nullptr, 10);
+            config.fMaxBranching = static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10));
+            config.fMinBranching = config.fMaxBranching;
+            config.fDepth = static_cast<unsigned>(std::strtoul(argv[5], nullptr, 10));
+            config.fThreads = std::thread::hardware_concurrency();
+            return runSave(argv[2], &config);
+        }
+        return runSave(argv[2], nullptr);
+    }
+
+    // dungeon_crawler --load <path>
+    if (argc > 2 && std::string(argv[1]) == "--load") {
+        return runLoad(argv[2]);
+    }
+
+    // dungeon_crawler --compress <dungeon file> <compressed file>
+    if (argc > 3 && std::string(argv[1]) == "--compress") {
+        return runCompress(argv[2], argv[3]);
+    }
+
+    // dungeon_crawler --footprint <dungeon file>
+    if (argc > 2 && std::string(argv[1]) == "--footprint") {
+        return runFootprint(argv[2]);
+    }
+
+    // dungeon_crawler --paged <file> [budget KB]
+    if (argc > 2 && std::string(argv[1]) == "--paged") {
+        size_t budget = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1024;
+        return runPaged(argv[2], budget * 1024);
+    }
+
+    // dungeon_crawler --generate <seed> <branching> <depth> [threads]
+    if (argc > 1 && std::string(argv[1]) == "--generate") {
+        GeneratorConfig config;
+        config.fSeed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+        config.fMaxBranching = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 3;
+        config.fMinBranching = config.fMaxBranching;
+        config.fDepth = argc > 4 ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10)) : 6;
+        config.fThreads = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : std::thread::hardware_concurrency();
+        return runGenerate(config);
+    }
+
+    // dungeon_crawler --replay <script> <iterations> [stdout|null|buffer|ring]
+    if (argc > 1 && std::string(argv[1]) == "--replay") {
+        std::string scriptPath = argc > 2 ? argv[2] : "test_input.txt";
+        size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+        std::string sinkName = argc > 4 ? argv[4] : "stdout";
+        return runReplay(scriptPath, iterations, sinkName);
+    }
+
+    // dungeon_crawler --batch <sessions> [threads] [script]
+    // dungeon_crawler --world-batch <sessions> [threads] [script]
+    if (argc > 1 && (std::string(argv[1]) == "--batch" || std::string(argv[1]) == "--world-batch")) {
+        size_t sessions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+        size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+        std::string scriptPath = argc > 4 ? argv[4] : "test_input.txt";
+        WorldRules world = WorldRules::living();
+        return runBatch(sessions, threads, scriptPath, std::string(argv[1]) == "--world-batch" ? &world : nullptr);
+    }
+
+    // dungeon_crawler --world [seed]
+    if (argc > 1 && std::string(argv[1]) == "--world") {
+        return runWorld(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1);
+    }
+
     // Build the dungeon
     Dungeon dungeon = buildDungeon();
 
     // Create player
     Player player("Adventurer", 100, 25);
 
+    // All game text goes through one sink on standard output
+    StreamSink out(std::cout);
+
     // Display dungeon info
-    dungeon.displayInfo();
+    dungeon.displayInfo(out);
 
-    // Start game loop
-    gameLoop(dungeon, player);
+    // Start game loop (instrumented builds report their measurements on stderr)
+    gameLoop(dungeon, player, out);
+    INSTRUMENT_DUMP(std::cerr);
 
     return 0;
 }
@@ -0,0 +1,114 @@
+/**
+ * Checks that a dungeon file whose compressed entity text is cut short is
+ * rejected when it is opened, by both loadDungeon() and loadPagedDungeon(),
+ * instead of failing later when the text is shown. The texts end in an
+ * escaped byte, so one byte less leaves an escape without its byte.
+ * Usage: dungeon_file_test [scratch file]
+ */
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Dungeon.h"
+#include "DungeonFile.h"
+#include "RoomPager.h"
+
+// Two rooms with entities and a corridor of rooms described alike, so
+// compressing the text pays; the texts that get cut end in a UTF-8 character (escaped bytes)
+static Dungeon buildDungeon() {
+    Dungeon dungeon;
+    Room* hall = dungeon.createRoom("Hall", "A long hall with a vaulted ceiling");
+    Room* crypt = dungeon.createRoom("Crypt", "A low crypt that smells of old stone");
+    hall->addEntity(dungeon.createEntity<Item>("Amulet", dungeon.storeText("A silver amulet marked \xC3\xA9"), 40));
+    crypt->addEntity(dungeon.createEntity<Monster>("Ghoul", dungeon.storeText("A hungry ghoul"), 30, 5));
+    crypt->addEntity(dungeon.createEntity<Clue>("Tablet", dungeon.storeText("A cracked stone tablet"),
+                                                dungeon.storeText("The exit lies beyond the \xC3\xA9")));
+    dungeon.connectRooms(hall, crypt, "Stairs", "");
+    Room* last = crypt;
+    for (int i = 0; i < 32; ++i) {
+        Room* corridor = dungeon.createRoom(
+            "Corridor", "A damp and narrow stretch of the ancient temple corridor, number " + std::to_string(i));
+        dungeon.connectRooms(last, corridor, "Onwards", "");
+        last = corridor;
+    }
+    dungeon.setEntrance(hall);
+    dungeon.buildIndex();
+    return dungeon;
+}
+
+static std::vector<char> readFile(const std::string& aPath) {
+    std::ifstream file(aPath, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& aPath, const std::vector<char>& aBytes) {
+    std::ofstream file(aPath, std::ios::binary | std::ios::trunc);
+    file.write(aBytes.data(), static_cast<std::streamsize>(aBytes.size()));
+}
+
+// Whether opening the file with the loader throws
+template <typename Open>
+static bool rejects(const std::string& aPath, Open aOpen) {
+    try {
+        aOpen(aPath);
+    } catch (const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "dungeon_file_test.dgn";
+    saveDungeon(buildDungeon(), path, true);
+    std::vector<char> intact = readFile(path);
+
+    auto load = [](const std::string& aPath) { loadDungeon(aPath); };
+    auto loadPaged = [](const std::string& aPath) { loadPagedDungeon(aPath, 0); };
+    size_t failures = 0;
+    if (rejects(path, load) || rejects(path, loadPaged)) {
+        std::cerr << "The intact file does not load" << std::endl;
+        ++failures;
+    }
+
+    // Cut one byte off the item's description, then off the clue's hidden info
+    DungeonFile::Header header;
+    std::memcpy(&header, intact.data(), sizeof(header));
+    struct Cut {
+        const char* fName;
+        size_t fEntity;
+        size_t fRefOffset;  // Of the TextRef in the EntityRecord
+    };
+    const Cut cuts[] = {{"item description", 0, offsetof(DungeonFile::EntityRecord, fDescription)},
+                        {"clue hidden info", 2, offsetof(DungeonFile::EntityRecord, fHiddenInfo)}};
+    for (const Cut& cut : cuts) {
+        std::vector<char> bytes = intact;
+        size_t refAt = header.fEntityOffset + cut.fEntity * sizeof(DungeonFile::EntityRecord) + cut.fRefOffset;
+        DungeonFile::TextRef ref;
+        std::memcpy(&ref, bytes.data() + refAt, sizeof(ref));
+        if (ref.fEncoding != DungeonFile::kCompressed || ref.fLength == 0) {
+            std::cerr << cut.fName << " is not compressed" << std::endl;
+            ++failures;
+            continue;
+        }
+        --ref.fLength;
+        std::memcpy(bytes.data() + refAt, &ref, sizeof(ref));
+        writeFile(path, bytes);
+
+        if (!rejects(path, load)) {
+            std::cerr << "loadDungeon accepts a truncated " << cut.fName << std::endl;
+            ++failures;
+        }
+        if (!rejects(path, loadPaged)) {
+            std::cerr << "loadPagedDungeon accepts a truncated " << cut.fName << std::endl;
+            ++failures;
+        }
+    }
+
+    std::remove(path.c_str());
+    std::cout << "Truncated entity texts: " << (failures == 0 ? "rejected" : "NOT rejected") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
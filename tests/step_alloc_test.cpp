@@ -0,0 +1,120 @@
+/**
+ * Checks that GameSession::step() does not allocate without a living world
+ * (see GameSession): every heap allocation is counted by a replaced
+ * operator new, and each step that changed at most
+ * SessionState::kReservedEntities entities and collected no new item must
+ * make none. Played on the temple with the test script and on generated
+ * dungeons with random input. Usage: step_alloc_test [script]
+ */
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include "Dungeon.h"
+#include "DungeonGenerator.h"
+#include "GameSession.h"
+#include "MenuScript.h"
+#include "Player.h"
+#include "TempleDungeon.h"
+
+static std::atomic<size_t> gAllocations{0};
+
+// Out of line so GCC does not pair the free() with an inlined operator new
+__attribute__((noinline)) static void release(void* aMemory) {
+    std::free(aMemory);
+}
+
+void* operator new(size_t aSize) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(aSize ? aSize : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t aSize) {
+    return operator new(aSize);
+}
+
+void operator delete(void* aMemory) noexcept {
+    release(aMemory);
+}
+
+void operator delete[](void* aMemory) noexcept {
+    release(aMemory);
+}
+
+void operator delete(void* aMemory, size_t) noexcept {
+    release(aMemory);
+}
+
+void operator delete[](void* aMemory, size_t) noexcept {
+    release(aMemory);
+}
+
+// Steps checked and steps that allocated when they should not have
+struct Tally {
+    size_t fSteps = 0;
+    size_t fFailures = 0;
+};
+
+// Take one step and count it against the rule
+static void checkedStep(GameSession& aSession, int aInput, Tally& aTally, const char* aName) {
+    size_t distinctItems = aSession.getState().getPlayer().getInventory().getDistinctCount();
+    size_t before = gAllocations.load();
+    GameSession::Events events = aSession.step(aInput);
+    size_t allocations = gAllocations.load() - before;
+
+    const SessionState& state = aSession.getState();
+    bool newItem = state.getPlayer().getInventory().getDistinctCount() != distinctItems;
+    if (newItem || state.getChangedEntities().size() > SessionState::kReservedEntities) {
+        return;
+    }
+    ++aTally.fSteps;
+    if (allocations != 0) {
+        ++aTally.fFailures;
+        std::cerr << aName << ": step(" << aInput << ") made " << allocations << " allocation(s), first event "
+                  << static_cast<int>(events[0].fType) << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string scriptPath = argc > 1 ? argv[1] : "test_input.txt";
+    std::ifstream scriptFile(scriptPath);
+    if (!scriptFile) {
+        std::cerr << "Cannot open script: " << scriptPath << std::endl;
+        return 1;
+    }
+    MenuScript script = MenuScript::load(scriptFile);
+    Tally tally;
+
+    Dungeon temple = buildDungeon();
+    GameSession session(temple, Player("Adventurer", 100, 25));
+    session.start();
+    for (int input : script.getInputs()) {
+        if (session.isOver()) break;
+        checkedStep(session, input, tally, "temple");
+    }
+
+    // Random menu input: mostly interactions, so many entities change
+    std::mt19937 random(7);
+    for (uint64_t seed = 1; seed <= 8; ++seed) {
+        GeneratorConfig config;
+        config.fSeed = seed;
+        config.fDepth = 5;
+        Dungeon dungeon = DungeonGenerator(config).generate();
+        GameSession played(dungeon, Player("Adventurer", 1000000, 25));
+        played.start();
+        for (size_t step = 0; step < 4000 && !played.isOver(); ++step) {
+            int input = 1 + static_cast<int>(random() % 3);
+            if (played.getPhase() == GameSession::Phase::MainMenu && input == 3) input = 1;
+            checkedStep(played, input, tally, "generated");
+        }
+    }
+
+    std::cout << "Steps checked: " << tally.fSteps << ", allocating: " << tally.fFailures << std::endl;
+    return tally.fFailures == 0 && tally.fSteps > 0 ? 0 : 1;
+}